@@ -0,0 +1,306 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#include "analysis.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+
+#include "bytecode.h"
+#include "debuginfo.h"
+#include "linker.h"
+
+namespace lvm
+{
+    using namespace bytecode;
+
+    // Operands of the instruction at code, registers and immediates alike; at most five with THREAD_CONTROL's extra
+    // registers
+    uint64_t readInstructionOperands(const uint8_t* code, const uint64_t size, uint64_t* operands)
+    {
+        const std::string_view layout = getInstructionLayout(code[0]);
+        uint64_t count = 0;
+        uint64_t position = 1;
+        for (const char operand : layout)
+        {
+            const uint64_t width = getOperandLength(std::string_view(&operand, 1));
+            if (width == 0) continue;
+            operands[count] = 0;
+            memcpy(&operands[count++], code + position, width);
+            position += width;
+        }
+        for (; position < size; ++position) operands[count++] = code[position];
+        return count;
+    }
+
+    // The register an instruction jumps or calls through, REGISTER_COUNT for every other instruction
+    uint64_t getBranchRegister(const uint8_t code, const uint64_t* operands)
+    {
+        switch (code)
+        {
+        case JUMP:
+        case JE:
+        case JNE:
+        case JL:
+        case JLE:
+        case JG:
+        case JGE:
+        case JUL:
+        case JULE:
+        case JUG:
+        case JUGE:
+        case INVOKE:
+            return operands[0];
+        case JUMP_IF_TRUE:
+        case JUMP_IF_FALSE:
+            return operands[1];
+        case JUMP_IF:
+            return operands[4];
+        default:
+            return REGISTER_COUNT;
+        }
+    }
+
+    bool isBlockEnd(const uint8_t code)
+    {
+        switch (code)
+        {
+        case JUMP:
+        case JUMP_IMMEDIATE:
+        case JE:
+        case JNE:
+        case JL:
+        case JLE:
+        case JG:
+        case JGE:
+        case JUL:
+        case JULE:
+        case JUG:
+        case JUGE:
+        case JUMP_IF_TRUE:
+        case JUMP_IF_FALSE:
+        case JUMP_IF:
+        case INVOKE:
+        case INVOKE_IMMEDIATE:
+        case RETURN:
+        case INTERRUPT_RETURN:
+        case EXIT:
+        case EXIT_IMMEDIATE:
+        case THREAD_FINISH:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    ControlFlowGraph::ControlFlowGraph(const Module* module)
+    {
+        const uint8_t* text = module->text;
+        const uint64_t length = module->textLength;
+        for (uint64_t offset = 0; offset < length;)
+        {
+            const uint64_t size = getInstructionLength(text, length, offset);
+            if (size != 0) instructions.insert(offset);
+            offset += size == 0 ? 1 : size;
+        }
+        std::set<uint64_t> importSites;
+        if (module->linkInfo != nullptr)
+        {
+            for (const Import& symbol : module->linkInfo->imports)
+                importSites.insert(symbol.sites.begin(), symbol.sites.end());
+        }
+        const auto addEntry = [&](const uint64_t address)
+        {
+            if (instructions.contains(address)) entries.insert(address);
+        };
+
+        std::set<uint64_t> starts;
+        if (!instructions.empty()) starts.insert(*instructions.begin());
+        starts.insert(module->entryPoint);
+        if (module->linkInfo != nullptr)
+        {
+            for (const Export& symbol : module->linkInfo->exports) starts.insert(symbol.address);
+            // Relocated values are addresses in the module, in text as immediates or in rodata and data as tables
+            for (const uint64_t site : module->linkInfo->relocations)
+            {
+                const uint64_t rodataStart = length;
+                const uint64_t dataStart = rodataStart + module->rodataLength;
+                uint64_t value;
+                if (site + 8 <= rodataStart) memcpy(&value, text + site, sizeof(value));
+                else if (site >= rodataStart && site + 8 <= dataStart)
+                    memcpy(&value, module->rodata + (site - rodataStart), sizeof(value));
+                else if (site >= dataStart && site + 8 <= dataStart + module->dataLength)
+                    memcpy(&value, module->data + (site - dataStart), sizeof(value));
+                else continue;
+                addEntry(value);
+            }
+        }
+        if (module->debugInfo != nullptr)
+        {
+            for (const Symbol& symbol : module->debugInfo->symbols) starts.insert(symbol.address);
+        }
+        for (const uint64_t offset : instructions)
+        {
+            const uint8_t code = text[offset];
+            const uint64_t next = offset + getInstructionLength(text, length, offset);
+            uint64_t value;
+            if ((code == JUMP_IMMEDIATE || code == INVOKE_IMMEDIATE || code == MOV_IMMEDIATE8) &&
+                !importSites.contains(offset + 1))
+            {
+                memcpy(&value, text + offset + 1, sizeof(value));
+                addEntry(value);
+                if (code == INVOKE_IMMEDIATE) starts.insert(value);
+            }
+            if (code == CREATE_FRAME) starts.insert(offset);
+            if (code == INVOKE || code == INVOKE_IMMEDIATE) addEntry(next);
+        }
+        std::erase_if(starts, [&](const uint64_t start) { return !instructions.contains(start); });
+        entries.insert(starts.begin(), starts.end());
+
+        // Calls by the block they end, ~0 for a target that is not known
+        std::map<uint64_t, uint64_t> calls;
+        BasicBlock* block = nullptr;
+        std::map<uint64_t, uint64_t> known;
+        for (auto instruction = instructions.begin(); instruction != instructions.end(); ++instruction)
+        {
+            const uint64_t offset = *instruction;
+            const uint8_t code = text[offset];
+            const uint64_t size = getInstructionLength(text, length, offset);
+            const uint64_t next = offset + size;
+            if (block == nullptr || entries.contains(offset))
+            {
+                if (block != nullptr) block->successors.push_back(offset);
+                block = &blocks[offset];
+                block->start = offset;
+                known.clear();
+            }
+            block->end = next;
+
+            uint64_t operands[8];
+            const uint64_t count = readInstructionOperands(text + offset, size, operands);
+            const uint64_t branchRegister = getBranchRegister(code, operands);
+            if (code == MOV_IMMEDIATE8)
+            {
+                if (importSites.contains(offset + 1)) known.erase(operands[1]);
+                else known[operands[1]] = operands[0];
+            }
+            else if (code == SYSCALL || code == INVOKE_NATIVE || code == INTERRUPT || code == THREAD_CONTROL)
+            {
+                known.clear();
+            }
+            else if (branchRegister == REGISTER_COUNT)
+            {
+                // Whether an operand is read or written, the register is no longer known to hold the value
+                const std::string_view layout = getInstructionLayout(code);
+                for (uint64_t i = 0; i < count && i < layout.size(); ++i)
+                    if (layout[i] == 'r') known.erase(operands[i]);
+            }
+
+            if (isBlockEnd(code))
+            {
+                uint64_t target = ~0ULL;
+                if (code == JUMP_IMMEDIATE || code == INVOKE_IMMEDIATE)
+                {
+                    if (!importSites.contains(offset + 1)) target = operands[0];
+                }
+                else if (const auto value = known.find(branchRegister); value != known.end())
+                {
+                    target = value->second;
+                }
+                const bool call = code == INVOKE || code == INVOKE_IMMEDIATE;
+                const bool conditional = code != JUMP && code != JUMP_IMMEDIATE && !call &&
+                    branchRegister != REGISTER_COUNT;
+                if (call)
+                {
+                    calls[block->start] = target;
+                    if (target != ~0ULL && instructions.contains(target)) starts.insert(target);
+                }
+                else if (branchRegister != REGISTER_COUNT || code == JUMP_IMMEDIATE)
+                {
+                    if (target != ~0ULL && instructions.contains(target)) block->successors.push_back(target);
+                    else block->indirect = true;
+                }
+                if ((call || conditional) && instructions.contains(next) &&
+                    std::ranges::find(block->successors, next) == block->successors.end())
+                    block->successors.push_back(next);
+                block = nullptr;
+            }
+            else if (std::next(instruction) == instructions.end() || *std::next(instruction) != next)
+            {
+                // Undecodable bytes follow
+                block = nullptr;
+            }
+        }
+
+        for (auto start = starts.begin(); start != starts.end(); ++start)
+        {
+            Function& function = functions[*start];
+            function.start = *start;
+            function.end = std::next(start) == starts.end() ? length : *std::next(start);
+            for (auto entry = blocks.lower_bound(function.start);
+                 entry != blocks.end() && entry->first < function.end; ++entry)
+            {
+                function.blocks.push_back(entry->first);
+                if (const auto call = calls.find(entry->first); call == calls.end()) continue;
+                else if (instructions.contains(call->second)) function.callees.insert(call->second);
+                else function.indirectCalls = true;
+            }
+        }
+    }
+
+    const BasicBlock* ControlFlowGraph::findBlock(const uint64_t address) const
+    {
+        const auto next = blocks.upper_bound(address);
+        if (next == blocks.begin()) return nullptr;
+        const BasicBlock& block = std::prev(next)->second;
+        return address < block.end ? &block : nullptr;
+    }
+
+    const Function* ControlFlowGraph::findFunction(const uint64_t address) const
+    {
+        const auto next = functions.upper_bound(address);
+        if (next == functions.begin()) return nullptr;
+        const Function& function = std::prev(next)->second;
+        return address < function.end ? &function : nullptr;
+    }
+
+    std::string ControlFlowGraph::toString() const
+    {
+        std::string out;
+        char buffer[64];
+        const auto address = [&](const uint64_t value)
+        {
+            snprintf(buffer, sizeof(buffer), "0x%llx", static_cast<unsigned long long>(value));
+            return std::string(buffer);
+        };
+        for (const auto& [start, function] : functions)
+        {
+            out += "function " + address(start) + " .. " + address(function.end);
+            std::string separator = " calls ";
+            for (const uint64_t callee : function.callees)
+            {
+                out += separator + address(callee);
+                separator = ", ";
+            }
+            if (function.indirectCalls) out += separator + "indirect";
+            out += "\n";
+            for (const uint64_t blockStart : function.blocks)
+            {
+                const BasicBlock& block = blocks.at(blockStart);
+                out += "    block " + address(block.start) + " .. " + address(block.end);
+                separator = " -> ";
+                for (const uint64_t successor : block.successors)
+                {
+                    out += separator + address(successor);
+                    separator = ", ";
+                }
+                if (block.indirect) out += separator + "indirect";
+                out += "\n";
+            }
+        }
+        return out;
+    }
+}
@@ -0,0 +1,66 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "module.h"
+
+namespace lvm
+{
+    // Whether the instruction with opcode code ends a basic block: jumps, calls, returns and exits
+    bool isBlockEnd(uint8_t code);
+
+    // Instructions that are only entered at the first and only left after the last
+    class BasicBlock
+    {
+    public:
+        uint64_t start = 0;
+        uint64_t end = 0;
+        // Both ways of a conditional branch and the return address of a call, in that order. Targets of jumps through
+        // registers are only known when the block itself puts an address in the register, otherwise indirect is set
+        std::vector<uint64_t> successors;
+        bool indirect = false;
+    };
+
+    class Function
+    {
+    public:
+        uint64_t start = 0;
+        // Functions are the text from their start to the start of the next one
+        uint64_t end = 0;
+        std::vector<uint64_t> blocks;
+        // Functions called with a known address; calls through registers with an unknown value and calls of imports
+        // set indirectCalls
+        std::set<uint64_t> callees;
+        bool indirectCalls = false;
+    };
+
+    // Static control flow of the text of an unpacked module, in module offsets.
+    //
+    // Functions start at the first instruction, the entry point, exports, function symbols, immediate call targets
+    // and CREATE_FRAME. Blocks start at function starts, after every branch, call and return, and at entries: every
+    // address control can arrive at other than from the instruction before it, which are branch and call targets,
+    // return addresses, and addresses written into code or data as values.
+    class ControlFlowGraph
+    {
+    public:
+        std::set<uint64_t> instructions;
+        std::set<uint64_t> entries;
+        std::map<uint64_t, BasicBlock> blocks;
+        std::map<uint64_t, Function> functions;
+
+        explicit ControlFlowGraph(const Module* module);
+        [[nodiscard]] const BasicBlock* findBlock(uint64_t address) const;
+        [[nodiscard]] const Function* findFunction(uint64_t address) const;
+        // Functions with their blocks, successors and callees, as lvm-dis --cfg prints them
+        [[nodiscard]] std::string toString() const;
+    };
+}
+#endif //ANALYSIS_H
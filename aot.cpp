@@ -0,0 +1,722 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#include "aot.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <map>
+#include <set>
+#include <sstream>
+#include <vector>
+
+#include "analysis.h"
+#include "bytecode.h"
+#include "debuginfo.h"
+#include "hash.h"
+#include "linker.h"
+#include "module.h"
+#include "native.h"
+#include "vm.h"
+
+namespace lvm
+{
+    using namespace bytecode;
+
+    // Layout of the lvm_aot_entries table of a compiled module
+    class AotEntry
+    {
+    public:
+        uint64_t address;
+        CompiledCode code;
+    };
+
+    // Guest memory is accessed unaligned and may alias anything, floats live in the low half of a register
+    constexpr const char* AOT_PRELUDE = R"(#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef uint8_t u8 __attribute__((may_alias));
+typedef uint16_t u16 __attribute__((may_alias, aligned(1)));
+typedef uint32_t u32 __attribute__((may_alias, aligned(1)));
+typedef uint64_t u64 __attribute__((may_alias, aligned(1)));
+#define M(type, address) (*(type*)(base + ((address) & mask)))
+
+static inline float F(uint64_t value) { uint32_t bits = (uint32_t)value; float f; memcpy(&f, &bits, 4); return f; }
+static inline uint64_t FB(float f) { uint32_t bits; memcpy(&bits, &f, 4); return bits; }
+static inline double D(uint64_t value) { double d; memcpy(&d, &value, 8); return d; }
+static inline uint64_t DB(double d) { uint64_t bits; memcpy(&bits, &d, 8); return bits; }
+
+)";
+
+    // Conditions of MOV_E ... MOV_UGE and JE ... JUGE on the flags in r40, in opcode order
+    constexpr const char* FLAG_CONDITIONS[] = {
+        "(r40 & 1) != 0", "(r40 & 1) == 0", "(r40 & 3) == 2", "(r40 & 3) != 0", "(r40 & 3) == 0", "(r40 & 3) != 2",
+        "(r40 & 5) == 4", "(r40 & 5) != 0", "(r40 & 5) == 0", "(r40 & 5) != 4"
+    };
+
+    std::string cHex(const uint64_t value)
+    {
+        char buffer[24];
+        snprintf(buffer, sizeof(buffer), "0x%llx", static_cast<unsigned long long>(value));
+        return buffer;
+    }
+
+    std::string cLiteral(const uint64_t value)
+    {
+        return cHex(value) + "ULL";
+    }
+
+    std::string cName(const char* prefix, const uint64_t address)
+    {
+        char buffer[24];
+        snprintf(buffer, sizeof(buffer), "%s_%llx", prefix, static_cast<unsigned long long>(address));
+        return buffer;
+    }
+
+    const char* cMemoryType(const uint64_t size)
+    {
+        switch (size)
+        {
+        case 1:
+            return "u8";
+        case 2:
+            return "u16";
+        case 4:
+            return "u32";
+        case 8:
+            return "u64";
+        default:
+            return nullptr;
+        }
+    }
+
+    // Translates the instructions of one function. registers[] is brought up to date with the locals at every label,
+    // before every guest memory access and on every way out, so the interpreter, and a fault delivered to the guest,
+    // see the state the interpreter would have had.
+    class FunctionTranslator
+    {
+    public:
+        FunctionTranslator(const Module* module, const std::map<uint64_t, uint64_t>& owners,
+                           const std::set<uint64_t>& importSites, const uint64_t start, const uint64_t end)
+            : module(module), owners(owners), importSites(importSites), start(start), end(end)
+        {
+        }
+
+        std::string translate()
+        {
+            for (uint64_t offset = start; offset < end;)
+            {
+                if (isLabel(offset))
+                {
+                    flush();
+                    body << cName("L", offset) << ":\n";
+                }
+                const uint64_t size = getInstructionLength(module->text, module->textLength, offset);
+                if (size == 0)
+                {
+                    leave(cLiteral(offset));
+                    ++offset;
+                    continue;
+                }
+                body << "    /* " << cHex(offset) << " " << getInstructionName(module->text[offset]) << " */\n";
+                translateInstruction(offset, offset + size);
+                offset += size;
+            }
+            leave(cLiteral(end));
+
+            std::ostringstream function;
+            function << "#define RELOAD";
+            for (const uint8_t reg : used) function << " r" << +reg << " = registers[" << +reg << "];";
+            function << "\nstatic void " << cName("f", start) << "(uint64_t* registers, const uint64_t base, "
+                "const uint64_t mask, const unsigned depth)\n{\n";
+            for (const uint8_t reg : used) function << "    uint64_t r" << +reg << " = registers[" << +reg << "];\n";
+            function << "    uint64_t target = registers[" << +PC_REGISTER << "];\njump:\n    switch (target)\n    {\n";
+            for (auto label = owners.lower_bound(start); label != owners.end() && label->first < end; ++label)
+                function << "    case " << cLiteral(label->first) << ": goto " << cName("L", label->first) << ";\n";
+            function << "    }\n    registers[" << +PC_REGISTER << "] = target;\n    return;\n" << body.str()
+                << "}\n#undef RELOAD\n\n";
+            return function.str();
+        }
+
+    private:
+        const Module* module;
+        // Every label, mapped to the start of the function it is in
+        const std::map<uint64_t, uint64_t>& owners;
+        const std::set<uint64_t>& importSites;
+        const uint64_t start;
+        const uint64_t end;
+        std::ostringstream body;
+        // Registers the function reads or writes, and those written since registers[] was last brought up to date
+        std::set<uint8_t> used;
+        std::set<uint8_t> dirty;
+
+        [[nodiscard]] bool isLabel(const uint64_t address) const
+        {
+            return owners.contains(address) && owners.at(address) == start;
+        }
+
+        std::string read(const uint8_t reg)
+        {
+            used.insert(reg);
+            return "r" + std::to_string(reg);
+        }
+
+        std::string write(const uint8_t reg)
+        {
+            dirty.insert(reg);
+            return read(reg);
+        }
+
+        void line(const std::string& statement)
+        {
+            body << "    " << statement << "\n";
+        }
+
+        [[nodiscard]] std::string stores() const
+        {
+            std::string statements;
+            for (const uint8_t reg : dirty)
+                statements += "registers[" + std::to_string(reg) + "] = r" + std::to_string(reg) + ";" +
+                    (reg == *dirty.rbegin() ? "" : " ");
+            return statements;
+        }
+
+        void flush()
+        {
+            if (!dirty.empty()) line(stores());
+            dirty.clear();
+        }
+
+        // Back to the interpreter at pc
+        void leave(const std::string& pc)
+        {
+            flush();
+            line("registers[" + std::to_string(PC_REGISTER) + "] = " + pc + "; return;");
+        }
+
+        // A fault in the access that follows is delivered with the return address the interpreter would push
+        void beforeAccess(const uint64_t next)
+        {
+            flush();
+            line("registers[" + std::to_string(PC_REGISTER) + "] = " + cLiteral(next) + ";");
+        }
+
+        void jump(const uint64_t target)
+        {
+            if (isLabel(target)) line("goto " + cName("L", target) + ";");
+            else leave(cLiteral(target));
+        }
+
+        // An 8 byte immediate at address, read from the loaded text if the linker patches it
+        [[nodiscard]] std::string immediate(const uint64_t address) const
+        {
+            if (importSites.contains(address)) return "M(u64, " + cLiteral(address) + ")";
+            uint64_t value;
+            memcpy(&value, module->text + address, sizeof(value));
+            return cLiteral(value);
+        }
+
+        void invoke(const std::string& target, const bool known, const uint64_t address, const uint64_t next)
+        {
+            line(write(SP_REGISTER) + " -= 8;");
+            beforeAccess(next);
+            line("M(u64, r" + std::to_string(SP_REGISTER) + ") = " + cLiteral(next) + ";");
+            line("registers[" + std::to_string(PC_REGISTER) + "] = " + target + ";");
+            std::string callee = "call";
+            if (known)
+            {
+                if (!owners.contains(address))
+                {
+                    line("return;");
+                    return;
+                }
+                callee = cName("f", owners.at(address));
+            }
+            // Unless the callee returned here, the interpreter carries on wherever it left off
+            line("if (depth < " + std::to_string(AOT_MAX_CALL_DEPTH) + ")");
+            line("{");
+            line("    " + callee + "(registers, base, mask, depth + 1);");
+            if (isLabel(next))
+            {
+                line("    RELOAD");
+                line("    if (registers[" + std::to_string(PC_REGISTER) + "] == " + cLiteral(next) + ") goto " +
+                    cName("L", next) + ";");
+            }
+            line("}");
+            line("return;");
+        }
+
+        void translateInstruction(const uint64_t offset, const uint64_t next)
+        {
+            const uint8_t code = module->text[offset];
+            const uint8_t* operands = module->text + offset + 1;
+            const std::string_view layout = getInstructionLayout(code);
+            // The program counter is not a local, and an instruction naming it is left to the interpreter
+            uint64_t position = 0;
+            for (const char operand : layout)
+            {
+                if (operand == 'r' && (operands[position] >= REGISTER_COUNT || operands[position] == PC_REGISTER))
+                {
+                    leave(cLiteral(offset));
+                    return;
+                }
+                position += getOperandLength(std::string_view(&operand, 1));
+            }
+            const std::string sp = "r" + std::to_string(SP_REGISTER);
+            const std::string bp = "r" + std::to_string(BP_REGISTER);
+            const std::string flags = "r" + std::to_string(FLAGS_REGISTER);
+            switch (code)
+            {
+            case NOP:
+                break;
+            case PUSH_1:
+            case PUSH_2:
+            case PUSH_4:
+            case PUSH_8:
+                line(write(SP_REGISTER) + " -= " + std::to_string(1 << (code - PUSH_1)) + ";");
+                beforeAccess(next);
+                line(std::string("M(") + cMemoryType(1 << (code - PUSH_1)) + ", " + sp + ") = " +
+                    read(operands[0]) + ";");
+                break;
+            case POP_1:
+            case POP_2:
+            case POP_4:
+            case POP_8:
+                beforeAccess(next);
+                line(write(operands[0]) + " = M(" + cMemoryType(1 << (code - POP_1)) + ", " + read(SP_REGISTER) +
+                    ");");
+                line(write(SP_REGISTER) + " += " + std::to_string(1 << (code - POP_1)) + ";");
+                break;
+            case LOAD_1:
+            case LOAD_2:
+            case LOAD_4:
+            case LOAD_8:
+                beforeAccess(next);
+                line(write(operands[1]) + " = M(" + cMemoryType(1 << (code - LOAD_1)) + ", " + read(operands[0]) +
+                    ");");
+                break;
+            case STORE_1:
+            case STORE_2:
+            case STORE_4:
+            case STORE_8:
+                beforeAccess(next);
+                line(std::string("M(") + cMemoryType(1 << (code - STORE_1)) + ", " + read(operands[0]) + ") = " +
+                    read(operands[1]) + ";");
+                break;
+            case CMP:
+                {
+                    if (operands[0] > DOUBLE_TYPE)
+                    {
+                        leave(cLiteral(offset));
+                        break;
+                    }
+                    const std::string a = read(operands[1]);
+                    const std::string b = read(operands[2]);
+                    const std::string cleared = write(FLAGS_REGISTER) + " = (" + flags + " & ~7ULL)";
+                    if (operands[0] == FLOAT_TYPE || operands[0] == DOUBLE_TYPE)
+                    {
+                        const std::string view = operands[0] == FLOAT_TYPE ? "F" : "D";
+                        line(cleared + " | (" + view + "(" + a + ") < " + view + "(" + b + ") ? 6 : 0) | (" + a +
+                            " == " + b + " ? 1 : 0);");
+                        break;
+                    }
+                    const char* types[] = {"int8_t", "int16_t", "int32_t", "int64_t"};
+                    line(std::string("{ const int64_t a = (") + types[operands[0]] + ")" + a + ", b = (" +
+                        types[operands[0]] + ")" + b + ";");
+                    line("  " + cleared + " | (a == b ? 1 : (a < b ? 2 : 0) | ((uint64_t)a < (uint64_t)b ? 4 : 0)); }");
+                    break;
+                }
+            case MOV_E:
+            case MOV_NE:
+            case MOV_L:
+            case MOV_LE:
+            case MOV_G:
+            case MOV_GE:
+            case MOV_UL:
+            case MOV_ULE:
+            case MOV_UG:
+            case MOV_UGE:
+                read(FLAGS_REGISTER);
+                line(std::string("if (") + FLAG_CONDITIONS[code - MOV_E] + ") " + write(operands[1]) + " = " +
+                    read(operands[0]) + ";");
+                break;
+            case MOV:
+                line(write(operands[1]) + " = " + read(operands[0]) + ";");
+                break;
+            case MOV_IMMEDIATE1:
+                line(write(operands[1]) + " = " + cLiteral(operands[0]) + ";");
+                break;
+            case MOV_IMMEDIATE2:
+                {
+                    uint16_t value;
+                    memcpy(&value, operands, sizeof(value));
+                    line(write(operands[2]) + " = " + cLiteral(value) + ";");
+                    break;
+                }
+            case MOV_IMMEDIATE4:
+                {
+                    uint32_t value;
+                    memcpy(&value, operands, sizeof(value));
+                    line(write(operands[4]) + " = " + cLiteral(value) + ";");
+                    break;
+                }
+            case MOV_IMMEDIATE8:
+                line(write(operands[8]) + " = " + immediate(offset + 1) + ";");
+                break;
+            case JUMP:
+                flush();
+                line("target = " + read(operands[0]) + "; goto jump;");
+                break;
+            case JUMP_IMMEDIATE:
+                flush();
+                if (importSites.contains(offset + 1))
+                {
+                    line("target = " + immediate(offset + 1) + "; goto jump;");
+                    break;
+                }
+                {
+                    uint64_t target;
+                    memcpy(&target, operands, sizeof(target));
+                    jump(target);
+                }
+                break;
+            case JE:
+            case JNE:
+            case JL:
+            case JLE:
+            case JG:
+            case JGE:
+            case JUL:
+            case JULE:
+            case JUG:
+            case JUGE:
+                flush();
+                read(FLAGS_REGISTER);
+                line(std::string("if (") + FLAG_CONDITIONS[code - JE] + ") { target = " + read(operands[0]) +
+                    "; goto jump; }");
+                break;
+            case ADD:
+            case SUB:
+            case MUL:
+            case AND:
+            case OR:
+            case XOR:
+                {
+                    const char* operators[] = {"+", "-", "*", nullptr, nullptr, "&", "|", "^"};
+                    line(write(operands[2]) + " = " + read(operands[0]) + " " + operators[code - ADD] + " " +
+                        read(operands[1]) + ";");
+                    break;
+                }
+            case DIV:
+            case MOD:
+                // Dividing by zero is left to the interpreter, which raises INTERRUPT_DIVIDE_BY_ZERO
+                line("if (" + read(operands[1]) + " == 0) { " + stores() + " registers[" +
+                    std::to_string(PC_REGISTER) + "] = " + cLiteral(offset) + "; return; }");
+                line(write(operands[2]) + " = " + read(operands[0]) + (code == DIV ? " / " : " % ") +
+                    read(operands[1]) + ";");
+                break;
+            case NOT:
+                line(write(operands[1]) + " = ~" + read(operands[0]) + ";");
+                break;
+            case NEG:
+                line(write(operands[1]) + " = 0 - " + read(operands[0]) + ";");
+                break;
+            // Shift counts wrap at 64 as they do in the interpreter on x86-64 and AArch64
+            case SHL:
+                line(write(operands[2]) + " = " + read(operands[0]) + " << (" + read(operands[1]) + " & 63);");
+                break;
+            case SHR:
+                line(write(operands[2]) + " = (uint64_t)((int64_t)" + read(operands[0]) + " >> (" +
+                    read(operands[1]) + " & 63));");
+                break;
+            case USHR:
+                line(write(operands[2]) + " = " + read(operands[0]) + " >> (" + read(operands[1]) + " & 63);");
+                break;
+            case INC:
+                line("++" + write(operands[0]) + ";");
+                break;
+            case DEC:
+                line("--" + write(operands[0]) + ";");
+                break;
+            case ADD_DOUBLE:
+            case SUB_DOUBLE:
+            case MUL_DOUBLE:
+            case DIV_DOUBLE:
+            case ADD_FLOAT:
+            case SUB_FLOAT:
+            case MUL_FLOAT:
+            case DIV_FLOAT:
+                {
+                    const char* operators[] = {"+", "-", "*", "/"};
+                    const bool isDouble = code <= DIV_DOUBLE;
+                    const std::string view = isDouble ? "D" : "F";
+                    line(write(operands[2]) + " = " + view + "B(" + view + "(" + read(operands[0]) + ") " +
+                        operators[code - (isDouble ? ADD_DOUBLE : ADD_FLOAT)] + " " + view + "(" +
+                        read(operands[1]) + "));");
+                    break;
+                }
+            case MOD_DOUBLE:
+                line(write(operands[2]) + " = DB(fmod(D(" + read(operands[0]) + "), D(" + read(operands[1]) +
+                    ")));");
+                break;
+            case MOD_FLOAT:
+                line(write(operands[2]) + " = FB(fmodf(F(" + read(operands[0]) + "), F(" + read(operands[1]) +
+                    ")));");
+                break;
+            case NEG_DOUBLE:
+                line(write(operands[0]) + " = DB(-D(" + read(operands[0]) + "));");
+                break;
+            case NEG_FLOAT:
+                line(write(operands[0]) + " = FB(-F(" + read(operands[0]) + "));");
+                break;
+            case LONG_TO_DOUBLE:
+                line(write(operands[1]) + " = DB((double)(int64_t)" + read(operands[0]) + ");");
+                break;
+            case DOUBLE_TO_LONG:
+                line(write(operands[1]) + " = (uint64_t)(int64_t)D(" + read(operands[0]) + ");");
+                break;
+            case DOUBLE_TO_FLOAT:
+                line(write(operands[1]) + " = FB((float)D(" + read(operands[0]) + "));");
+                break;
+            case FLOAT_TO_DOUBLE:
+                line(write(operands[1]) + " = DB((double)F(" + read(operands[0]) + "));");
+                break;
+            case INVOKE:
+                invoke(read(operands[0]), false, 0, next);
+                break;
+            case INVOKE_IMMEDIATE:
+                {
+                    uint64_t target;
+                    memcpy(&target, operands, sizeof(target));
+                    const bool known = !importSites.contains(offset + 1);
+                    invoke(immediate(offset + 1), known, target, next);
+                    break;
+                }
+            case RETURN:
+                beforeAccess(next);
+                line("target = M(u64, " + read(SP_REGISTER) + ");");
+                line(write(SP_REGISTER) + " += 8;");
+                flush();
+                line("registers[" + std::to_string(PC_REGISTER) + "] = target; return;");
+                break;
+            case CREATE_FRAME:
+                {
+                    // Frames up to the guard size run into the guard pages, the interpreter checks larger ones
+                    // against the bottom of the thread's stack
+                    uint64_t size;
+                    memcpy(&size, module->text + offset + 1, sizeof(size));
+                    if (size > DEFAULT_STACK_GUARD_SIZE)
+                    {
+                        leave(cLiteral(offset));
+                        break;
+                    }
+                    line(write(SP_REGISTER) + " -= 8;");
+                    beforeAccess(next);
+                    line("M(u64, " + sp + ") = " + read(BP_REGISTER) + ";");
+                    line(write(BP_REGISTER) + " = " + sp + ";");
+                    line(write(SP_REGISTER) + " -= " + immediate(offset + 1) + ";");
+                    break;
+                }
+            case DESTROY_FRAME:
+                line(write(SP_REGISTER) + " += " + immediate(offset + 1) + ";");
+                beforeAccess(next);
+                line(write(BP_REGISTER) + " = M(u64, " + sp + ");");
+                line(write(SP_REGISTER) + " += 8;");
+                break;
+            case GET_FIELD_ADDRESS:
+                line(write(operands[9]) + " = " + read(operands[0]) + " + " + immediate(offset + 2) + ";");
+                break;
+            case GET_LOCAL_ADDRESS:
+                line(write(operands[8]) + " = " + read(BP_REGISTER) + " - " + immediate(offset + 1) + ";");
+                break;
+            case GET_PARAMETER_ADDRESS:
+                line(write(operands[8]) + " = " + read(BP_REGISTER) + " + " + immediate(offset + 1) + ";");
+                break;
+            case LOAD_FIELD:
+            case STORE_FIELD:
+            case LOAD_LOCAL:
+            case STORE_LOCAL:
+            case LOAD_PARAMETER:
+            case STORE_PARAMETER:
+                {
+                    const char* type = cMemoryType(operands[0]);
+                    if (type == nullptr)
+                    {
+                        leave(cLiteral(offset));
+                        break;
+                    }
+                    const bool field = code == LOAD_FIELD || code == STORE_FIELD;
+                    const uint8_t reg = operands[field ? 10 : 9];
+                    std::string address;
+                    if (field) address = read(operands[1]) + " + " + immediate(offset + 3);
+                    else address = read(BP_REGISTER) + (code == LOAD_LOCAL || code == STORE_LOCAL ? " - " : " + ") +
+                        immediate(offset + 2);
+                    const std::string memory = std::string("M(") + type + ", " + address + ")";
+                    beforeAccess(next);
+                    if (code == LOAD_FIELD || code == LOAD_LOCAL || code == LOAD_PARAMETER)
+                        line(write(reg) + " = " + memory + ";");
+                    else line(memory + " = " + read(reg) + ";");
+                    break;
+                }
+            case JUMP_IF_TRUE:
+            case JUMP_IF_FALSE:
+                flush();
+                line("if (" + read(operands[0]) + (code == JUMP_IF_TRUE ? " != 0" : " == 0") + ") { target = " +
+                    read(operands[1]) + "; goto jump; }");
+                break;
+            case JUMP_IF:
+                {
+                    const uint8_t type = operands[0];
+                    const uint8_t condition = operands[1];
+                    if (type > DOUBLE_TYPE)
+                    {
+                        leave(cLiteral(offset));
+                        break;
+                    }
+                    flush();
+                    std::string a = read(operands[2]);
+                    std::string b = read(operands[3]);
+                    std::string unsignedA = "(uint64_t)" + a;
+                    std::string unsignedB = "(uint64_t)" + b;
+                    if (type == FLOAT_TYPE || type == DOUBLE_TYPE)
+                    {
+                        const std::string view = type == FLOAT_TYPE ? "F" : "D";
+                        a = unsignedA = view + "(" + a + ")";
+                        b = unsignedB = view + "(" + b + ")";
+                    }
+                    else
+                    {
+                        const char* types[] = {"int8_t", "int16_t", "int32_t", "int64_t"};
+                        a = "(int64_t)(" + std::string(types[type]) + ")" + a;
+                        b = "(int64_t)(" + std::string(types[type]) + ")" + b;
+                        unsignedA = "(uint64_t)" + a;
+                        unsignedB = "(uint64_t)" + b;
+                    }
+                    std::string test = "0";
+                    if ((condition & CONDITION_EQUAL) != 0) test += " || " + a + " == " + b;
+                    if ((condition & CONDITION_NOT_EQUAL) != 0) test += " || " + a + " != " + b;
+                    // CONDITION_UNSIGNED | CONDITION_LESS tests what the interpreter tests
+                    if ((condition & CONDITION_UNSIGNED) != 0)
+                    {
+                        if ((condition & CONDITION_GREATER) != 0) test += " || " + unsignedA + " > " + unsignedB;
+                        if ((condition & CONDITION_LESS) != 0)
+                            test += " || " + unsignedA + (type >= FLOAT_TYPE ? " < " : " > ") + unsignedB;
+                    }
+                    else
+                    {
+                        if ((condition & CONDITION_GREATER) != 0) test += " || " + a + " > " + b;
+                        if ((condition & CONDITION_LESS) != 0) test += " || " + a + " < " + b;
+                    }
+                    line("if (" + test + ") { target = " + read(operands[4]) + "; goto jump; }");
+                    break;
+                }
+            default:
+                leave(cLiteral(offset));
+                break;
+            }
+        }
+    };
+
+    uint64_t getTextHash(const Module* module, const uint8_t* text)
+    {
+        std::vector copy(text, text + module->textLength);
+        if (module->linkInfo != nullptr)
+        {
+            for (const Import& symbol : module->linkInfo->imports)
+                for (const uint64_t site : symbol.sites)
+                    if (site + 8 <= copy.size()) memset(copy.data() + site, 0, 8);
+        }
+        return wyhash(copy.data(), copy.size(), 0);
+    }
+
+    std::string translateModule(const Module* module)
+    {
+        const uint8_t* text = module->text;
+        const uint64_t length = module->textLength;
+        std::set<uint64_t> importSites;
+        if (module->linkInfo != nullptr)
+        {
+            for (const Import& symbol : module->linkInfo->imports)
+                importSites.insert(symbol.sites.begin(), symbol.sites.end());
+        }
+
+        // Labels are the entries of the graph: everywhere control can arrive from elsewhere, which includes the
+        // addresses put in registers for JUMP and INVOKE
+        const ControlFlowGraph graph(module);
+        std::set<uint64_t> starts;
+        for (const auto& [start, function] : graph.functions) starts.insert(start);
+        const std::set<uint64_t>& labels = graph.entries;
+        std::map<uint64_t, uint64_t> owners;
+        for (const uint64_t label : labels) owners[label] = *std::prev(starts.upper_bound(label));
+
+        std::ostringstream source;
+        source << "/* Compiled by lvm-aot from a module with text hash " << cLiteral(getTextHash(module, text))
+            << " */\n" << AOT_PRELUDE;
+        for (const uint64_t start : starts)
+            source << "static void " << cName("f", start) << "(uint64_t*, uint64_t, uint64_t, unsigned);\n";
+        // INVOKE of an address only known at run time
+        source << "\nstatic void call(uint64_t* registers, const uint64_t base, const uint64_t mask, "
+            "const unsigned depth)\n{\n    switch (registers[" << +PC_REGISTER << "])\n    {\n";
+        for (const uint64_t start : starts)
+            source << "    case " << cLiteral(start) << ": " << cName("f", start) << "(registers, base, mask, depth); "
+                "return;\n";
+        source << "    }\n}\n\n";
+        for (auto start = starts.begin(); start != starts.end(); ++start)
+        {
+            const uint64_t end = std::next(start) == starts.end() ? length : *std::next(start);
+            source << FunctionTranslator(module, owners, importSites, *start, end).translate();
+        }
+        for (const uint64_t start : starts)
+            source << "static void " << cName("e", start) << "(uint64_t* registers, uint64_t base, uint64_t mask) { "
+                << cName("f", start) << "(registers, base, mask, 0); }\n";
+        source << "\nconst uint64_t lvm_aot_version = " << AOT_VERSION << ";\nconst uint64_t lvm_aot_hash = "
+            << cLiteral(getTextHash(module, text)) << ";\nconst uint64_t lvm_aot_entry_count = " << owners.size()
+            << ";\nconst struct { uint64_t address; void (*code)(uint64_t*, uint64_t, uint64_t); } lvm_aot_entries[] = "
+            "{\n";
+        for (const auto& [label, owner] : owners)
+            source << "    {" << cLiteral(label) << ", " << cName("e", owner) << "},\n";
+        source << "    {0, 0}\n};\n";
+        return source.str();
+    }
+
+    CompiledCode AotTier::lookup(const uint64_t address)
+    {
+        const auto entry = entries.find(address);
+        return entry == entries.end() ? nullptr : entry->second;
+    }
+
+    AotTier* AotTier::load(const std::string& path, const Module* module, const uint8_t* text, std::string* error)
+    {
+        // Like native libraries, the shared object stays loaded until the process exits. A relative path is taken
+        // from the working directory and not searched for.
+        std::error_code code;
+        const std::filesystem::path absolute = std::filesystem::absolute(path, code);
+        const uint64_t library = loadNativeLibrary(code ? path.c_str() : absolute.string().c_str());
+        if (library == 0)
+        {
+            if (error != nullptr) *error = "Cannot load shared object";
+            return nullptr;
+        }
+        const auto* version = reinterpret_cast<const uint64_t*>(loadNativeSymbol(library, "lvm_aot_version"));
+        const auto* hash = reinterpret_cast<const uint64_t*>(loadNativeSymbol(library, "lvm_aot_hash"));
+        const auto* count = reinterpret_cast<const uint64_t*>(loadNativeSymbol(library, "lvm_aot_entry_count"));
+        const auto* entries = reinterpret_cast<const AotEntry*>(loadNativeSymbol(library, "lvm_aot_entries"));
+        if (version == nullptr || hash == nullptr || count == nullptr || entries == nullptr || *version != AOT_VERSION)
+        {
+            if (error != nullptr) *error = "Not compiled by this version of lvm-aot";
+            return nullptr;
+        }
+        if (*hash != getTextHash(module, text))
+        {
+            if (error != nullptr) *error = "Compiled from a different module";
+            return nullptr;
+        }
+        auto* tier = new AotTier();
+        for (uint64_t i = 0; i < *count; ++i) tier->entries.emplace(entries[i].address, entries[i].code);
+        return tier;
+    }
+}
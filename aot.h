@@ -0,0 +1,45 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#ifndef AOT_H
+#define AOT_H
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "tier.h"
+
+namespace lvm
+{
+    class Module;
+
+    // Checked against the lvm_aot_version a shared object exports, bumped whenever the generated code changes
+    constexpr uint64_t AOT_VERSION = 1;
+    // Calls nested deeper than this in compiled code are left to the interpreter, so that guest recursion runs out of
+    // guest stack and not of host stack
+    constexpr uint64_t AOT_MAX_CALL_DEPTH = 256;
+
+    // What compiled code is keyed by, the wyhash of the unpacked text of the module with its import slots zeroed, as
+    // the linker fills them in at load time
+    uint64_t getTextHash(const Module* module, const uint8_t* text);
+    // C source for the text of an unpacked module, to be built into a shared object for AotTier. Each guest function
+    // becomes one C function with the guest registers in locals and can be entered at any of its labels; whatever it
+    // does not translate (system calls, I/O, threads, atomics) goes back to the interpreter.
+    std::string translateModule(const Module* module);
+
+    // Compiled code of the main module, from a shared object built by lvm-aot
+    class AotTier : public Tier
+    {
+    public:
+        CompiledCode lookup(uint64_t address) override;
+        // For the main module, with text where it was loaded; nullptr, and the reason in error, if the file cannot
+        // be loaded or was compiled from a different module
+        static AotTier* load(const std::string& path, const Module* module, const uint8_t* text,
+                             std::string* error = nullptr);
+
+    private:
+        std::unordered_map<uint64_t, CompiledCode> entries;
+    };
+}
+#endif //AOT_H
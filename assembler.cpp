@@ -0,0 +1,717 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#include "assembler.h"
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "bytecode.h"
+#include "debuginfo.h"
+#include "linker.h"
+
+namespace lvm
+{
+    using namespace bytecode;
+
+    constexpr uint8_t SECTION_TEXT = 0;
+    constexpr uint8_t SECTION_RODATA = 1;
+    constexpr uint8_t SECTION_DATA = 2;
+    constexpr uint8_t SECTION_BSS = 3;
+    constexpr uint64_t BYTES_PER_LINE = 16;
+    // Sections are built in memory, .zero and .align may not grow one past this
+    constexpr uint64_t MAX_SECTION_SIZE = 1ULL << 32;
+
+    const std::map<std::string, uint64_t> NAMED_CONSTANTS = {
+        {"byte", BYTE_TYPE}, {"short", SHORT_TYPE}, {"int", INT_TYPE}, {"long", LONG_TYPE},
+        {"float", FLOAT_TYPE}, {"double", DOUBLE_TYPE}, {"pointer", POINTER_TYPE}, {"void", VOID_TYPE},
+        {"e", CONDITION_EQUAL}, {"ne", CONDITION_NOT_EQUAL}, {"g", CONDITION_GREATER},
+        {"l", CONDITION_LESS}, {"u", CONDITION_UNSIGNED},
+        {"stop", TC_STOP}, {"wait", TC_WAIT}, {"get_register", TC_GET_REGISTER}, {"set_register", TC_SET_REGISTER},
+    };
+
+    const std::map<std::string, uint8_t> NAMED_REGISTERS = {
+        {"rv", RETURN_VALUE_REGISTER}, {"bp", BP_REGISTER}, {"sp", SP_REGISTER}, {"pc", PC_REGISTER},
+        {"flags", FLAGS_REGISTER}, {"idtr", IDTR_REGISTER},
+    };
+
+    class Statement
+    {
+    public:
+        uint64_t line = 0;
+        uint8_t section = SECTION_TEXT;
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        bool instruction = false;
+        uint8_t opcode = 0;
+        std::string layout;
+        std::string directive;
+        std::vector<std::string> operands;
+        std::vector<uint8_t> bytes;
+    };
+
+    [[noreturn]] void fail(const uint64_t line, const std::string& message)
+    {
+        throw std::runtime_error("line " + std::to_string(line) + ": " + message);
+    }
+
+    std::string trim(const std::string_view text)
+    {
+        const auto first = text.find_first_not_of(" \t\r");
+        if (first == std::string_view::npos) return "";
+        const auto last = text.find_last_not_of(" \t\r");
+        return std::string(text.substr(first, last - first + 1));
+    }
+
+    std::string stripComment(const std::string& line)
+    {
+        bool quoted = false;
+        for (uint64_t i = 0; i < line.size(); ++i)
+        {
+            if (line[i] == '\\' && quoted) ++i;
+            else if (line[i] == '"') quoted = !quoted;
+            else if (line[i] == ';' && !quoted) return line.substr(0, i);
+        }
+        return line;
+    }
+
+    std::vector<std::string> splitOperands(const std::string& text)
+    {
+        std::vector<std::string> operands;
+        if (trim(text).empty()) return operands;
+        bool quoted = false;
+        std::string current;
+        for (uint64_t i = 0; i < text.size(); ++i)
+        {
+            if (text[i] == '\\' && quoted && i + 1 < text.size())
+            {
+                current += text[i];
+                current += text[++i];
+                continue;
+            }
+            if (text[i] == '"') quoted = !quoted;
+            if (text[i] == ',' && !quoted)
+            {
+                operands.push_back(trim(current));
+                current.clear();
+                continue;
+            }
+            current += text[i];
+        }
+        operands.push_back(trim(current));
+        return operands;
+    }
+
+    bool isIdentifier(const std::string& text)
+    {
+        if (text.empty() || std::isdigit(static_cast<unsigned char>(text[0]))) return false;
+        return std::ranges::all_of(text, [](const char c)
+        {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.' || c == '$';
+        });
+    }
+
+    bool parseRegister(const std::string& text, uint8_t& reg)
+    {
+        if (const auto named = NAMED_REGISTERS.find(text); named != NAMED_REGISTERS.end())
+        {
+            reg = named->second;
+            return true;
+        }
+        if (text.size() < 2 || text[0] != 'r') return false;
+        if (!std::ranges::all_of(text.substr(1), [](const char c) { return std::isdigit(c); })) return false;
+        const uint64_t value = std::stoull(text.substr(1));
+        if (value > 0xff) return false;
+        reg = value;
+        return true;
+    }
+
+    bool parseInteger(const std::string& text, uint64_t& value)
+    {
+        if (text.size() == 3 && text[0] == '\'' && text[2] == '\'')
+        {
+            value = static_cast<uint8_t>(text[1]);
+            return true;
+        }
+        const bool negative = !text.empty() && text[0] == '-';
+        std::string digits = negative ? text.substr(1) : text;
+        int base = 10;
+        if (digits.starts_with("0x") || digits.starts_with("0X"))
+        {
+            base = 16;
+            digits = digits.substr(2);
+        }
+        else if (digits.starts_with("0b") || digits.starts_with("0B"))
+        {
+            base = 2;
+            digits = digits.substr(2);
+        }
+        if (digits.empty()) return false;
+        char* end = nullptr;
+        errno = 0;
+        const uint64_t parsed = std::strtoull(digits.c_str(), &end, base);
+        if (*end != '\0' || errno != 0) return false;
+        value = negative ? ~parsed + 1 : parsed;
+        return true;
+    }
+
+    bool isFloatLiteral(const std::string& text)
+    {
+        if (text.starts_with("0x") || text.starts_with("-0x")) return false;
+        if (text.find_first_of(".eE") == std::string::npos && text != "inf" && text != "nan") return false;
+        char* end = nullptr;
+        std::strtod(text.c_str(), &end);
+        return *end == '\0';
+    }
+
+    std::vector<uint8_t> parseString(const std::string& text, const uint64_t line)
+    {
+        if (text.size() < 2 || text.front() != '"' || text.back() != '"') fail(line, "expected a string literal");
+        std::vector<uint8_t> bytes;
+        for (uint64_t i = 1; i + 1 < text.size(); ++i)
+        {
+            if (text[i] != '\\')
+            {
+                bytes.push_back(text[i]);
+                continue;
+            }
+            if (++i + 1 >= text.size()) fail(line, "unterminated escape sequence");
+            switch (text[i])
+            {
+            case 'n': bytes.push_back('\n');
+                break;
+            case 't': bytes.push_back('\t');
+                break;
+            case 'r': bytes.push_back('\r');
+                break;
+            case '0': bytes.push_back(0);
+                break;
+            case 'x':
+                {
+                    if (i + 3 >= text.size() || !std::isxdigit(static_cast<unsigned char>(text[i + 1])) ||
+                        !std::isxdigit(static_cast<unsigned char>(text[i + 2])))
+                        fail(line, "bad \\x escape");
+                    uint8_t value = 0;
+                    for (const char digit : {text[i + 1], text[i + 2]})
+                        value = value << 4 | (std::isdigit(static_cast<unsigned char>(digit))
+                                                  ? digit - '0'
+                                                  : std::tolower(static_cast<unsigned char>(digit)) - 'a' + 10);
+                    bytes.push_back(value);
+                    i += 2;
+                    break;
+                }
+            default: bytes.push_back(text[i]);
+            }
+        }
+        return bytes;
+    }
+
+    uint64_t dataWidth(const std::string& directive)
+    {
+        if (directive == ".byte") return 1;
+        if (directive == ".short") return 2;
+        if (directive == ".int") return 4;
+        if (directive == ".quad" || directive == ".double") return 8;
+        return 0;
+    }
+
+    // Operands are numbers, named constants or labels with an optional +/- offset, joined with '|'. The labels used
+    // are added to references.
+    uint64_t evaluate(const std::string& text, const uint64_t width, const std::map<std::string, uint64_t>& labels,
+                      const uint64_t line, std::vector<std::string>* references = nullptr)
+    {
+        if ((width == 4 || width == 8) && isFloatLiteral(text))
+        {
+            const double value = std::strtod(text.c_str(), nullptr);
+            if (width == 4) return std::bit_cast<uint32_t>(static_cast<float>(value));
+            return std::bit_cast<uint64_t>(value);
+        }
+        uint64_t result = 0;
+        std::stringstream terms(text);
+        std::string term;
+        while (std::getline(terms, term, '|'))
+        {
+            term = trim(term);
+            uint64_t value = 0;
+            if (const auto named = NAMED_CONSTANTS.find(term); named != NAMED_CONSTANTS.end())
+            {
+                value = named->second;
+            }
+            else if (!parseInteger(term, value))
+            {
+                const auto sign = term.find_first_of("+-");
+                const std::string name = trim(term.substr(0, sign));
+                const auto label = labels.find(name);
+                if (label == labels.end()) fail(line, "undefined symbol '" + name + "'");
+                value = label->second;
+                if (references != nullptr) references->push_back(name);
+                if (sign != std::string::npos)
+                {
+                    uint64_t offset = 0;
+                    if (!parseInteger(trim(term.substr(sign + 1)), offset)) fail(line, "bad offset in '" + term + "'");
+                    value = term[sign] == '+' ? value + offset : value - offset;
+                }
+            }
+            result |= value;
+        }
+        if (width < 8 && result >> width * 8 != 0 && static_cast<int64_t>(result) >> (width * 8 - 1) != -1)
+            fail(line, "'" + text + "' does not fit in " + std::to_string(width) + " byte(s)");
+        return result;
+    }
+
+    void emit(std::vector<uint8_t>& output, const uint64_t value, const uint64_t width)
+    {
+        for (uint64_t i = 0; i < width; ++i) output.push_back(value >> (i * 8));
+    }
+
+    Module* Assembler::assemble(const std::string& source, const std::string& fileName)
+    {
+        std::vector<Statement> statements;
+        std::map<std::string, std::pair<uint8_t, uint64_t>> labelOffsets;
+        std::vector<Symbol> symbols;
+        uint64_t sizes[4] = {};
+        uint8_t section = SECTION_TEXT;
+        std::string entry;
+        uint64_t entryLine = 0;
+        std::vector<std::pair<std::string, uint64_t>> exportNames;
+        std::map<std::string, uint64_t> importLines;
+
+        std::stringstream lines(source);
+        std::string rawLine;
+        uint64_t lineNumber = 0;
+        while (std::getline(lines, rawLine))
+        {
+            ++lineNumber;
+            std::string line = trim(stripComment(rawLine));
+            // Any number of labels may precede the statement
+            for (auto colon = line.find(':'); colon != std::string::npos && isIdentifier(trim(line.substr(0, colon)));
+                 colon = line.find(':'))
+            {
+                const std::string name = trim(line.substr(0, colon));
+                if (labelOffsets.contains(name)) fail(lineNumber, "duplicate label '" + name + "'");
+                labelOffsets[name] = {section, sizes[section]};
+                line = trim(line.substr(colon + 1));
+            }
+            if (line.empty()) continue;
+
+            const auto space = line.find_first_of(" \t");
+            Statement statement;
+            statement.line = lineNumber;
+            statement.directive = line.substr(0, space);
+            statement.operands = splitOperands(space == std::string::npos ? "" : line.substr(space + 1));
+            const std::string& directive = statement.directive;
+
+            if (directive == ".text" || directive == ".rodata" || directive == ".data" || directive == ".bss")
+            {
+                section = directive == ".text"
+                              ? SECTION_TEXT
+                              : directive == ".rodata"
+                              ? SECTION_RODATA
+                              : directive == ".data"
+                              ? SECTION_DATA
+                              : SECTION_BSS;
+                continue;
+            }
+            if (directive == ".func")
+            {
+                if (section != SECTION_TEXT) fail(lineNumber, ".func is only allowed in .text");
+                if (statement.operands.size() != 1 || !isIdentifier(statement.operands[0]))
+                    fail(lineNumber, ".func takes one name");
+                const std::string& name = statement.operands[0];
+                if (labelOffsets.contains(name)) fail(lineNumber, "duplicate label '" + name + "'");
+                labelOffsets[name] = {section, sizes[section]};
+                symbols.push_back({sizes[section], 0, name});
+                continue;
+            }
+            if (directive == ".export" || directive == ".import")
+            {
+                if (statement.operands.size() != 1 || !isIdentifier(statement.operands[0]))
+                    fail(lineNumber, directive + " takes one name");
+                if (directive == ".export") exportNames.emplace_back(statement.operands[0], lineNumber);
+                else importLines.emplace(statement.operands[0], lineNumber);
+                continue;
+            }
+            if (directive == ".entry")
+            {
+                if (statement.operands.size() != 1) fail(lineNumber, ".entry takes one operand");
+                entry = statement.operands[0];
+                entryLine = lineNumber;
+                continue;
+            }
+
+            statement.section = section;
+            statement.offset = sizes[section];
+            if (directive == ".zero" || directive == ".align")
+            {
+                uint64_t value = 0;
+                if (statement.operands.size() != 1 || !parseInteger(statement.operands[0], value) ||
+                    statement.operands[0].starts_with('-'))
+                    fail(lineNumber, directive + " takes one number that is not negative");
+                if (directive == ".align" && !std::has_single_bit(value))
+                    fail(lineNumber, ".align takes a power of two");
+                if (directive == ".zero") statement.size = value;
+                else statement.size = (value - sizes[section] % value) % value;
+                if (statement.size > MAX_SECTION_SIZE || sizes[section] > MAX_SECTION_SIZE - statement.size)
+                    fail(lineNumber, directive + " makes the section larger than " +
+                         std::to_string(MAX_SECTION_SIZE) + " bytes");
+            }
+            else if (section == SECTION_BSS)
+            {
+                fail(lineNumber, "only .zero and .align are allowed in .bss");
+            }
+            else if (directive == ".string" || directive == ".ascii")
+            {
+                if (statement.operands.size() != 1) fail(lineNumber, directive + " takes one string");
+                statement.bytes = parseString(statement.operands[0], lineNumber);
+                if (directive == ".string") statement.bytes.push_back(0);
+                statement.size = statement.bytes.size();
+            }
+            else if (const uint64_t width = dataWidth(directive); width != 0)
+            {
+                statement.size = width * statement.operands.size();
+            }
+            else if (directive.starts_with("."))
+            {
+                fail(lineNumber, "unknown directive " + directive);
+            }
+            else
+            {
+                try
+                {
+                    statement.opcode = parseInstructionCode(directive);
+                }
+                catch (const std::runtime_error&)
+                {
+                    fail(lineNumber, "unknown instruction " + directive);
+                }
+                statement.instruction = true;
+                statement.layout = getInstructionLayout(statement.opcode);
+                if (statement.layout.ends_with('*'))
+                {
+                    // THREAD_CONTROL carries two more registers for the register commands
+                    statement.layout.pop_back();
+                    if (statement.operands.size() == statement.layout.size() + 2) statement.layout += "rr";
+                }
+                if (statement.operands.size() != statement.layout.size())
+                    fail(lineNumber, directive + " expects " + std::to_string(statement.layout.size()) +
+                         " operand(s)");
+                statement.size = 1 + getOperandLength(statement.layout);
+            }
+            sizes[section] += statement.size;
+            statements.push_back(std::move(statement));
+        }
+
+        // Sections are loaded back to back from address 0
+        const uint64_t bases[4] = {
+            0, sizes[SECTION_TEXT], sizes[SECTION_TEXT] + sizes[SECTION_RODATA],
+            sizes[SECTION_TEXT] + sizes[SECTION_RODATA] + sizes[SECTION_DATA]
+        };
+        std::map<std::string, uint64_t> labels;
+        for (const auto& [name, location] : labelOffsets) labels[name] = bases[location.first] + location.second;
+        // Imports read as 0 until the linker patches their sites
+        for (const auto& [name, line] : importLines)
+        {
+            if (labels.contains(name)) fail(line, "'" + name + "' is both imported and defined");
+            labels[name] = 0;
+        }
+        auto* linkInfo = new LinkInfo();
+        for (const auto& [name, line] : exportNames)
+        {
+            if (!labelOffsets.contains(name)) fail(line, "exported symbol '" + name + "' is not defined");
+            linkInfo->exports.push_back({name, labels[name]});
+        }
+        std::map<std::string, std::vector<uint64_t>> importSites;
+        // 8 byte operands naming one label become relocations, imports must be named on their own
+        const auto emitOperand = [&](std::vector<uint8_t>& output, const Statement& statement,
+                                     const std::string& operand, const uint64_t width)
+        {
+            const uint64_t site = bases[statement.section] + output.size();
+            std::vector<std::string> references;
+            emit(output, evaluate(operand, width, labels, statement.line, &references), width);
+            const bool imported = std::ranges::any_of(references, [&](const std::string& name)
+            {
+                return importLines.contains(name);
+            });
+            if (imported && (width != 8 || references.size() != 1 || operand != references[0]))
+                fail(statement.line, "an imported symbol has to be a whole 8 byte operand");
+            if (imported) importSites[references[0]].push_back(site);
+            else if (width == 8 && references.size() == 1) linkInfo->relocations.push_back(site);
+        };
+
+        auto* debugInfo = new DebugInfo();
+        std::ranges::stable_sort(symbols, {}, &Symbol::address);
+        for (uint64_t i = 0; i < symbols.size(); ++i)
+        {
+            const uint64_t end = i + 1 < symbols.size() ? symbols[i + 1].address : sizes[SECTION_TEXT];
+            symbols[i].size = end - symbols[i].address;
+        }
+        debugInfo->symbols = std::move(symbols);
+        if (!fileName.empty()) debugInfo->files.push_back(fileName);
+
+        std::vector<uint8_t> outputs[3];
+        for (const Statement& statement : statements)
+        {
+            if (statement.section == SECTION_BSS) continue;
+            std::vector<uint8_t>& output = outputs[statement.section];
+            if (statement.instruction)
+            {
+                if (!fileName.empty())
+                    debugInfo->lines.push_back({statement.offset, 0, static_cast<uint32_t>(statement.line)});
+                output.push_back(statement.opcode);
+                for (uint64_t i = 0; i < statement.layout.size(); ++i)
+                {
+                    const std::string& operand = statement.operands[i];
+                    if (statement.layout[i] == 'r')
+                    {
+                        uint8_t reg = 0;
+                        if (!parseRegister(operand, reg))
+                            fail(statement.line, "expected a register, got '" + operand + "'");
+                        output.push_back(reg);
+                        continue;
+                    }
+                    emitOperand(output, statement, operand, getOperandLength(statement.layout.substr(i, 1)));
+                }
+            }
+            else if (!statement.bytes.empty() || statement.directive == ".zero" || statement.directive == ".align")
+            {
+                output.insert(output.end(), statement.bytes.begin(), statement.bytes.end());
+                output.resize(output.size() + statement.size - statement.bytes.size());
+            }
+            else
+            {
+                const uint64_t width = dataWidth(statement.directive);
+                for (const std::string& operand : statement.operands) emitOperand(output, statement, operand, width);
+            }
+        }
+
+        const uint64_t entryPoint = entry.empty() ? 0 : evaluate(entry, 8, labels, entryLine);
+        auto* text = new uint8_t[outputs[SECTION_TEXT].size()];
+        std::ranges::copy(outputs[SECTION_TEXT], text);
+        auto* rodata = new uint8_t[outputs[SECTION_RODATA].size()];
+        std::ranges::copy(outputs[SECTION_RODATA], rodata);
+        auto* data = new uint8_t[outputs[SECTION_DATA].size()];
+        std::ranges::copy(outputs[SECTION_DATA], data);
+        auto* module = new Module(text, outputs[SECTION_TEXT].size(), rodata, outputs[SECTION_RODATA].size(), data,
+                                  outputs[SECTION_DATA].size(), sizes[SECTION_BSS], entryPoint);
+        if (debugInfo->symbols.empty() && debugInfo->lines.empty()) delete debugInfo;
+        else module->debugInfo = debugInfo;
+        for (auto& [name, sites] : importSites) linkInfo->imports.push_back({name, std::move(sites)});
+        // Only a module that exports something can be loaded as a library, anywhere but 0
+        if (linkInfo->exports.empty()) linkInfo->relocations.clear();
+        if (linkInfo->exports.empty() && linkInfo->imports.empty()) delete linkInfo;
+        else module->linkInfo = linkInfo;
+        return module;
+    }
+
+    std::string registerName(const uint8_t reg)
+    {
+        for (const auto& [name, value] : NAMED_REGISTERS)
+            if (value == reg) return name;
+        return "r" + std::to_string(reg);
+    }
+
+    std::string hex(const uint64_t value)
+    {
+        char buffer[19];
+        snprintf(buffer, sizeof(buffer), "0x%llx", static_cast<unsigned long long>(value));
+        return buffer;
+    }
+
+    uint64_t readOperand(const uint8_t* code, const uint64_t width)
+    {
+        uint64_t value = 0;
+        for (uint64_t i = 0; i < width; ++i) value |= static_cast<uint64_t>(code[i]) << (i * 8);
+        return value;
+    }
+
+    // quad names the 8 byte value at a relocation or import site and is empty everywhere else
+    void disassembleBytes(std::ostringstream& out, const uint8_t* bytes, const uint64_t length, const uint64_t base,
+                          const std::function<std::string(uint64_t)>& quad = nullptr)
+    {
+        for (uint64_t line = 0; line < length;)
+        {
+            std::string text;
+            if (const std::string name = quad && length - line >= 8 ? quad(base + line) : ""; !name.empty())
+            {
+                text = "    .quad " + name;
+                text.resize(std::max<uint64_t>(text.size(), 40), ' ');
+                out << text << " ; " << hex(base + line) << "\n";
+                line += 8;
+                continue;
+            }
+            uint64_t end = std::min(length, line + BYTES_PER_LINE);
+            for (uint64_t i = line + 1; quad && i < end; ++i)
+            {
+                if (!quad(base + i).empty()) end = i;
+            }
+            text = "    .byte ";
+            for (uint64_t i = line; i < end; ++i)
+            {
+                if (i != line) text += ", ";
+                text += hex(bytes[i]);
+            }
+            text.resize(std::max<uint64_t>(text.size(), 40), ' ');
+            out << text << " ; " << hex(base + line) << "\n";
+            line = end;
+        }
+    }
+
+    std::string Assembler::disassemble(const Module* module)
+    {
+        const uint8_t* code = module->text;
+        const uint64_t length = module->textLength;
+
+        std::set<uint64_t> instructions;
+        for (uint64_t offset = 0; offset < length;)
+        {
+            const uint64_t size = getInstructionLength(code, length, offset);
+            if (size != 0) instructions.insert(offset);
+            offset += size == 0 ? 1 : size;
+        }
+        std::map<uint64_t, std::string> importSites;
+        std::set<uint64_t> relocations;
+        if (module->linkInfo != nullptr)
+        {
+            for (const Import& symbol : module->linkInfo->imports)
+                for (const uint64_t site : symbol.sites) importSites[site] = symbol.name;
+            relocations.insert(module->linkInfo->relocations.begin(), module->linkInfo->relocations.end());
+        }
+        // Immediate branch targets and relocated addresses that land on an instruction get a label
+        std::map<uint64_t, std::string> labels;
+        for (const uint64_t offset : instructions)
+        {
+            if (code[offset] == JUMP_IMMEDIATE || code[offset] == INVOKE_IMMEDIATE)
+            {
+                const uint64_t target = readOperand(code + offset + 1, 8);
+                if (instructions.contains(target)) labels[target] = "L_" + hex(target).substr(2);
+            }
+            const uint64_t end = offset + getInstructionLength(code, length, offset);
+            for (auto site = relocations.upper_bound(offset); site != relocations.end() && *site < end; ++site)
+            {
+                const uint64_t target = readOperand(code + *site, 8);
+                if (instructions.contains(target)) labels[target] = "L_" + hex(target).substr(2);
+            }
+        }
+        if (instructions.contains(module->entryPoint)) labels[module->entryPoint] = "entry";
+        if (module->linkInfo != nullptr)
+        {
+            for (const Export& symbol : module->linkInfo->exports)
+                if (instructions.contains(symbol.address)) labels[symbol.address] = symbol.name;
+        }
+        // Function symbols take over their start's label and are written back as .func
+        std::set<uint64_t> functions;
+        if (module->debugInfo != nullptr)
+        {
+            for (const Symbol& symbol : module->debugInfo->symbols)
+            {
+                if (!instructions.contains(symbol.address) || functions.contains(symbol.address)) continue;
+                labels[symbol.address] = symbol.name;
+                functions.insert(symbol.address);
+            }
+        }
+
+        // Relocated addresses past the text are written relative to a label at the start of their section
+        const uint64_t sectionStarts[] = {length, length + module->rodataLength,
+                                          length + module->rodataLength + module->dataLength};
+        const uint64_t sectionLengths[] = {module->rodataLength, module->dataLength, module->bssLength};
+        const char* sectionLabels[] = {"L_rodata", "L_data", "L_bss"};
+        const auto reference = [&](const uint64_t value)
+        {
+            if (labels.contains(value)) return labels[value];
+            for (uint64_t i = 0; i < 3; ++i)
+            {
+                if (value >= sectionStarts[i] && value - sectionStarts[i] < sectionLengths[i])
+                    return std::string(sectionLabels[i]) + "+" + hex(value - sectionStarts[i]);
+            }
+            return hex(value);
+        };
+        const auto quad = [&](const uint64_t site) -> std::string
+        {
+            if (const auto imported = importSites.find(site); imported != importSites.end()) return imported->second;
+            if (!relocations.contains(site)) return "";
+            const uint8_t* bytes = site < sectionStarts[1]
+                                       ? module->rodata + (site - sectionStarts[0])
+                                       : module->data + (site - sectionStarts[1]);
+            return reference(readOperand(bytes, 8));
+        };
+        const bool relocated = !relocations.empty();
+
+        std::ostringstream out;
+        out << ".entry " << (labels.contains(module->entryPoint) ? labels[module->entryPoint] : hex(module->entryPoint))
+            << "\n";
+        if (module->linkInfo != nullptr)
+        {
+            for (const Import& symbol : module->linkInfo->imports) out << ".import " << symbol.name << "\n";
+            // Exports of data keep their address only as a comment, rodata and data are written without labels
+            for (const Export& symbol : module->linkInfo->exports)
+            {
+                if (labels.contains(symbol.address) && labels[symbol.address] == symbol.name)
+                    out << ".export " << symbol.name << "\n";
+                else out << "; .export " << symbol.name << " = " << hex(symbol.address) << "\n";
+            }
+        }
+        out << ".text\n";
+        for (uint64_t offset = 0; offset < length;)
+        {
+            if (const auto label = labels.find(offset); label != labels.end())
+                out << (functions.contains(offset) ? ".func " + label->second : label->second + ":") << "\n";
+            const uint64_t size = getInstructionLength(code, length, offset);
+            if (size == 0)
+            {
+                disassembleBytes(out, code + offset, 1, offset);
+                ++offset;
+                continue;
+            }
+            std::string layout(getInstructionLayout(code[offset]));
+            if (layout.ends_with('*'))
+            {
+                layout.pop_back();
+                if (size > 1 + getOperandLength(layout)) layout += "rr";
+            }
+            std::string text = "    " + std::string(getInstructionName(code[offset]));
+            uint64_t position = offset + 1;
+            for (uint64_t i = 0; i < layout.size(); ++i)
+            {
+                text += i == 0 ? " " : ", ";
+                const uint64_t width = getOperandLength(layout.substr(i, 1));
+                const uint64_t value = readOperand(code + position, width);
+                if (layout[i] == 'r') text += registerName(value);
+                else if (layout[i] == 'q' && importSites.contains(position)) text += importSites[position];
+                else if (layout[i] == 'q' && relocations.contains(position)) text += reference(value);
+                else if (layout[i] == 'q' && labels.contains(value) &&
+                    (code[offset] == JUMP_IMMEDIATE || code[offset] == INVOKE_IMMEDIATE))
+                    text += labels[value];
+                else if (layout[i] == 'q') text += hex(value);
+                else text += std::to_string(value);
+                position += width;
+            }
+            text.resize(std::max<uint64_t>(text.size(), 40), ' ');
+            out << text << " ; " << hex(offset) << "\n";
+            offset += size;
+        }
+        if (module->rodataLength != 0)
+        {
+            out << ".rodata\n" << (relocated ? "L_rodata:\n" : "");
+            disassembleBytes(out, module->rodata, module->rodataLength, length, quad);
+        }
+        if (module->dataLength != 0)
+        {
+            out << ".data\n" << (relocated ? "L_data:\n" : "");
+            disassembleBytes(out, module->data, module->dataLength, length + module->rodataLength, quad);
+        }
+        if (module->bssLength != 0)
+            out << ".bss\n" << (relocated ? "L_bss:\n" : "") << "    .zero " << module->bssLength << "\n";
+        return out.str();
+    }
+}
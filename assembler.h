@@ -0,0 +1,42 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#ifndef ASSEMBLER_H
+#define ASSEMBLER_H
+#include <cstdint>
+#include <string>
+
+#include "module.h"
+
+namespace lvm
+{
+    // Text form of modules, driven by the opcode table in bytecode.h.
+    //
+    //     .text / .rodata / .data / .bss   switch section, text is the default
+    //     name:                            label, its value is the absolute guest address
+    //     ADD r1, r2, r3                   instruction, operands follow getInstructionLayout
+    //     .byte/.short/.int/.quad/.double  data, .quad also takes labels
+    //     .string "..." / .ascii "..."     with and without a terminating NUL
+    //     .zero n / .align n               padding, the only directives allowed in .bss; .align takes a power of
+    //                                      two and counts from the start of the section
+    //     .entry name                      entry point
+    //     .func name                       label that also starts a function symbol, which ends at the next one
+    //     .export name                     make a label available to modules loaded after this one
+    //     .import name                     symbol of another module, only usable as a whole 8 byte operand
+    //
+    // Registers are r0 to r35 plus rv, bp, sp, pc, flags and idtr. Immediates are numbers, 'c', float literals,
+    // labels with an optional +/- offset, type names (byte .. double), conditions (e, ne, g, l, u) and thread
+    // control commands (stop, wait, get_register, set_register), joined with '|'. Comments start with ';'.
+    //
+    // A module with exports is a library: every 8 byte operand naming one label is recorded as a relocation, so that it
+    // can be loaded at any address by SYSCALL_LOAD_DYNAMIC_LIBRARY.
+    class Assembler
+    {
+    public:
+        // With a file name the module also gets a line table pointing back into the source
+        static Module* assemble(const std::string& source, const std::string& fileName = "");
+        static std::string disassemble(const Module* module);
+    };
+}
+#endif //ASSEMBLER_H
@@ -0,0 +1,561 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+// Micro-benchmarks for the interpreter and the memory subsystem. Every workload is a small program assembled
+// here, run on a fresh VirtualMachine, and reported as ns per retired guest instruction and operations per second.
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "bytecode.h"
+#include "module.h"
+#include "simd.h"
+#include "vm.h"
+
+using namespace lvm;
+using namespace lvm::bytecode;
+
+constexpr uint64_t BENCHMARK_MEMORY_SIZE = 256 * 1024 * 1024;
+constexpr uint64_t BENCHMARK_STACK_SIZE = 1024 * 1024;
+constexpr uint64_t BENCHMARK_STACK_AREA_SIZE = 1024 * 1024 * 1024;
+constexpr uint64_t DEFAULT_REPETITIONS = 5;
+constexpr uint64_t LOAD_TEXT_SIZE = 16 * 1024 * 1024;
+constexpr uint64_t LOAD_RODATA_SIZE = 8 * 1024 * 1024;
+constexpr uint64_t LOAD_DATA_SIZE = 4 * 1024 * 1024;
+
+class ProgramBuilder
+{
+public:
+    std::vector<uint8_t> text;
+    std::vector<uint8_t> rodata;
+    uint64_t bssLength = 8;
+
+    ProgramBuilder& op(const uint8_t opcode, const std::initializer_list<uint8_t> operands = {})
+    {
+        text.push_back(opcode);
+        text.insert(text.end(), operands.begin(), operands.end());
+        return *this;
+    }
+
+    ProgramBuilder& u8(const uint8_t value)
+    {
+        text.push_back(value);
+        return *this;
+    }
+
+    ProgramBuilder& u64(const uint64_t value)
+    {
+        for (int i = 0; i < 8; ++i) text.push_back(value >> (i * 8));
+        return *this;
+    }
+
+    ProgramBuilder& label(const std::string& name)
+    {
+        labels[name] = text.size();
+        return *this;
+    }
+
+    // 8 byte immediate resolved to the address of a label when the module is built
+    ProgramBuilder& address(const std::string& name)
+    {
+        fixups.emplace_back(text.size(), name);
+        return u64(0);
+    }
+
+    ProgramBuilder& move(const uint64_t value, const uint8_t reg)
+    {
+        return op(MOV_IMMEDIATE8).u64(value).u8(reg);
+    }
+
+    ProgramBuilder& moveAddress(const std::string& name, const uint8_t reg)
+    {
+        return op(MOV_IMMEDIATE8).address(name).u8(reg);
+    }
+
+    ProgramBuilder& moveRodata(const uint64_t offset, const uint8_t reg)
+    {
+        rodataFixups.emplace_back(text.size() + 1, offset);
+        return move(0, reg);
+    }
+
+    // The first 8 bytes of bss hold the result the harness checks after the run
+    ProgramBuilder& moveResultAddress(const uint8_t reg)
+    {
+        bssFixups.push_back(text.size() + 1);
+        return move(0, reg);
+    }
+
+    uint64_t addString(const std::string& value)
+    {
+        const uint64_t offset = rodata.size();
+        rodata.insert(rodata.end(), value.begin(), value.end());
+        rodata.push_back(0);
+        return offset;
+    }
+
+    [[nodiscard]] uint64_t resultAddress() const
+    {
+        return text.size() + rodata.size();
+    }
+
+    [[nodiscard]] Module* build() const
+    {
+        std::vector<uint8_t> code = text;
+        const auto patch = [&code](const uint64_t offset, const uint64_t value)
+        {
+            for (int i = 0; i < 8; ++i) code[offset + i] = value >> (i * 8);
+        };
+        for (const auto& [offset, name] : fixups) patch(offset, labels.at(name));
+        for (const auto& [offset, value] : rodataFixups) patch(offset, text.size() + value);
+        for (const uint64_t offset : bssFixups) patch(offset, resultAddress());
+        auto* textCopy = new uint8_t[code.size()];
+        memcpy(textCopy, code.data(), code.size());
+        auto* rodataCopy = new uint8_t[rodata.size()];
+        memcpy(rodataCopy, rodata.data(), rodata.size());
+        return new Module(textCopy, code.size(), rodataCopy, rodata.size(), new uint8_t[0], 0, bssLength, 0);
+    }
+
+private:
+    std::map<std::string, uint64_t> labels;
+    std::vector<std::pair<uint64_t, std::string>> fixups;
+    std::vector<std::pair<uint64_t, uint64_t>> rodataFixups;
+    std::vector<uint64_t> bssFixups;
+};
+
+class Workload
+{
+public:
+    ProgramBuilder program;
+    // Dynamic instruction count, derived from the shape of the program
+    uint64_t instructions = 0;
+    uint64_t operations = 0;
+    std::string unit;
+    bool checkResult = false;
+    uint64_t expectedResult = 0;
+    std::function<void()> cleanup;
+};
+
+// Five ALU instructions per iteration, the loop counter and branch included
+Workload arithmeticLoop(const uint64_t iterations)
+{
+    Workload workload;
+    ProgramBuilder& p = workload.program;
+    p.move(iterations, 8).move(1, 6).move(0, 1).move(3, 3).moveAddress("loop", 10);
+    p.label("loop");
+    p.op(ADD, {1, 6, 1}).op(MUL, {1, 3, 4}).op(XOR, {4, 1, 5}).op(SUB, {8, 6, 8}).op(JUMP_IF_TRUE, {8, 10});
+    p.moveResultAddress(11).op(STORE_8, {11, 1}).op(THREAD_FINISH);
+    workload.instructions = 5 + iterations * 5 + 3;
+    workload.operations = iterations;
+    workload.unit = "iterations";
+    workload.checkResult = true;
+    workload.expectedResult = iterations;
+    return workload;
+}
+
+uint64_t fibonacci(const uint64_t n)
+{
+    uint64_t a = 0;
+    uint64_t b = 1;
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        const uint64_t next = a + b;
+        a = b;
+        b = next;
+    }
+    return a;
+}
+
+// Naive recursive fibonacci, every call goes through INVOKE, CREATE_FRAME, DESTROY_FRAME and RETURN
+Workload recursiveCalls(const uint64_t n)
+{
+    Workload workload;
+    ProgramBuilder& p = workload.program;
+    p.move(n, 1).move(2, 20).move(1, 22).moveAddress("base", 21).moveAddress("fib", 23);
+    p.op(INVOKE, {23});
+    p.moveResultAddress(11).op(STORE_8, {11, RETURN_VALUE_REGISTER}).op(THREAD_FINISH);
+    p.label("fib").op(CREATE_FRAME).u64(0);
+    p.op(CMP, {LONG_TYPE, 1, 20}).op(JL, {21});
+    p.op(PUSH_8, {1}).op(SUB, {1, 22, 1}).op(INVOKE, {23}).op(POP_8, {1});
+    p.op(PUSH_8, {RETURN_VALUE_REGISTER}).op(SUB, {1, 20, 1}).op(INVOKE, {23}).op(POP_8, {2});
+    p.op(ADD, {RETURN_VALUE_REGISTER, 2, RETURN_VALUE_REGISTER}).op(DESTROY_FRAME).u64(0).op(RETURN);
+    p.label("base").op(MOV, {1, RETURN_VALUE_REGISTER}).op(DESTROY_FRAME).u64(0).op(RETURN);
+    // fib(n) makes fib(n + 1) calls that hit the base case and fib(n + 1) - 1 that recurse
+    const uint64_t leaves = fibonacci(n + 1);
+    workload.instructions = 6 + 3 + leaves * 6 + (leaves - 1) * 14;
+    workload.operations = 2 * leaves - 1;
+    workload.unit = "calls";
+    workload.checkResult = true;
+    workload.expectedResult = fibonacci(n);
+    return workload;
+}
+
+// Two live blocks of varying size per iteration, freed in allocation order
+Workload allocationChurn(const uint64_t iterations)
+{
+    Workload workload;
+    ProgramBuilder& p = workload.program;
+    p.move(iterations, 8).move(1, 6).move(255, 12).move(16, 13).moveAddress("loop", 10);
+    p.label("loop");
+    p.op(AND, {8, 12, 3}).op(ADD, {3, 13, 3});
+    p.op(MALLOC, {3, 4}).op(STORE_8, {4, 8}).op(MALLOC, {3, 5}).op(STORE_8, {5, 8});
+    p.op(FREE, {4}).op(FREE, {5});
+    p.op(SUB, {8, 6, 8}).op(JUMP_IF_TRUE, {8, 10});
+    p.op(THREAD_FINISH);
+    workload.instructions = 5 + iterations * 10 + 1;
+    workload.operations = iterations * 4;
+    workload.unit = "malloc/free";
+    return workload;
+}
+
+// Every thread hammers the global lock behind the ATOMIC_ instructions
+Workload atomicContention(const uint64_t threads, const uint64_t iterations)
+{
+    Workload workload;
+    ProgramBuilder& p = workload.program;
+    p.move(threads - 1, 14).move(1, 6).moveAddress("worker", 15).moveAddress("spawn", 16);
+    p.op(JUMP_IF_FALSE, {14, 15});
+    p.label("spawn").op(CREATE_THREAD, {15, 9}).op(SUB, {14, 6, 14}).op(JUMP_IF_TRUE, {14, 16});
+    p.label("worker").move(iterations, 8).move(1, 6).moveAddress("loop", 10);
+    p.label("loop").op(ATOMIC_ADD, {1, 6, 1}).op(SUB, {8, 6, 8}).op(JUMP_IF_TRUE, {8, 10});
+    p.op(THREAD_FINISH);
+    workload.instructions = 5 + (threads - 1) * 3 + threads * (3 + iterations * 3 + 1);
+    workload.operations = threads * iterations;
+    workload.unit = "atomic ops";
+    return workload;
+}
+
+// Writes a file in blocks through WRITE, then reads it back through READ
+Workload fileIO(const uint64_t blocks, const uint64_t blockSize)
+{
+    Workload workload;
+    ProgramBuilder& p = workload.program;
+    const std::string path = (std::filesystem::temp_directory_path() / "lvm_benchmark.tmp").string();
+    const uint64_t pathOffset = p.addString(path);
+    p.moveRodata(pathOffset, 1).move(blockSize, 2).move(1, 6).move(FileHandle::FH_WRITE, 3).move(0, 4);
+    p.op(MALLOC, {2, 5}).moveAddress("write", 10).moveAddress("read", 11);
+    p.op(OPEN, {1, 3, 4, 7}).move(blocks, 8);
+    p.label("write").op(WRITE, {7, 5, 2, 9}).op(SUB, {8, 6, 8}).op(JUMP_IF_TRUE, {8, 10});
+    p.op(CLOSE, {7, 9});
+    p.move(FileHandle::FH_READ, 3).op(OPEN, {1, 3, 4, 7}).move(blocks, 8);
+    p.label("read").op(READ, {7, 5, 2, 9}).op(SUB, {8, 6, 8}).op(JUMP_IF_TRUE, {8, 11});
+    p.op(CLOSE, {7, 9}).op(THREAD_FINISH);
+    workload.instructions = 10 + blocks * 3 + 4 + blocks * 3 + 2;
+    workload.operations = blocks * 2;
+    workload.unit = "read/write";
+    workload.cleanup = [path] { std::filesystem::remove(path); };
+    return workload;
+}
+
+// Dot product of two double arrays of elements, a[i] = i and b[i] = 1, passes times: either a guest loop of loads and
+// scalar double arithmetic or one VECTOR_DOT per pass
+Workload dotProduct(const uint64_t elements, const uint64_t passes, const bool vector)
+{
+    Workload workload;
+    ProgramBuilder& p = workload.program;
+    p.move(elements, 8).move(1, 6).move(8, 14).move(elements * 8, 2).op(MALLOC, {2, 3}).op(MALLOC, {2, 4});
+    p.move(std::bit_cast<uint64_t>(1.0), 15).move(0, 9).op(MOV, {3, 12}).op(MOV, {4, 13}).op(MOV, {8, 17});
+    p.move(0, 20).move(passes, 21).moveAddress("fill", 10).moveAddress("pass", 11);
+    p.label("fill").op(LONG_TO_DOUBLE, {9, 16}).op(STORE_8, {12, 16}).op(STORE_8, {13, 15});
+    p.op(ADD, {12, 14, 12}).op(ADD, {13, 14, 13}).op(ADD, {9, 6, 9}).op(SUB, {17, 6, 17}).op(JUMP_IF_TRUE, {17, 10});
+    p.label("pass");
+    if (vector)
+    {
+        p.op(VECTOR_DOT, {DOUBLE_TYPE, 3, 4, 8, 18}).op(ADD_DOUBLE, {20, 18, 20});
+    }
+    else
+    {
+        p.op(MOV, {3, 12}).op(MOV, {4, 13}).op(MOV, {8, 17}).moveAddress("element", 22);
+        p.label("element").op(LOAD_8, {12, 18}).op(LOAD_8, {13, 19}).op(MUL_DOUBLE, {18, 19, 18});
+        p.op(ADD_DOUBLE, {20, 18, 20}).op(ADD, {12, 14, 12}).op(ADD, {13, 14, 13}).op(SUB, {17, 6, 17});
+        p.op(JUMP_IF_TRUE, {17, 22});
+    }
+    p.op(SUB, {21, 6, 21}).op(JUMP_IF_TRUE, {21, 11});
+    p.op(DOUBLE_TO_LONG, {20, 1}).moveResultAddress(11).op(STORE_8, {11, 1}).op(THREAD_FINISH);
+    workload.instructions = 15 + elements * 8 + passes * (vector ? 4 : 6 + elements * 8) + 4;
+    workload.operations = elements * passes;
+    workload.unit = "elements";
+    workload.checkResult = true;
+    workload.expectedResult = passes * (elements * (elements - 1) / 2);
+    return workload;
+}
+
+// Copies a block of bytes to another passes times: either a guest LOAD_1/STORE_1 loop or one MEMORY_COPY per pass
+Workload memoryCopy(const uint64_t bytes, const uint64_t passes, const bool bulk)
+{
+    Workload workload;
+    ProgramBuilder& p = workload.program;
+    p.move(bytes, 8).move(1, 6).op(MALLOC, {8, 3}).op(MALLOC, {8, 4}).move(passes, 21).moveAddress("pass", 11);
+    p.label("pass");
+    if (bulk)
+    {
+        p.op(MEMORY_COPY, {4, 3, 8});
+    }
+    else
+    {
+        p.op(MOV, {3, 12}).op(MOV, {4, 13}).op(MOV, {8, 17}).moveAddress("byte", 22);
+        p.label("byte").op(LOAD_1, {12, 18}).op(STORE_1, {13, 18}).op(ADD, {12, 6, 12}).op(ADD, {13, 6, 13});
+        p.op(SUB, {17, 6, 17}).op(JUMP_IF_TRUE, {17, 22});
+    }
+    p.op(SUB, {21, 6, 21}).op(JUMP_IF_TRUE, {21, 11}).op(THREAD_FINISH);
+    workload.instructions = 6 + passes * (bulk ? 3 : 6 + bytes * 6) + 1;
+    workload.operations = bytes * passes;
+    workload.unit = "bytes";
+    return workload;
+}
+
+// Hashes a block of bytes passes times: a guest FNV-1a loop, the usual hand-written hash, or one hashing opcode
+Workload hashing(const uint64_t bytes, const uint64_t passes, const uint8_t opcode)
+{
+    Workload workload;
+    ProgramBuilder& p = workload.program;
+    p.move(bytes, 8).move(1, 6).op(MALLOC, {8, 3}).op(MALLOC, {8, 4}).move(passes, 21).moveAddress("pass", 11);
+    p.label("pass");
+    if (opcode == NOP)
+    {
+        p.op(MOV, {3, 12}).op(MOV, {8, 17}).move(0xcbf29ce484222325ULL, 20).move(0x100000001b3ULL, 19);
+        p.moveAddress("byte", 22);
+        p.label("byte").op(LOAD_1, {12, 18}).op(XOR, {20, 18, 20}).op(MUL, {20, 19, 20}).op(ADD, {12, 6, 12});
+        p.op(SUB, {17, 6, 17}).op(JUMP_IF_TRUE, {17, 22});
+    }
+    else if (opcode == SHA256)
+    {
+        p.op(SHA256, {3, 8, 4});
+    }
+    else
+    {
+        p.op(opcode, {3, 8, 20});
+        if (opcode == WYHASH) p.u8(20);
+    }
+    p.op(SUB, {21, 6, 21}).op(JUMP_IF_TRUE, {21, 11}).op(THREAD_FINISH);
+    workload.instructions = 6 + passes * (opcode == NOP ? 7 + bytes * 6 : 3) + 1;
+    workload.operations = bytes * passes;
+    workload.unit = "bytes";
+    return workload;
+}
+
+class Result
+{
+public:
+    double best = 0;
+    double median = 0;
+    bool valid = true;
+};
+
+Result run(const Workload& workload, const uint64_t repetitions)
+{
+    std::vector<double> times;
+    Result result;
+    for (uint64_t i = 0; i < repetitions; ++i)
+    {
+        const Module* module = workload.program.build();
+        auto* vm = new VirtualMachine(BENCHMARK_MEMORY_SIZE, BENCHMARK_STACK_SIZE, false,
+                                      BENCHMARK_STACK_AREA_SIZE);
+        currentVirtualMachine = vm;
+        vm->init(module);
+        const auto start = std::chrono::steady_clock::now();
+        vm->run();
+        const auto end = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+        if (workload.checkResult)
+        {
+            const uint64_t value = *reinterpret_cast<uint64_t*>(static_cast<uint8_t*>(vm->memory->heap) +
+                workload.program.resultAddress());
+            if (value != workload.expectedResult) result.valid = false;
+        }
+        vm->destroy();
+        delete vm;
+        delete module;
+        if (workload.cleanup) workload.cleanup();
+    }
+    std::ranges::sort(times);
+    result.best = times.front();
+    result.median = times[times.size() / 2];
+    return result;
+}
+
+// Load benchmark module: the fib program's text repeated, identifier-like strings in rodata and a table in data, about
+// the mix a large real program carries
+Module* largeModule()
+{
+    const Module* program = recursiveCalls(27).program.build();
+    std::vector<uint8_t> text;
+    while (text.size() < LOAD_TEXT_SIZE) text.insert(text.end(), program->text, program->text + program->textLength);
+    delete program;
+    static const char* words[] = {"module", "function", "buffer", "thread", "handle", "memory", "stack", "value"};
+    std::vector<uint8_t> rodata;
+    uint64_t state = 1;
+    while (rodata.size() < LOAD_RODATA_SIZE)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        const std::string name = std::string("lvm_") + words[state >> 61] + "_" + words[state >> 58 & 7] + "_" +
+            std::to_string(state >> 48 & 0x3ff);
+        rodata.insert(rodata.end(), name.begin(), name.end() + 1);
+    }
+    std::vector<uint8_t> data;
+    for (uint64_t i = 0; data.size() < LOAD_DATA_SIZE; ++i)
+        for (int b = 0; b < 8; ++b) data.push_back((i * i % 1000) >> (b * 8));
+    auto* textCopy = new uint8_t[text.size()];
+    std::ranges::copy(text, textCopy);
+    auto* rodataCopy = new uint8_t[rodata.size()];
+    std::ranges::copy(rodata, rodataCopy);
+    auto* dataCopy = new uint8_t[data.size()];
+    std::ranges::copy(data, dataCopy);
+    return new Module(textCopy, text.size(), rodataCopy, rodata.size(), dataCopy, data.size(), 8, 0);
+}
+
+class LoadResult
+{
+public:
+    uint64_t fileSize = 0;
+    double best = 0;
+    double median = 0;
+    bool valid = true;
+};
+
+// Time from the file on disk to a VM ready to run: Module::fromFile plus VirtualMachine::init, which is where
+// compressed sections are unpacked
+LoadResult load(const Module* module, const bool compress, const uint64_t repetitions)
+{
+    LoadResult result;
+    const std::string path = (std::filesystem::temp_directory_path() / "lvm_benchmark_load.lvme").string();
+    const uint8_t* raw = module->raw(compress);
+    result.fileSize = module->rawLength(compress);
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr || fwrite(raw, 1, result.fileSize, file) != result.fileSize) result.valid = false;
+    if (file != nullptr) fclose(file);
+    delete[] raw;
+    std::vector<double> times;
+    for (uint64_t i = 0; i < repetitions && result.valid; ++i)
+    {
+        auto* vm = new VirtualMachine(BENCHMARK_MEMORY_SIZE, BENCHMARK_STACK_SIZE, false, BENCHMARK_STACK_AREA_SIZE);
+        currentVirtualMachine = vm;
+        const auto start = std::chrono::steady_clock::now();
+        const Module* loaded = Module::fromFile(path);
+        const bool initialized = loaded != nullptr && vm->init(loaded) == 0;
+        const auto end = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+        const auto* heap = static_cast<const uint8_t*>(vm->memory->heap);
+        if (!initialized || memcmp(heap, module->text, module->textLength) != 0 ||
+            memcmp(heap + module->textLength, module->rodata, module->rodataLength) != 0)
+            result.valid = false;
+        vm->destroy();
+        delete vm;
+        delete loaded;
+    }
+    std::filesystem::remove(path);
+    if (times.empty()) return result;
+    std::ranges::sort(times);
+    result.best = times.front();
+    result.median = times[times.size() / 2];
+    return result;
+}
+
+int main(int argc, const char** argv)
+{
+    std::string filter;
+    std::string emitDirectory;
+    uint64_t repetitions = DEFAULT_REPETITIONS;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string argument = argv[i];
+        if (argument.starts_with("--filter=")) filter = argument.substr(9);
+        else if (argument.starts_with("--repetitions=")) repetitions = std::stoull(argument.substr(14));
+        else if (argument.starts_with("--emit=")) emitDirectory = argument.substr(7);
+        else if (argument.starts_with("--vector-isa=") && selectVectorIsa(argument.substr(13))) continue;
+        else
+        {
+            std::cerr << "Usage: lvm_benchmark [--filter=<substring>] [--repetitions=<n>] [--emit=<directory>] "
+                "[--vector-isa=avx512|avx2|sse2|neon|scalar]" << std::endl;
+            return 1;
+        }
+    }
+    if (repetitions == 0) repetitions = 1;
+
+    InstallPageFaultHandler();
+    const std::vector<std::pair<std::string, std::function<Workload()>>> workloads = {
+        {"arithmetic_loop", [] { return arithmeticLoop(20000000); }},
+        {"recursive_fib_27", [] { return recursiveCalls(27); }},
+        {"malloc_free_churn", [] { return allocationChurn(1000000); }},
+        {"atomic_contention_4", [] { return atomicContention(4, 1000000); }},
+        {"file_io_4k", [] { return fileIO(16384, 4096); }},
+        {"dot_scalar_loop", [] { return dotProduct(4096, 1000, false); }},
+        {"dot_vector", [] { return dotProduct(4096, 100000, true); }},
+        {"memcpy_byte_loop", [] { return memoryCopy(65536, 100, false); }},
+        {"memcpy_bulk", [] { return memoryCopy(65536, 100000, true); }},
+        {"hash_fnv1a_loop", [] { return hashing(65536, 100, NOP); }},
+        {"hash_crc32c", [] { return hashing(65536, 20000, CRC32C); }},
+        {"hash_wyhash", [] { return hashing(65536, 20000, WYHASH); }},
+        {"hash_sha256", [] { return hashing(65536, 2000, SHA256); }},
+    };
+
+    std::cout << "dispatch: " << getDispatchKind() << std::endl;
+    std::cout << std::left << std::setw(24) << "benchmark" << std::right << std::setw(14) << "instructions"
+        << std::setw(12) << "best ms" << std::setw(12) << "median ms" << std::setw(10) << "ns/inst" << std::setw(16)
+        << "ops/sec" << "  unit" << std::endl;
+    bool failed = false;
+    for (const auto& [name, create] : workloads)
+    {
+        if (!filter.empty() && name.find(filter) == std::string::npos) continue;
+        const Workload workload = create();
+        if (!emitDirectory.empty())
+        {
+            const Module* module = workload.program.build();
+            const uint8_t* raw = module->raw();
+            FILE* file = fopen((std::filesystem::path(emitDirectory) / (name + ".lvme")).string().c_str(), "wb");
+            if (file)
+            {
+                fwrite(raw, 1, module->rawLength(), file);
+                fclose(file);
+            }
+            delete[] raw;
+            delete module;
+        }
+        const Result result = run(workload, repetitions);
+        std::cout << std::left << std::setw(24) << name << std::right << std::setw(14) << workload.instructions
+            << std::fixed << std::setprecision(2) << std::setw(12) << result.best / 1e6 << std::setw(12)
+            << result.median / 1e6 << std::setw(10) << result.best / workload.instructions << std::setw(16)
+            << std::setprecision(0) << workload.operations / (result.best / 1e9) << "  " << workload.unit;
+        if (!result.valid)
+        {
+            std::cout << "  (wrong result)";
+            failed = true;
+        }
+        std::cout << std::endl;
+    }
+
+    const std::vector<std::pair<std::string, bool>> loads = {{"module_load_raw", false}, {"module_load_lz4", true}};
+    const Module* module = nullptr;
+    for (const auto& [name, compress] : loads)
+    {
+        if (!filter.empty() && name.find(filter) == std::string::npos) continue;
+        if (module == nullptr)
+        {
+            module = largeModule();
+            std::cout << std::endl << std::left << std::setw(24) << "benchmark" << std::right << std::setw(14)
+                << "file KiB" << std::setw(12) << "best ms" << std::setw(12) << "median ms" << std::setw(16)
+                << "MB/s unpacked" << std::endl;
+        }
+        const LoadResult result = load(module, compress, repetitions);
+        const uint64_t unpacked = module->textLength + module->rodataLength + module->dataLength;
+        std::cout << std::left << std::setw(24) << name << std::right << std::setw(14) << result.fileSize / 1024
+            << std::fixed << std::setprecision(2) << std::setw(12) << result.best / 1e6 << std::setw(12)
+            << result.median / 1e6 << std::setw(16) << std::setprecision(0) << unpacked / (result.best / 1e3);
+        if (!result.valid)
+        {
+            std::cout << "  (load failed)";
+            failed = true;
+        }
+        std::cout << std::endl;
+    }
+    delete module;
+    return failed ? 1 : 0;
+}
@@ -6,7 +6,58 @@
 #define BYTECODE_H
 #include <cstdint>
 #include <string>
+#include <string_view>
 
+// Name and operand layout of every instruction, in opcode order. The interpreter's dispatch table and everything that
+// decodes text are expanded from it, so that they agree on what each opcode is and how long it is.
+#define LVM_OPCODE_LIST(OP)                                                                                     \
+  OP(NOP, "")                                                                                                   \
+  OP(PUSH_1, "r") OP(PUSH_2, "r") OP(PUSH_4, "r") OP(PUSH_8, "r")                                               \
+  OP(POP_1, "r")  OP(POP_2, "r")  OP(POP_4, "r")  OP(POP_8, "r")                                                \
+  OP(LOAD_1, "rr") OP(LOAD_2, "rr") OP(LOAD_4, "rr") OP(LOAD_8, "rr")                                           \
+  OP(STORE_1, "rr") OP(STORE_2, "rr") OP(STORE_4, "rr") OP(STORE_8, "rr")                                       \
+  OP(CMP, "brr") OP(ATOMIC_CMP, "brr")                                                                          \
+  OP(MOV_E, "rr") OP(MOV_NE, "rr") OP(MOV_L, "rr") OP(MOV_LE, "rr")                                             \
+  OP(MOV_G, "rr") OP(MOV_GE, "rr") OP(MOV_UL, "rr") OP(MOV_ULE, "rr")                                           \
+  OP(MOV_UG, "rr") OP(MOV_UGE, "rr") OP(MOV, "rr")                                                              \
+  OP(MOV_IMMEDIATE1, "br") OP(MOV_IMMEDIATE2, "wr") OP(MOV_IMMEDIATE4, "dr") OP(MOV_IMMEDIATE8, "qr")           \
+  OP(JUMP, "r") OP(JUMP_IMMEDIATE, "q")                                                                         \
+  OP(JE, "r") OP(JNE, "r") OP(JL, "r") OP(JLE, "r") OP(JG, "r") OP(JGE, "r")                                    \
+  OP(JUL, "r") OP(JULE, "r") OP(JUG, "r") OP(JUGE, "r")                                                         \
+  OP(MALLOC, "rr") OP(FREE, "r") OP(REALLOC, "rrr")                                                             \
+  OP(ADD, "rrr") OP(SUB, "rrr") OP(MUL, "rrr") OP(DIV, "rrr") OP(MOD, "rrr")                                    \
+  OP(AND, "rrr") OP(OR, "rrr") OP(XOR, "rrr") OP(NOT, "rr") OP(NEG, "rr")                                       \
+  OP(SHL, "rrr") OP(SHR, "rrr") OP(USHR, "rrr")                                                                 \
+  OP(INC, "r") OP(DEC, "r")                                                                                     \
+  OP(ADD_DOUBLE, "rrr") OP(SUB_DOUBLE, "rrr") OP(MUL_DOUBLE, "rrr") OP(DIV_DOUBLE, "rrr") OP(MOD_DOUBLE, "rrr") \
+  OP(ADD_FLOAT, "rrr")  OP(SUB_FLOAT, "rrr")  OP(MUL_FLOAT, "rrr")  OP(DIV_FLOAT, "rrr")  OP(MOD_FLOAT, "rrr")  \
+  OP(ATOMIC_ADD, "rrr") OP(ATOMIC_SUB, "rrr") OP(ATOMIC_MUL, "rrr") OP(ATOMIC_DIV, "rrr") OP(ATOMIC_MOD, "rrr") \
+  OP(ATOMIC_AND, "rrr") OP(ATOMIC_OR, "rrr")  OP(ATOMIC_XOR, "rrr")                                             \
+  OP(ATOMIC_NOT, "rr") OP(ATOMIC_NEG, "rr")                                                                     \
+  OP(ATOMIC_SHL, "rrr") OP(ATOMIC_SHR, "rrr") OP(ATOMIC_USHR, "rrr")                                            \
+  OP(ATOMIC_INC, "r") OP(ATOMIC_DEC, "r")                                                                       \
+  OP(ATOMIC_ADD_DOUBLE, "rrr") OP(ATOMIC_SUB_DOUBLE, "rrr") OP(ATOMIC_MUL_DOUBLE, "rrr")                        \
+  OP(ATOMIC_DIV_DOUBLE, "rrr") OP(ATOMIC_MOD_DOUBLE, "rrr")                                                     \
+  OP(ATOMIC_ADD_FLOAT, "rrr") OP(ATOMIC_SUB_FLOAT, "rrr") OP(ATOMIC_MUL_FLOAT, "rrr")                           \
+  OP(ATOMIC_DIV_FLOAT, "rrr") OP(ATOMIC_MOD_FLOAT, "rrr")                                                       \
+  OP(CAS, "rrr") OP(INVOKE, "r") OP(INVOKE_IMMEDIATE, "q") OP(RETURN, "")                                       \
+  OP(INTERRUPT, "b") OP(INTERRUPT_RETURN, "")                                                                   \
+  OP(INT_TYPE_CAST, "brr") OP(LONG_TO_DOUBLE, "rr") OP(DOUBLE_TO_LONG, "rr")                                    \
+  OP(DOUBLE_TO_FLOAT, "rr") OP(FLOAT_TO_DOUBLE, "rr")                                                           \
+  OP(OPEN, "rrrr") OP(CLOSE, "rr") OP(READ, "rrrr") OP(WRITE, "rrrr")                                           \
+  OP(CREATE_FRAME, "q") OP(DESTROY_FRAME, "q")                                                                  \
+  OP(EXIT, "r") OP(EXIT_IMMEDIATE, "q")                                                                         \
+  OP(GET_FIELD_ADDRESS, "rqr") OP(GET_LOCAL_ADDRESS, "qr") OP(GET_PARAMETER_ADDRESS, "qr")                      \
+  OP(CREATE_THREAD, "rr") OP(THREAD_CONTROL, "rb*")                                                             \
+  OP(LOAD_FIELD, "brqr") OP(STORE_FIELD, "brqr") OP(LOAD_LOCAL, "bqr") OP(STORE_LOCAL, "bqr")                   \
+  OP(LOAD_PARAMETER, "bqr") OP(STORE_PARAMETER, "bqr")                                                          \
+  OP(JUMP_IF_TRUE, "rr") OP(JUMP_IF_FALSE, "rr") OP(SYSCALL, "r") OP(THREAD_FINISH, "")                         \
+  OP(NEG_DOUBLE, "r") OP(NEG_FLOAT, "r") OP(ATOMIC_NEG_DOUBLE, "r") OP(ATOMIC_NEG_FLOAT, "r")                   \
+  OP(JUMP_IF, "bbrrr") OP(INVOKE_NATIVE, "rq")                                                                  \
+  OP(VECTOR_ADD, "brrrr") OP(VECTOR_MUL, "brrrr") OP(VECTOR_FMA, "brrrr")                                       \
+  OP(VECTOR_SUM, "brrr") OP(VECTOR_MIN, "brrr") OP(VECTOR_MAX, "brrr") OP(VECTOR_DOT, "brrrr")                 \
+  OP(MEMORY_COPY, "rrr") OP(MEMORY_FILL, "rrr") OP(MEMORY_COMPARE, "rrrr") OP(MEMORY_FIND, "rrrr")           \
+  OP(CRC32C, "rrr") OP(WYHASH, "rrrr") OP(SHA256, "rrr")
 
 namespace lvm::bytecode
 {
@@ -29,12 +80,16 @@ namespace lvm::bytecode
     constexpr uint8_t LONG_TYPE = 3;
     constexpr uint8_t FLOAT_TYPE = 4;
     constexpr uint8_t DOUBLE_TYPE = 5;
+    // Only used in INVOKE_NATIVE signatures
+    constexpr uint8_t POINTER_TYPE = 6;
+    constexpr uint8_t VOID_TYPE = 7;
     constexpr uint8_t TC_STOP = 0; // TC = Thread Control
     constexpr uint8_t TC_WAIT = 1;
     constexpr uint8_t TC_GET_REGISTER = 2;
     constexpr uint8_t TC_SET_REGISTER = 3;
     constexpr uint8_t INTERRUPT_DIVIDE_BY_ZERO = 0;
     constexpr uint8_t INTERRUPT_PAGE_ERROR = 1;
+    constexpr uint8_t INTERRUPT_STACK_OVERFLOW = 2;
     constexpr uint8_t CONDITION_EQUAL = 1;
     constexpr uint8_t CONDITION_NOT_EQUAL = 1 << 1;
     constexpr uint8_t CONDITION_GREATER = 1 << 2;
@@ -45,6 +100,8 @@ namespace lvm::bytecode
     constexpr uint64_t SYSCALL_LOAD_NATIVE_LIBRARY_SYMBOL = 2;
     constexpr uint64_t SYSCALL_LOAD_DYNAMIC_LIBRARY = 3;
     constexpr uint64_t SYSCALL_TEST_PRINT_INT = 0;
+    // Result of MEMORY_FIND when the byte does not occur
+    constexpr uint64_t MEMORY_NOT_FOUND = ~0ULL;
 
     constexpr uint8_t NOP = 0x00;
     constexpr uint8_t PUSH_1 = 0x01;
@@ -185,8 +242,28 @@ namespace lvm::bytecode
     constexpr uint8_t ATOMIC_NEG_FLOAT = 0x88;
     constexpr uint8_t JUMP_IF = 0x89;
     constexpr uint8_t INVOKE_NATIVE = 0x8a;
+    constexpr uint8_t VECTOR_ADD = 0x8b;
+    constexpr uint8_t VECTOR_MUL = 0x8c;
+    constexpr uint8_t VECTOR_FMA = 0x8d;
+    constexpr uint8_t VECTOR_SUM = 0x8e;
+    constexpr uint8_t VECTOR_MIN = 0x8f;
+    constexpr uint8_t VECTOR_MAX = 0x90;
+    constexpr uint8_t VECTOR_DOT = 0x91;
+    constexpr uint8_t MEMORY_COPY = 0x92;
+    constexpr uint8_t MEMORY_FILL = 0x93;
+    constexpr uint8_t MEMORY_COMPARE = 0x94;
+    constexpr uint8_t MEMORY_FIND = 0x95;
+    constexpr uint8_t CRC32C = 0x96;
+    constexpr uint8_t WYHASH = 0x97;
+    constexpr uint8_t SHA256 = 0x98;
 
     std::string_view getInstructionName(uint8_t code);
+    // Operands in encoding order: r register, b/w/d/q 1/2/4/8 byte immediate,
+    // * operands that depend on the preceding immediate (THREAD_CONTROL), ? unknown opcode
+    std::string_view getInstructionLayout(uint8_t code);
+    uint64_t getOperandLength(std::string_view layout);
+    // Length of the instruction at offset, 0 if the opcode is unknown or the operands are cut off
+    uint64_t getInstructionLength(const uint8_t* code, uint64_t length, uint64_t offset);
     uint8_t parseInstructionCode(const std::string& code);
 }
 
@@ -0,0 +1,60 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#ifndef BYTES_H
+#define BYTES_H
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace lvm
+{
+    inline void writeInteger(std::vector<uint8_t>& output, const uint64_t value, const uint64_t width)
+    {
+        for (uint64_t i = 0; i < width; ++i) output.push_back(value >> (i * 8));
+    }
+
+    // Little endian reader that never reads past length; after the first short read failed is set and reads return 0
+    class ByteReader
+    {
+    public:
+        const uint8_t* raw;
+        uint64_t length;
+        uint64_t index = 0;
+        bool failed = false;
+
+        ByteReader(const uint8_t* raw, const uint64_t length) : raw(raw), length(length)
+        {
+        }
+
+        uint64_t read(const uint64_t width)
+        {
+            if (failed || index > length || length - index < width)
+            {
+                failed = true;
+                return 0;
+            }
+            uint64_t value = 0;
+            for (uint64_t i = 0; i < width; ++i) value |= static_cast<uint64_t>(raw[index++]) << (i * 8);
+            return value;
+        }
+
+        std::string readString()
+        {
+            const auto* end = failed || index >= length
+                                  ? nullptr
+                                  : static_cast<const uint8_t*>(memchr(raw + index, 0, length - index));
+            if (end == nullptr)
+            {
+                failed = true;
+                return "";
+            }
+            std::string value(reinterpret_cast<const char*>(raw + index), end - (raw + index));
+            index += value.size() + 1;
+            return value;
+        }
+    };
+}
+#endif //BYTES_H
@@ -0,0 +1,81 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#include "crc32c.h"
+
+#include <array>
+#include <cstring>
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <x86intrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+namespace lvm
+{
+    constexpr uint32_t CRC32C_POLYNOMIAL = 0x82f63b78;
+
+    constexpr std::array<uint32_t, 256> CRC32C_TABLE = []
+    {
+        std::array<uint32_t, 256> table{};
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) crc = crc & 1 ? crc >> 1 ^ CRC32C_POLYNOMIAL : crc >> 1;
+            table[i] = crc;
+        }
+        return table;
+    }();
+
+    uint32_t crc32cSoftware(const uint8_t* data, const uint64_t length, uint32_t crc)
+    {
+        for (uint64_t i = 0; i < length; ++i) crc = CRC32C_TABLE[(crc ^ data[i]) & 0xff] ^ crc >> 8;
+        return crc;
+    }
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    __attribute__((target("sse4.2"))) uint32_t crc32cHardware(const uint8_t* data, uint64_t length, uint32_t crc)
+    {
+        uint64_t value = crc;
+        for (; length >= 8; data += 8, length -= 8)
+        {
+            uint64_t word;
+            memcpy(&word, data, sizeof(word));
+            value = _mm_crc32_u64(value, word);
+        }
+        crc = static_cast<uint32_t>(value);
+        for (; length > 0; ++data, --length) crc = _mm_crc32_u8(crc, *data);
+        return crc;
+    }
+
+    const bool hasHardwareCrc32c = __builtin_cpu_supports("sse4.2");
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+    uint32_t crc32cHardware(const uint8_t* data, uint64_t length, uint32_t crc)
+    {
+        for (; length >= 8; data += 8, length -= 8)
+        {
+            uint64_t word;
+            memcpy(&word, data, sizeof(word));
+            crc = __crc32cd(crc, word);
+        }
+        for (; length > 0; ++data, --length) crc = __crc32cb(crc, *data);
+        return crc;
+    }
+
+    constexpr bool hasHardwareCrc32c = true;
+#else
+    uint32_t crc32cHardware(const uint8_t* data, const uint64_t length, const uint32_t crc)
+    {
+        return crc32cSoftware(data, length, crc);
+    }
+
+    constexpr bool hasHardwareCrc32c = false;
+#endif
+
+    uint32_t crc32c(const uint8_t* data, const uint64_t length, const uint32_t crc)
+    {
+        if (hasHardwareCrc32c) return ~crc32cHardware(data, length, ~crc);
+        return ~crc32cSoftware(data, length, ~crc);
+    }
+}
@@ -0,0 +1,14 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#ifndef CRC32C_H
+#define CRC32C_H
+#include <cstdint>
+
+namespace lvm
+{
+    // CRC-32C (Castagnoli), with the SSE4.2 or ARMv8 CRC instructions when the CPU has them
+    uint32_t crc32c(const uint8_t* data, uint64_t length, uint32_t crc = 0);
+}
+#endif //CRC32C_H
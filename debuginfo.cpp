@@ -0,0 +1,151 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#include "debuginfo.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "bytes.h"
+
+namespace lvm
+{
+    std::vector<uint8_t> DebugInfo::rawSymbols() const
+    {
+        std::vector<uint8_t> payload;
+        writeInteger(payload, symbols.size(), 8);
+        for (const Symbol& symbol : symbols)
+        {
+            writeInteger(payload, symbol.address, 8);
+            writeInteger(payload, symbol.size, 8);
+            payload.insert(payload.end(), symbol.name.begin(), symbol.name.end());
+            payload.push_back(0);
+        }
+        return payload;
+    }
+
+    std::vector<uint8_t> DebugInfo::rawLines() const
+    {
+        std::vector<uint8_t> payload;
+        writeInteger(payload, files.size(), 8);
+        for (const std::string& file : files)
+        {
+            payload.insert(payload.end(), file.begin(), file.end());
+            payload.push_back(0);
+        }
+        writeInteger(payload, lines.size(), 8);
+        for (const LineEntry& line : lines)
+        {
+            writeInteger(payload, line.address, 8);
+            writeInteger(payload, line.file, 4);
+            writeInteger(payload, line.line, 4);
+        }
+        return payload;
+    }
+
+    bool DebugInfo::readSymbols(const uint8_t* raw, const uint64_t length)
+    {
+        ByteReader section(raw, length);
+        const uint64_t count = section.read(8);
+        std::vector<Symbol> read;
+        for (uint64_t i = 0; i < count && !section.failed; ++i)
+        {
+            Symbol symbol;
+            symbol.address = section.read(8);
+            symbol.size = section.read(8);
+            symbol.name = section.readString();
+            read.push_back(std::move(symbol));
+        }
+        if (section.failed) return false;
+        std::ranges::sort(read, {}, &Symbol::address);
+        symbols = std::move(read);
+        return true;
+    }
+
+    bool DebugInfo::readLines(const uint8_t* raw, const uint64_t length)
+    {
+        ByteReader section(raw, length);
+        std::vector<std::string> readFiles;
+        std::vector<LineEntry> readLines;
+        const uint64_t fileCount = section.read(8);
+        for (uint64_t i = 0; i < fileCount && !section.failed; ++i) readFiles.push_back(section.readString());
+        const uint64_t count = section.read(8);
+        for (uint64_t i = 0; i < count && !section.failed; ++i)
+        {
+            LineEntry line;
+            line.address = section.read(8);
+            line.file = section.read(4);
+            line.line = section.read(4);
+            if (line.file >= readFiles.size()) section.failed = true;
+            readLines.push_back(line);
+        }
+        if (section.failed) return false;
+        std::ranges::sort(readLines, {}, &LineEntry::address);
+        files = std::move(readFiles);
+        lines = std::move(readLines);
+        return true;
+    }
+
+    DebugInfo* DebugInfo::fromTrailer(const uint8_t* raw, const uint64_t length)
+    {
+        auto* debugInfo = new DebugInfo();
+        ByteReader sections(raw, length);
+        while (!sections.failed && sections.index < length)
+        {
+            const uint32_t kind = sections.read(4);
+            const uint32_t version = sections.read(4);
+            const uint64_t size = sections.read(8);
+            if (sections.failed || length - sections.index < size) break;
+            const uint8_t* payload = raw + sections.index;
+            sections.index += size;
+            if (kind == DEBUG_SECTION_SYMBOLS && version == DEBUG_SYMBOLS_VERSION)
+                debugInfo->readSymbols(payload, size);
+            else if (kind == DEBUG_SECTION_LINES && version == DEBUG_LINES_VERSION)
+                debugInfo->readLines(payload, size);
+        }
+        if (debugInfo->symbols.empty() && debugInfo->lines.empty())
+        {
+            delete debugInfo;
+            return nullptr;
+        }
+        return debugInfo;
+    }
+
+    const Symbol* DebugInfo::findSymbol(const uint64_t address) const
+    {
+        const auto next = std::ranges::upper_bound(symbols, address, {}, &Symbol::address);
+        if (next == symbols.begin()) return nullptr;
+        const Symbol& symbol = *(next - 1);
+        return address - symbol.address < symbol.size ? &symbol : nullptr;
+    }
+
+    const LineEntry* DebugInfo::findLine(const uint64_t address) const
+    {
+        const auto next = std::ranges::upper_bound(lines, address, {}, &LineEntry::address);
+        return next == lines.begin() ? nullptr : &*(next - 1);
+    }
+
+    std::string DebugInfo::getFunctionName(const uint64_t address) const
+    {
+        if (const Symbol* symbol = findSymbol(address)) return symbol->name;
+        char name[19];
+        snprintf(name, sizeof(name), "0x%llx", static_cast<unsigned long long>(address));
+        return name;
+    }
+
+    std::string DebugInfo::describe(const uint64_t address) const
+    {
+        std::string description = getFunctionName(address);
+        if (const Symbol* symbol = findSymbol(address); symbol != nullptr && address != symbol->address)
+        {
+            char offset[20];
+            snprintf(offset, sizeof(offset), "+0x%llx", static_cast<unsigned long long>(address - symbol->address));
+            description += offset;
+        }
+        if (const LineEntry* line = findLine(address))
+            description += " (" + files[line->file] + ":" + std::to_string(line->line) + ")";
+        return description;
+    }
+}
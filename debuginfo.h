@@ -0,0 +1,58 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#ifndef DEBUGINFO_H
+#define DEBUGINFO_H
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lvm
+{
+    // Versions of the symbol and line table payloads, stored with their module sections
+    constexpr uint32_t DEBUG_SYMBOLS_VERSION = 1;
+    constexpr uint32_t DEBUG_LINES_VERSION = 1;
+    // Kinds of the kind, version, length records that version 0 modules carried after the entry point
+    constexpr uint32_t DEBUG_SECTION_SYMBOLS = 1;
+    constexpr uint32_t DEBUG_SECTION_LINES = 2;
+
+    class Symbol
+    {
+    public:
+        uint64_t address;
+        uint64_t size;
+        std::string name;
+    };
+
+    class LineEntry
+    {
+    public:
+        uint64_t address;
+        uint32_t file;
+        uint32_t line;
+    };
+
+    class DebugInfo
+    {
+    public:
+        std::vector<Symbol> symbols; // sorted by address
+        std::vector<std::string> files;
+        std::vector<LineEntry> lines; // sorted by address
+
+        [[nodiscard]] std::vector<uint8_t> rawSymbols() const;
+        [[nodiscard]] std::vector<uint8_t> rawLines() const;
+        // Both leave the tables untouched and return false on a malformed payload
+        bool readSymbols(const uint8_t* raw, uint64_t length);
+        bool readLines(const uint8_t* raw, uint64_t length);
+        // Debug records behind a version 0 module, nullptr if there are none
+        static DebugInfo* fromTrailer(const uint8_t* raw, uint64_t length);
+        [[nodiscard]] const Symbol* findSymbol(uint64_t address) const;
+        [[nodiscard]] const LineEntry* findLine(uint64_t address) const;
+        // Name of the function containing address, or the address in hex
+        [[nodiscard]] std::string getFunctionName(uint64_t address) const;
+        // name+offset (file:line) as far as known
+        [[nodiscard]] std::string describe(uint64_t address) const;
+    };
+}
+#endif //DEBUGINFO_H
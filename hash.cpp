@@ -0,0 +1,246 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#include "hash.h"
+
+#include <cstring>
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <x86intrin.h>
+#elif defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+namespace lvm
+{
+    constexpr uint64_t WYHASH_SECRET[4] = {
+        0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL
+    };
+
+    // Full 64 x 64 bit product, low half in a and high half in b
+    inline void wyMultiply(uint64_t& a, uint64_t& b)
+    {
+#if defined(__SIZEOF_INT128__)
+        const __uint128_t product = static_cast<__uint128_t>(a) * b;
+        a = static_cast<uint64_t>(product);
+        b = static_cast<uint64_t>(product >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+        a = _umul128(a, b, &b);
+#else
+        const uint64_t aHigh = a >> 32, aLow = static_cast<uint32_t>(a);
+        const uint64_t bHigh = b >> 32, bLow = static_cast<uint32_t>(b);
+        const uint64_t high = aHigh * bHigh, middle0 = aHigh * bLow, middle1 = aLow * bHigh, low = aLow * bLow;
+        const uint64_t t = low + (middle0 << 32);
+        const uint64_t carry = (t < low) + ((t + (middle1 << 32)) < t);
+        a = t + (middle1 << 32);
+        b = high + (middle0 >> 32) + (middle1 >> 32) + carry;
+#endif
+    }
+
+    inline uint64_t wyMix(uint64_t a, uint64_t b)
+    {
+        wyMultiply(a, b);
+        return a ^ b;
+    }
+
+    inline uint64_t read64(const uint8_t* p)
+    {
+        uint64_t value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    inline uint64_t read32(const uint8_t* p)
+    {
+        uint32_t value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    uint64_t wyhash(const uint8_t* data, const uint64_t length, uint64_t seed)
+    {
+        const uint8_t* p = data;
+        seed ^= wyMix(seed ^ WYHASH_SECRET[0], WYHASH_SECRET[1]);
+        uint64_t a = 0;
+        uint64_t b = 0;
+        if (length <= 16)
+        {
+            if (length >= 4)
+            {
+                a = read32(p) << 32 | read32(p + (length >> 3 << 2));
+                b = read32(p + length - 4) << 32 | read32(p + length - 4 - (length >> 3 << 2));
+            }
+            else if (length > 0)
+            {
+                a = static_cast<uint64_t>(p[0]) << 16 | static_cast<uint64_t>(p[length >> 1]) << 8 | p[length - 1];
+            }
+        }
+        else
+        {
+            uint64_t i = length;
+            if (i >= 48)
+            {
+                uint64_t see1 = seed;
+                uint64_t see2 = seed;
+                do
+                {
+                    seed = wyMix(read64(p) ^ WYHASH_SECRET[1], read64(p + 8) ^ seed);
+                    see1 = wyMix(read64(p + 16) ^ WYHASH_SECRET[2], read64(p + 24) ^ see1);
+                    see2 = wyMix(read64(p + 32) ^ WYHASH_SECRET[3], read64(p + 40) ^ see2);
+                    p += 48;
+                    i -= 48;
+                }
+                while (i >= 48);
+                seed ^= see1 ^ see2;
+            }
+            while (i > 16)
+            {
+                seed = wyMix(read64(p) ^ WYHASH_SECRET[1], read64(p + 8) ^ seed);
+                i -= 16;
+                p += 16;
+            }
+            a = read64(p + i - 16);
+            b = read64(p + i - 8);
+        }
+        a ^= WYHASH_SECRET[1];
+        b ^= seed;
+        wyMultiply(a, b);
+        return wyMix(a ^ WYHASH_SECRET[0] ^ length, b ^ WYHASH_SECRET[1]);
+    }
+
+    alignas(16) constexpr uint32_t SHA256_K[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+    };
+
+    constexpr uint32_t rotateRight(const uint32_t value, const int shift)
+    {
+        return value >> shift | value << (32 - shift);
+    }
+
+    void sha256BlocksSoftware(uint32_t* state, const uint8_t* data, uint64_t blocks)
+    {
+        for (; blocks > 0; --blocks, data += 64)
+        {
+            uint32_t w[64];
+            for (int i = 0; i < 16; ++i)
+                w[i] = static_cast<uint32_t>(data[4 * i]) << 24 | data[4 * i + 1] << 16 | data[4 * i + 2] << 8 |
+                    data[4 * i + 3];
+            for (int i = 16; i < 64; ++i)
+            {
+                const uint32_t s0 = rotateRight(w[i - 15], 7) ^ rotateRight(w[i - 15], 18) ^ w[i - 15] >> 3;
+                const uint32_t s1 = rotateRight(w[i - 2], 17) ^ rotateRight(w[i - 2], 19) ^ w[i - 2] >> 10;
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+            uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+            uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+            for (int i = 0; i < 64; ++i)
+            {
+                const uint32_t t1 = h + (rotateRight(e, 6) ^ rotateRight(e, 11) ^ rotateRight(e, 25)) +
+                    ((e & f) ^ (~e & g)) + SHA256_K[i] + w[i];
+                const uint32_t t2 = (rotateRight(a, 2) ^ rotateRight(a, 13) ^ rotateRight(a, 22)) +
+                    ((a & b) ^ (a & c) ^ (b & c));
+                h = g;
+                g = f;
+                f = e;
+                e = d + t1;
+                d = c;
+                c = b;
+                b = a;
+                a = t1 + t2;
+            }
+            state[0] += a;
+            state[1] += b;
+            state[2] += c;
+            state[3] += d;
+            state[4] += e;
+            state[5] += f;
+            state[6] += g;
+            state[7] += h;
+        }
+    }
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    // Four rounds per iteration; the state is kept as ABEF / CDGH as sha256rnds2 expects
+    __attribute__((target("sha,sse4.1"))) void sha256BlocksHardware(uint32_t* state, const uint8_t* data,
+                                                                    uint64_t blocks)
+    {
+        const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+        __m128i cdab = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0xb1);
+        __m128i efgh = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4)), 0x1b);
+        __m128i abef = _mm_alignr_epi8(cdab, efgh, 8);
+        __m128i cdgh = _mm_blend_epi16(efgh, cdab, 0xf0);
+        for (; blocks > 0; --blocks, data += 64)
+        {
+            const __m128i savedAbef = abef;
+            const __m128i savedCdgh = cdgh;
+            __m128i messages[4];
+            for (int i = 0; i < 16; ++i)
+            {
+                if (i < 4)
+                {
+                    messages[i] = _mm_shuffle_epi8(
+                        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * i)), byteSwap);
+                }
+                else
+                {
+                    // W[t] = W[t - 16] + s0(W[t - 15]) + W[t - 7] + s1(W[t - 2]), four words at a time
+                    __m128i next = _mm_sha256msg1_epu32(messages[i & 3], messages[(i + 1) & 3]);
+                    next = _mm_add_epi32(next, _mm_alignr_epi8(messages[(i + 3) & 3], messages[(i + 2) & 3], 4));
+                    messages[i & 3] = _mm_sha256msg2_epu32(next, messages[(i + 3) & 3]);
+                }
+                __m128i words = _mm_add_epi32(messages[i & 3],
+                                              _mm_load_si128(reinterpret_cast<const __m128i*>(SHA256_K + 4 * i)));
+                cdgh = _mm_sha256rnds2_epu32(cdgh, abef, words);
+                words = _mm_shuffle_epi32(words, 0x0e);
+                abef = _mm_sha256rnds2_epu32(abef, cdgh, words);
+            }
+            abef = _mm_add_epi32(abef, savedAbef);
+            cdgh = _mm_add_epi32(cdgh, savedCdgh);
+        }
+        const __m128i feba = _mm_shuffle_epi32(abef, 0x1b);
+        const __m128i dchg = _mm_shuffle_epi32(cdgh, 0xb1);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_blend_epi16(feba, dchg, 0xf0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), _mm_alignr_epi8(dchg, feba, 8));
+    }
+
+    const bool hasHardwareSha256 = __builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1");
+#else
+    void sha256BlocksHardware(uint32_t* state, const uint8_t* data, const uint64_t blocks)
+    {
+        sha256BlocksSoftware(state, data, blocks);
+    }
+
+    constexpr bool hasHardwareSha256 = false;
+#endif
+
+    void sha256(const uint8_t* data, const uint64_t length, uint8_t* digest)
+    {
+        uint32_t state[8] = {
+            0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+        };
+        const auto blocks = hasHardwareSha256 ? sha256BlocksHardware : sha256BlocksSoftware;
+        blocks(state, data, length / 64);
+        // The rest of the data, the 0x80 terminator and the bit length, in one or two blocks
+        uint8_t tail[128] = {};
+        const uint64_t rest = length % 64;
+        memcpy(tail, data + length - rest, rest);
+        tail[rest] = 0x80;
+        const uint64_t tailLength = rest < 56 ? 64 : 128;
+        for (int i = 0; i < 8; ++i) tail[tailLength - 1 - i] = static_cast<uint8_t>(length * 8 >> (8 * i));
+        blocks(state, tail, tailLength / 64);
+        for (int i = 0; i < 8; ++i)
+        {
+            digest[4 * i] = state[i] >> 24;
+            digest[4 * i + 1] = state[i] >> 16;
+            digest[4 * i + 2] = state[i] >> 8;
+            digest[4 * i + 3] = state[i];
+        }
+    }
+}
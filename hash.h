@@ -0,0 +1,18 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#ifndef HASH_H
+#define HASH_H
+#include <cstdint>
+
+namespace lvm
+{
+    constexpr uint64_t SHA256_DIGEST_LENGTH = 32;
+
+    // wyhash, final version 4 with its default secret, for hash map keys
+    uint64_t wyhash(const uint8_t* data, uint64_t length, uint64_t seed);
+    // SHA-256, with the SHA-NI instructions when the CPU has them
+    void sha256(const uint8_t* data, uint64_t length, uint8_t* digest);
+}
+#endif //HASH_H
@@ -0,0 +1,115 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#include "instrumentation.h"
+#ifdef LVM_INSTRUMENT_DISPATCH
+#include <algorithm>
+#include <iomanip>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "bytecode.h"
+
+namespace lvm
+{
+    using namespace bytecode;
+
+    constexpr uint64_t TOP_PAIRS = 50;
+
+    std::mutex dispatchCountersMutex;
+    DispatchCounters* totalDispatchCounters = nullptr;
+
+    void mergeDispatchCounters(const DispatchCounters* counters)
+    {
+        std::lock_guard lock(dispatchCountersMutex);
+        if (totalDispatchCounters == nullptr) totalDispatchCounters = new DispatchCounters();
+        for (uint64_t i = 0; i < 256; ++i)
+        {
+            totalDispatchCounters->counts[i] += counters->counts[i];
+            totalDispatchCounters->cycles[i] += counters->cycles[i];
+            for (uint64_t j = 0; j < 256; ++j) totalDispatchCounters->pairs[i][j] += counters->pairs[i][j];
+        }
+    }
+
+    std::string_view getInstructionClass(const std::string_view name)
+    {
+        if (name.starts_with("ATOMIC_")) return "atomic";
+        if (name.starts_with("PUSH_") || name.starts_with("POP_") || name.ends_with("_FRAME")) return "stack";
+        if (name.starts_with("LOAD_") || name.starts_with("STORE_") || name.ends_with("_ADDRESS")) return "memory";
+        if (name.starts_with("MOV")) return "move";
+        if (name.starts_with("J") || name.starts_with("INVOKE") || name == "RETURN" || name.starts_with("INTERRUPT"))
+            return "control";
+        if (name == "SYSCALL" || name == "MALLOC" || name == "FREE" || name == "REALLOC" ||
+            name.find("THREAD") != std::string_view::npos)
+            return "system";
+        return "arithmetic";
+    }
+
+    void dumpDispatchCounters(std::ostream& output)
+    {
+        std::lock_guard lock(dispatchCountersMutex);
+        if (totalDispatchCounters == nullptr) return;
+        const DispatchCounters* counters = totalDispatchCounters;
+        uint64_t total = 0;
+        uint64_t totalCycles = 0;
+        std::vector<uint8_t> codes;
+        for (uint64_t i = 0; i < 256; ++i)
+        {
+            total += counters->counts[i];
+            totalCycles += counters->cycles[i];
+            if (counters->counts[i] != 0) codes.push_back(i);
+        }
+        if (total == 0) return;
+        std::ranges::sort(codes, [counters](const uint8_t a, const uint8_t b)
+        {
+            return counters->counts[a] > counters->counts[b];
+        });
+
+        output << std::fixed << std::setprecision(2);
+        output << std::left << std::setw(28) << "opcode" << std::right << std::setw(16) << "count" << std::setw(9)
+            << "%" << std::setw(18) << "cycles" << std::setw(12) << "cycles/op" << std::endl;
+        std::vector<std::pair<std::string_view, std::pair<uint64_t, uint64_t>>> classes;
+        for (const uint8_t code : codes)
+        {
+            const std::string_view name = getInstructionName(code);
+            output << std::left << std::setw(28) << name << std::right << std::setw(16) << counters->counts[code]
+                << std::setw(9) << 100.0 * counters->counts[code] / total << std::setw(18) << counters->cycles[code]
+                << std::setw(12) << static_cast<double>(counters->cycles[code]) / counters->counts[code] << std::endl;
+            const std::string_view instructionClass = getInstructionClass(name);
+            auto entry = std::ranges::find(classes, instructionClass, &decltype(classes)::value_type::first);
+            if (entry == classes.end()) entry = classes.insert(classes.end(), {instructionClass, {0, 0}});
+            entry->second.first += counters->counts[code];
+            entry->second.second += counters->cycles[code];
+        }
+
+        output << std::endl << std::left << std::setw(28) << "class" << std::right << std::setw(16) << "count"
+            << std::setw(9) << "%" << std::setw(18) << "cycles" << std::setw(9) << "%" << std::endl;
+        for (const auto& [name, values] : classes)
+        {
+            output << std::left << std::setw(28) << name << std::right << std::setw(16) << values.first
+                << std::setw(9) << 100.0 * values.first / total << std::setw(18) << values.second << std::setw(9)
+                << (totalCycles == 0 ? 0.0 : 100.0 * values.second / totalCycles) << std::endl;
+        }
+
+        std::vector<std::pair<uint64_t, uint16_t>> pairs;
+        for (uint64_t i = 0; i < 256; ++i)
+            for (uint64_t j = 0; j < 256; ++j)
+                if (counters->pairs[i][j] != 0) pairs.emplace_back(counters->pairs[i][j], i << 8 | j);
+        std::ranges::sort(pairs, std::greater());
+        output << std::endl << std::left << std::setw(56) << "opcode pair" << std::right << std::setw(16) << "count"
+            << std::setw(9) << "%" << std::endl;
+        for (uint64_t i = 0; i < std::min<uint64_t>(TOP_PAIRS, pairs.size()); ++i)
+        {
+            const auto [count, pair] = pairs[i];
+            std::string name(getInstructionName(pair >> 8));
+            name += " -> ";
+            name += getInstructionName(pair & 0xff);
+            output << std::left << std::setw(56) << name << std::right << std::setw(16) << count << std::setw(9)
+                << 100.0 * count / total << std::endl;
+        }
+        output << std::endl << "total " << total << " instructions, " << totalCycles << " cycles" << std::endl;
+    }
+}
+#endif
@@ -0,0 +1,60 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+#ifdef LVM_INSTRUMENT_DISPATCH
+#include <cstdint>
+#include <ostream>
+#if defined(__x86_64__) || defined(_M_X64)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#else
+#include <chrono>
+#endif
+
+namespace lvm
+{
+    inline uint64_t readTimestamp()
+    {
+#if defined(__x86_64__) || defined(_M_X64)
+        return __rdtsc();
+#else
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+    }
+
+    // Per-thread counters for the instrumented build, merged into the global table when the thread finishes
+    class DispatchCounters
+    {
+    public:
+        uint64_t counts[256]{};
+        uint64_t pairs[256][256]{};
+        uint64_t cycles[256]{};
+        uint8_t previous = 0;
+        uint64_t lastTimestamp = 0;
+
+        // The time between two dispatches is charged to the instruction that ran in between
+        void record(const uint8_t code)
+        {
+            const uint64_t now = readTimestamp();
+            if (lastTimestamp != 0)
+            {
+                cycles[previous] += now - lastTimestamp;
+                ++pairs[previous][code];
+            }
+            ++counts[code];
+            previous = code;
+            lastTimestamp = now;
+        }
+    };
+
+    void mergeDispatchCounters(const DispatchCounters* counters);
+    void dumpDispatchCounters(std::ostream& output);
+}
+#endif
+#endif //INSTRUMENTATION_H
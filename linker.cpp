@@ -0,0 +1,207 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#include "linker.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <ranges>
+
+#include "bytes.h"
+#include "exception.h"
+#include "module.h"
+#include "vm.h"
+
+namespace lvm
+{
+    std::vector<uint8_t> LinkInfo::rawExports() const
+    {
+        std::vector<uint8_t> payload;
+        writeInteger(payload, exports.size(), 8);
+        for (const Export& symbol : exports)
+        {
+            writeInteger(payload, symbol.address, 8);
+            payload.insert(payload.end(), symbol.name.begin(), symbol.name.end());
+            payload.push_back(0);
+        }
+        return payload;
+    }
+
+    std::vector<uint8_t> LinkInfo::rawImports() const
+    {
+        std::vector<uint8_t> payload;
+        writeInteger(payload, imports.size(), 8);
+        for (const Import& symbol : imports)
+        {
+            payload.insert(payload.end(), symbol.name.begin(), symbol.name.end());
+            payload.push_back(0);
+            writeInteger(payload, symbol.sites.size(), 8);
+            for (const uint64_t site : symbol.sites) writeInteger(payload, site, 8);
+        }
+        return payload;
+    }
+
+    std::vector<uint8_t> LinkInfo::rawRelocations() const
+    {
+        std::vector<uint8_t> payload;
+        writeInteger(payload, relocations.size(), 8);
+        for (const uint64_t site : relocations) writeInteger(payload, site, 8);
+        return payload;
+    }
+
+    bool LinkInfo::readExports(const uint8_t* raw, const uint64_t length, const uint64_t imageLength)
+    {
+        ByteReader section(raw, length);
+        const uint64_t count = section.read(8);
+        std::vector<Export> read;
+        for (uint64_t i = 0; i < count && !section.failed; ++i)
+        {
+            Export symbol;
+            symbol.address = section.read(8);
+            symbol.name = section.readString();
+            if (symbol.address > imageLength) section.failed = true;
+            read.push_back(std::move(symbol));
+        }
+        if (section.failed) return false;
+        exports = std::move(read);
+        return true;
+    }
+
+    bool LinkInfo::readImports(const uint8_t* raw, const uint64_t length, const uint64_t imageLength)
+    {
+        ByteReader section(raw, length);
+        const uint64_t count = section.read(8);
+        std::vector<Import> read;
+        for (uint64_t i = 0; i < count && !section.failed; ++i)
+        {
+            Import symbol;
+            symbol.name = section.readString();
+            const uint64_t sites = section.read(8);
+            for (uint64_t j = 0; j < sites && !section.failed; ++j)
+            {
+                const uint64_t site = section.read(8);
+                if (imageLength < 8 || site > imageLength - 8) section.failed = true;
+                symbol.sites.push_back(site);
+            }
+            read.push_back(std::move(symbol));
+        }
+        if (section.failed) return false;
+        imports = std::move(read);
+        return true;
+    }
+
+    bool LinkInfo::readRelocations(const uint8_t* raw, const uint64_t length, const uint64_t imageLength)
+    {
+        ByteReader section(raw, length);
+        const uint64_t count = section.read(8);
+        std::vector<uint64_t> read;
+        for (uint64_t i = 0; i < count && !section.failed; ++i)
+        {
+            const uint64_t site = section.read(8);
+            if (imageLength < 8 || site > imageLength - 8) section.failed = true;
+            read.push_back(site);
+        }
+        if (section.failed) return false;
+        relocations = std::move(read);
+        return true;
+    }
+
+    Linker::Linker(Memory* memory) : memory(memory)
+    {
+    }
+
+    Linker::~Linker()
+    {
+        for (const auto& [library, base] : libraries | std::views::values) delete library;
+    }
+
+    void Linker::addModule(const Module* module, const uint64_t base)
+    {
+        std::lock_guard lock(_mutex);
+        link(module, base);
+    }
+
+    uint64_t Linker::load(const std::string& path, std::string* error)
+    {
+        std::lock_guard lock(_mutex);
+        std::error_code code;
+        std::string key = std::filesystem::weakly_canonical(path, code).string();
+        if (code) key = path;
+        if (const auto loaded = libraries.find(key); loaded != libraries.end()) return loaded->second.second;
+
+        Module* library = Module::fromFile(path, error);
+        if (library == nullptr) return LINK_FAILED;
+        const uint64_t length = library->textLength + library->rodataLength + library->dataLength +
+            library->bssLength;
+        uint64_t base;
+        try
+        {
+            // One spare page to start the library on a page boundary, so its read-only pages hold nothing else
+            base = memory->allocateMemoryWithoutHead(nullptr, length + memory->pageSize);
+        }
+        catch (const VMException&)
+        {
+            delete library;
+            if (error != nullptr) *error = "Out of memory";
+            return LINK_FAILED;
+        }
+        base = (base + memory->pageSize - 1) / memory->pageSize * memory->pageSize;
+        if (!memory->load(library, base))
+        {
+            delete library;
+            if (error != nullptr) *error = "Corrupt compressed section";
+            return LINK_FAILED;
+        }
+        link(library, base);
+        libraries[key] = {library, base};
+        return base;
+    }
+
+    void Linker::link(const Module* module, const uint64_t base)
+    {
+        const LinkInfo* linkInfo = module->linkInfo;
+        if (linkInfo == nullptr) return;
+        const uint64_t readonlyEnd = memory->getReadonlyEnd(module, base);
+        const auto* heap = static_cast<const uint8_t*>(memory->heap);
+        if (base != 0)
+        {
+            for (const uint64_t site : linkInfo->relocations)
+            {
+                uint64_t value;
+                memcpy(&value, heap + base + site, sizeof(value));
+                patch(base + site, value + base, readonlyEnd);
+            }
+        }
+        for (const Export& symbol : linkInfo->exports)
+        {
+            // The first module to export a name keeps it
+            if (!exports.emplace(symbol.name, base + symbol.address).second) continue;
+            const auto [first, last] = pendingImports.equal_range(symbol.name);
+            for (auto pending = first; pending != last; ++pending)
+                patch(pending->second.first, base + symbol.address, pending->second.second);
+            pendingImports.erase(first, last);
+        }
+        for (const Import& symbol : linkInfo->imports)
+        {
+            const auto resolved = exports.find(symbol.name);
+            for (const uint64_t site : symbol.sites)
+            {
+                patch(base + site, resolved != exports.end() ? resolved->second : LINK_UNRESOLVED, readonlyEnd);
+                if (resolved == exports.end())
+                    pendingImports.emplace(symbol.name, std::make_pair(base + site, readonlyEnd));
+            }
+        }
+    }
+
+    void Linker::patch(const uint64_t address, const uint64_t value, const uint64_t readonlyEnd) const
+    {
+        const auto host = reinterpret_cast<uint64_t>(memory->heap);
+        const uint64_t first = address / memory->pageSize * memory->pageSize;
+        const uint64_t last = (address + sizeof(value) + memory->pageSize - 1) / memory->pageSize * memory->pageSize;
+        if (address < readonlyEnd) Memory::setReadwrite(host + first, last - first);
+        memcpy(reinterpret_cast<void*>(host + address), &value, sizeof(value));
+        if (address < readonlyEnd) Memory::setReadonly(host + first, std::min(last, readonlyEnd) - first);
+    }
+}
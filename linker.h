@@ -0,0 +1,85 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#ifndef LINKER_H
+#define LINKER_H
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace lvm
+{
+    class Memory;
+    class Module;
+
+    // Versions of the export, import and relocation payloads, stored with their module sections
+    constexpr uint32_t LINK_EXPORTS_VERSION = 1;
+    constexpr uint32_t LINK_IMPORTS_VERSION = 1;
+    constexpr uint32_t LINK_RELOCATIONS_VERSION = 1;
+    // Returned by SYSCALL_LOAD_DYNAMIC_LIBRARY when the library cannot be loaded
+    constexpr uint64_t LINK_FAILED = ~0ULL;
+    // Held by an import until a module exporting it is loaded, so that calling it faults instead of running address 0
+    constexpr uint64_t LINK_UNRESOLVED = ~0ULL;
+
+    class Export
+    {
+    public:
+        std::string name;
+        uint64_t address; // relative to the start of the module's text
+    };
+
+    class Import
+    {
+    public:
+        std::string name;
+        // Module offsets of the 8 byte slots that receive the address of the symbol
+        std::vector<uint64_t> sites;
+    };
+
+    class LinkInfo
+    {
+    public:
+        std::vector<Export> exports;
+        std::vector<Import> imports;
+        // Module offsets of the 8 byte module addresses that get the load address added
+        std::vector<uint64_t> relocations;
+
+        [[nodiscard]] std::vector<uint8_t> rawExports() const;
+        [[nodiscard]] std::vector<uint8_t> rawImports() const;
+        [[nodiscard]] std::vector<uint8_t> rawRelocations() const;
+        // All three leave the tables untouched and return false on a malformed payload or a site past imageLength
+        bool readExports(const uint8_t* raw, uint64_t length, uint64_t imageLength);
+        bool readImports(const uint8_t* raw, uint64_t length, uint64_t imageLength);
+        bool readRelocations(const uint8_t* raw, uint64_t length, uint64_t imageLength);
+    };
+
+    // Links the modules of one VM. Relocations and imports are patched into the loaded images once, at load time, so
+    // a call into a library is an ordinary INVOKE of an immediate address. An import that no module exports yet holds
+    // LINK_UNRESOLVED until a library that exports it is loaded.
+    class Linker
+    {
+    public:
+        explicit Linker(Memory* memory);
+        ~Linker();
+        // The main module, already placed at base by Memory::init
+        void addModule(const Module* module, uint64_t base);
+        // Loads the library at path into fresh heap pages, once per path, with its text and rodata read-only; its
+        // base address, or LINK_FAILED with the reason in error
+        uint64_t load(const std::string& path, std::string* error = nullptr);
+
+    private:
+        Memory* memory;
+        std::map<std::string, uint64_t> exports;
+        // Import sites still waiting for an export, with the end of the read-only part of their module
+        std::multimap<std::string, std::pair<uint64_t, uint64_t>> pendingImports;
+        std::map<std::string, std::pair<Module*, uint64_t>> libraries;
+        std::mutex _mutex;
+
+        void link(const Module* module, uint64_t base);
+        void patch(uint64_t address, uint64_t value, uint64_t readonlyEnd) const;
+    };
+}
+#endif //LINKER_H
@@ -0,0 +1,139 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#include "lz4.h"
+
+#include <cstring>
+
+namespace lvm
+{
+    constexpr uint64_t LZ4_MIN_MATCH = 4;
+    // The last match has to start this far from the end and the block always ends with this many literals
+    constexpr uint64_t LZ4_MATCH_LIMIT = 12;
+    constexpr uint64_t LZ4_LAST_LITERALS = 5;
+    constexpr uint64_t LZ4_MAX_OFFSET = 65535;
+    constexpr uint64_t LZ4_HASH_BITS = 16;
+
+    uint32_t load32(const uint8_t* p)
+    {
+        uint32_t value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    void writeLength(std::vector<uint8_t>& output, uint64_t length)
+    {
+        for (; length >= 255; length -= 255) output.push_back(255);
+        output.push_back(length);
+    }
+
+    void writeSequence(std::vector<uint8_t>& output, const uint8_t* literals, const uint64_t literalLength,
+                       const uint64_t offset, const uint64_t matchLength)
+    {
+        const uint64_t extraMatch = matchLength - LZ4_MIN_MATCH;
+        output.push_back((literalLength < 15 ? literalLength : 15) << 4 | (extraMatch < 15 ? extraMatch : 15));
+        if (literalLength >= 15) writeLength(output, literalLength - 15);
+        output.insert(output.end(), literals, literals + literalLength);
+        output.push_back(offset);
+        output.push_back(offset >> 8);
+        if (extraMatch >= 15) writeLength(output, extraMatch - 15);
+    }
+
+    std::vector<uint8_t> lz4Compress(const uint8_t* source, const uint64_t length)
+    {
+        std::vector<uint8_t> output;
+        output.reserve(length / 2 + 16);
+        uint64_t anchor = 0;
+        if (length > LZ4_MATCH_LIMIT)
+        {
+            // Position + 1 of the last 4 bytes that hashed to each slot
+            std::vector<uint64_t> table(1 << LZ4_HASH_BITS);
+            const uint64_t matchLimit = length - LZ4_MATCH_LIMIT;
+            const uint64_t matchEnd = length - LZ4_LAST_LITERALS;
+            uint64_t i = 0;
+            while (i < matchLimit)
+            {
+                const uint32_t sequence = load32(source + i);
+                const uint32_t hash = sequence * 2654435761u >> (32 - LZ4_HASH_BITS);
+                const uint64_t candidate = table[hash];
+                table[hash] = i + 1;
+                if (candidate == 0 || i - (candidate - 1) > LZ4_MAX_OFFSET ||
+                    load32(source + candidate - 1) != sequence)
+                {
+                    // Step faster through data that keeps failing to match
+                    i += 1 + ((i - anchor) >> 6);
+                    continue;
+                }
+                uint64_t match = candidate - 1;
+                uint64_t matchLength = LZ4_MIN_MATCH;
+                while (i + matchLength < matchEnd && source[match + matchLength] == source[i + matchLength])
+                    ++matchLength;
+                while (i > anchor && match > 0 && source[i - 1] == source[match - 1])
+                {
+                    --i;
+                    --match;
+                    ++matchLength;
+                }
+                writeSequence(output, source + anchor, i - anchor, i - match, matchLength);
+                i += matchLength;
+                anchor = i;
+            }
+        }
+        const uint64_t literalLength = length - anchor;
+        output.push_back((literalLength < 15 ? literalLength : 15) << 4);
+        if (literalLength >= 15) writeLength(output, literalLength - 15);
+        output.insert(output.end(), source + anchor, source + length);
+        return output;
+    }
+
+    bool lz4Decompress(const uint8_t* source, const uint64_t sourceLength, uint8_t* destination, const uint64_t length)
+    {
+        uint64_t in = 0;
+        uint64_t out = 0;
+        const auto readLength = [&](uint64_t& value)
+        {
+            if (value != 15) return true;
+            uint8_t byte;
+            do
+            {
+                if (in == sourceLength) return false;
+                byte = source[in++];
+                value += byte;
+            }
+            while (byte == 255);
+            return true;
+        };
+        while (in < sourceLength)
+        {
+            const uint8_t token = source[in++];
+            uint64_t literalLength = token >> 4;
+            if (!readLength(literalLength) || literalLength > sourceLength - in || literalLength > length - out)
+                return false;
+            memcpy(destination + out, source + in, literalLength);
+            in += literalLength;
+            out += literalLength;
+            // Only the last sequence ends after its literals
+            if (in == sourceLength) break;
+            if (sourceLength - in < 2) return false;
+            const uint64_t offset = source[in] | source[in + 1] << 8;
+            in += 2;
+            uint64_t matchLength = token & 15;
+            if (offset == 0 || offset > out || !readLength(matchLength)) return false;
+            matchLength += LZ4_MIN_MATCH;
+            if (matchLength > length - out) return false;
+            const uint8_t* match = destination + out - offset;
+            if (offset >= matchLength)
+            {
+                memcpy(destination + out, match, matchLength);
+            }
+            else
+            {
+                // Overlapping copy repeats the last offset bytes
+                for (uint64_t i = 0; i < matchLength; ++i) destination[out + i] = match[i];
+            }
+            out += matchLength;
+        }
+        return out == length;
+    }
+}
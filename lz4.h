@@ -0,0 +1,19 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#ifndef LZ4_H
+#define LZ4_H
+#include <cstdint>
+#include <vector>
+
+namespace lvm
+{
+    // LZ4 block format, without the frame around it. Literal runs and matches of at least 4 bytes at most 64 KB back,
+    // so the decoder is a tight copy loop that writes straight into its destination.
+    std::vector<uint8_t> lz4Compress(const uint8_t* source, uint64_t length);
+    // Fills exactly length bytes of destination; false if the block is malformed, would write or read out of bounds,
+    // or does not add up to length
+    bool lz4Decompress(const uint8_t* source, uint64_t sourceLength, uint8_t* destination, uint64_t length);
+}
+#endif //LZ4_H
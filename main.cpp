@@ -1,38 +1,19 @@
+#include <chrono>
+#include <fstream>
 #include <iostream>
 #include <argparse/argparse.hpp>
 
+#include "aot.h"
+#include "instrumentation.h"
+#include "perfmap.h"
+#include "profiler.h"
+#include "statistics.h"
+#include "tracer.h"
 #include "vm.h"
 
-int read_file_to_buffer(const std::string& path, uint8_t*& raw, size_t& size)
+uint64_t nanosecondsSince(const std::chrono::steady_clock::time_point start)
 {
-    FILE* file = fopen(path.c_str(), "rb");
-    if (!file)
-    {
-        return -1;
-    }
-
-    fseek(file, 0, SEEK_END);
-    size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-
-    raw = static_cast<uint8_t*>(malloc(size));
-    if (!raw)
-    {
-        fclose(file);
-        return -2;
-    }
-
-    const size_t bytes_read = fread(raw, 1, size, file);
-    fclose(file);
-
-    if (bytes_read != size)
-    {
-        free(raw);
-        raw = nullptr;
-        return -3;
-    }
-
-    return 0;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
 }
 
 int main(int argc, const char** argv)
@@ -44,11 +25,51 @@ int main(int argc, const char** argv)
            .required();
     // .default_value("t.lvme");
     program.add_argument("--stack-size", "-s")
-           .help("Stack size")
+           .help("Maximum stack size of a thread")
            .default_value(lvm::DEFAULT_STACK_SIZE);
+    program.add_argument("--stack-area-size")
+           .help("Address range reserved for all thread stacks")
+           .default_value(lvm::DEFAULT_STACK_AREA_SIZE);
     program.add_argument("--memory-size", "-m")
            .help("Memory size")
            .default_value(lvm::DEFAULT_MEMORY_SIZE);
+    program.add_argument("--hardened")
+           .help("Mask guest addresses into a guarded reservation and report bad accesses as page errors")
+           .default_value(false)
+           .implicit_value(true);
+    program.add_argument("--scavenge-threshold")
+           .help("Bytes freed before free pages are returned to the OS (0 disables)")
+           .default_value(lvm::DEFAULT_SCAVENGE_THRESHOLD);
+    program.add_argument("--profile")
+           .help("Sample guest threads and write collapsed stacks to this file at exit")
+           .default_value(std::string(""));
+    program.add_argument("--profile-frequency")
+           .help("Profiler samples per second of CPU time")
+           .default_value(lvm::DEFAULT_PROFILE_FREQUENCY);
+    program.add_argument("--perf-map")
+           .help("Write /tmp/perf-<pid>.map naming guest functions at synthetic addresses")
+           .default_value(false)
+           .implicit_value(true);
+    program.add_argument("--perf-tag")
+           .help("Run threads under a trampoline so perf call graphs end in the current guest function")
+           .default_value(false)
+           .implicit_value(true);
+    program.add_argument("--trace")
+           .help("Record guest function entries and exits and write them as Chrome trace events to this file")
+           .default_value(std::string(""));
+    program.add_argument("--aot")
+           .help("Run hot loops in this shared object built by lvm-aot, if it was compiled from the same module")
+           .default_value(std::string(""));
+    program.add_argument("--osr-threshold")
+           .help("Back edges to a loop before it is entered in compiled code")
+           .default_value(lvm::DEFAULT_OSR_THRESHOLD);
+    program.add_argument("--stats")
+           .help("Print timings, instructions retired and memory statistics to stderr at exit")
+           .default_value(false)
+           .implicit_value(true);
+    program.add_argument("--stats-json")
+           .help("Write the --stats report as JSON to this file")
+           .default_value(std::string(""));
     try
     {
         program.parse_args(argc, argv);
@@ -59,31 +80,105 @@ int main(int argc, const char** argv)
         std::cerr << program;
         return 1;
     }
-    auto* vm = new lvm::VirtualMachine(program.get<uint64_t>("--memory-size"), program.get<uint64_t>("--stack-size"));
+    auto* vm = new lvm::VirtualMachine(program.get<uint64_t>("--memory-size"), program.get<uint64_t>("--stack-size"),
+                                       program.get<bool>("--hardened"), program.get<uint64_t>("--stack-area-size"));
     lvm::currentVirtualMachine = vm;
+    vm->memory->scavengeThreshold = program.get<uint64_t>("--scavenge-threshold");
+    lvm::Statistics statistics;
+    auto start = std::chrono::steady_clock::now();
     const std::string path = program.get("file");
-    uint8_t* raw = nullptr;
-    size_t size = 0;
-    if (read_file_to_buffer(path, raw, size) != 0)
+    std::string error;
+    lvm::Module* module = lvm::Module::fromFile(path, &error);
+    if (module == nullptr)
+    {
+        std::cerr << path << ": " << error << std::endl;
+        return 1;
+    }
+    // Symbols and lines are only read when something is going to print guest addresses
+    if (!program.get("--profile").empty() || !program.get("--trace").empty() || program.get<bool>("--perf-map") ||
+        program.get<bool>("--perf-tag"))
+        module->loadDebugInfo();
+    statistics.loadTime = nanosecondsSince(start);
+    start = std::chrono::steady_clock::now();
+    if (vm->init(module) != 0)
     {
-        std::cerr << "Failed to read file" << std::endl;
+        std::cerr << path << ": Corrupt compressed section" << std::endl;
         return 1;
     }
-    const lvm::Module* module = lvm::Module::fromRaw(raw);
-    free(raw);
-    // const auto start = std::chrono::high_resolution_clock::now();
-    vm->init(module);
-    // const auto end = std::chrono::high_resolution_clock::now();
-    // const auto duration1 = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-    // std::cout << "Init time: " << duration1.count() << " us" << std::endl;
-    // const auto rStart = std::chrono::high_resolution_clock::now();
+    statistics.initTime = nanosecondsSince(start);
+    vm->osrThreshold = program.get<uint64_t>("--osr-threshold");
+    if (const std::string aotPath = program.get("--aot"); !aotPath.empty())
+    {
+        // The main module is loaded at address 0, the hash check is against the text as it is in the heap
+        vm->tier = lvm::AotTier::load(aotPath, module, static_cast<const uint8_t*>(vm->memory->heap), &error);
+        if (vm->tier == nullptr) std::cerr << aotPath << ": " << error << ", running interpreted" << std::endl;
+        // Nothing is compiled at run time, so a loop is worth entering on its first back edge
+        else if (!program.is_used("--osr-threshold")) vm->osrThreshold = 1;
+    }
+    lvm::PerfMap* perfMap = nullptr;
+    if (program.get<bool>("--perf-tag") && lvm::isShadowStackEnabled())
+    {
+        std::cerr << "--perf-tag rewrites return addresses and cannot run with CET shadow stacks enabled" << std::endl;
+        return 1;
+    }
+    if (program.get<bool>("--perf-map") || program.get<bool>("--perf-tag"))
+    {
+        // The perf map walks the text for function starts, which a compressed module only has in the heap so far
+        module->unpack();
+        perfMap = new lvm::PerfMap(module, program.get<bool>("--perf-tag"));
+        if (!perfMap->isSupported() || !perfMap->write())
+        {
+            std::cerr << "Failed to write perf map" << std::endl;
+            return 1;
+        }
+        lvm::currentPerfMap = perfMap;
+    }
+    const std::string profilePath = program.get("--profile");
+    lvm::Profiler* profiler = nullptr;
+    if (!profilePath.empty())
+    {
+        profiler = new lvm::Profiler(vm, program.get<uint64_t>("--profile-frequency"));
+        if (!profiler->start()) return 1;
+    }
+    const std::string tracePath = program.get("--trace");
+    lvm::Tracer* tracer = nullptr;
+    if (!tracePath.empty())
+    {
+        tracer = new lvm::Tracer(tracePath, vm->debugInfo);
+        if (!tracer->start()) return 1;
+    }
+    start = std::chrono::steady_clock::now();
     vm->run();
-    // const auto rEnd = std::chrono::high_resolution_clock::now();
-    // const auto duration2 = std::chrono::duration_cast<std::chrono::microseconds>(rEnd - rStart);
-    // std::cout << "Execution time: " << duration2.count() << " us" << std::endl;
-    // const auto duration3 = std::chrono::duration_cast<std::chrono::microseconds>(duration2 + duration1);
-    // std::cout << "Total time: " << duration3.count() << " us" << std::endl;
+    statistics.runTime = nanosecondsSince(start);
+    // Threads still running after an EXIT keep recording into their trace buffers, only nothing drains them any more
+    if (tracer != nullptr) tracer->stop();
+    const bool threadsRunning = vm->hasRunningThreads();
+#ifdef LVM_INSTRUMENT_DISPATCH
+    lvm::dumpDispatchCounters(std::cerr);
+#endif
+    if (profiler != nullptr)
+    {
+        profiler->stop();
+        profiler->writeCollapsed(profilePath);
+        delete profiler;
+    }
+    const std::string statsPath = program.get("--stats-json");
+    if (program.get<bool>("--stats") || !statsPath.empty())
+    {
+        statistics.collect(vm);
+        if (program.get<bool>("--stats")) statistics.writeText(std::cerr);
+        if (!statsPath.empty())
+        {
+            std::ofstream output(statsPath);
+            statistics.writeJson(output);
+        }
+    }
+    // Those threads still use the VM, its tier, their trace buffers and the perf stubs, which end with the process
+    if (threadsRunning) return 0;
     vm->destroy();
+    lvm::currentPerfMap = nullptr;
+    delete perfMap;
+    delete tracer;
     delete vm;
     delete module;
     return 0;
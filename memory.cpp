@@ -2,6 +2,8 @@
 // Created by XiaoLi on 25-8-14.
 //
 
+#include <algorithm>
+#include <bit>
 #include <iostream>
 
 #include "bytecode.h"
@@ -14,6 +16,7 @@
 #include <sys/mman.h>
 #include <setjmp.h>
 #include <errno.h>
+#include <unistd.h>
 #endif
 
 
@@ -27,9 +30,11 @@ namespace lvm
             auto faultAddress = reinterpret_cast<void*>(ExceptionInfo->ExceptionRecord->ExceptionInformation[1]);
 
             Memory* memory = currentVirtualMachine->memory;
+            ++memory->pageFaults;
 
             if (faultAddress >= memory->heap &&
-                faultAddress < reinterpret_cast<void*>(reinterpret_cast<int64_t>(memory->heap) + memory->heapSize))
+                faultAddress < reinterpret_cast<void*>(reinterpret_cast<int64_t>(memory->heap) +
+                    memory->stackAreaStart + memory->stackAreaSize))
             {
                 MEMORY_BASIC_INFORMATION mbi;
                 if (VirtualQuery(faultAddress, &mbi, sizeof(mbi)))
@@ -49,6 +54,7 @@ namespace lvm
                                          PAGE_READWRITE))
                         {
                             memset(pageBase, 0, pageSize);
+                            memory->addCommittedPages(1);
                             return EXCEPTION_CONTINUE_EXECUTION;
                         }
                     }
@@ -79,9 +85,21 @@ namespace lvm
         AddVectoredExceptionHandler(1, pageFaultHandler);
     }
 
-    Memory::Memory(const uint64_t heapSize) : heapSize(heapSize)
+    Memory::Memory(const uint64_t heapSize, const bool hardened, const uint64_t stackSize,
+                   const uint64_t stackAreaSize) : heapSize(heapSize), stackAreaSize(stackAreaSize)
     {
-        heap = VirtualAlloc(nullptr, heapSize, MEM_RESERVE, PAGE_NOACCESS);
+        SYSTEM_INFO sysInfo;
+        GetSystemInfo(&sysInfo);
+        pageSize = sysInfo.dwPageSize;
+        stackAreaStart = (heapSize + pageSize - 1) / pageSize * pageSize;
+        stackSlotSize = getStackGuardSize() + (stackSize + pageSize - 1) / pageSize * pageSize;
+        reservedSize = stackAreaStart + stackAreaSize;
+        if (hardened)
+        {
+            addressMask = std::bit_ceil(reservedSize + 1) - 1;
+            reservedSize = addressMask + 1 + GUARD_REGION_SIZE;
+        }
+        heap = VirtualAlloc(nullptr, reservedSize, MEM_RESERVE, PAGE_NOACCESS);
         if (!heap)
         {
             printf("Failed to reserve memory space\n");
@@ -103,31 +121,98 @@ namespace lvm
         DWORD oldProtection;
         return VirtualProtect(reinterpret_cast<void*>(address), size + 8, PAGE_READWRITE, &oldProtection);
     }
+
+    bool Memory::setNoAccess(uint64_t address, uint64_t size)
+    {
+        // Committed no-access pages are left alone by pageFaultHandler, so a hit on them stays fatal
+        return VirtualAlloc(reinterpret_cast<void*>(address), size, MEM_COMMIT, PAGE_NOACCESS) != nullptr;
+    }
+
+    void Memory::markCommitted(uint64_t address, uint64_t size)
+    {
+        // Pages are committed lazily by pageFaultHandler, which also does the accounting
+    }
+
+    void Memory::markGuard(uint64_t address, uint64_t size)
+    {
+        setNoAccess(reinterpret_cast<uint64_t>(heap) + address, size);
+    }
+
+    uint64_t Memory::releasePages(const uint64_t start, const uint64_t end)
+    {
+        uint64_t released = 0;
+        uint64_t offset = start;
+        while (offset < end)
+        {
+            void* address = static_cast<char*>(heap) + offset;
+            MEMORY_BASIC_INFORMATION mbi;
+            if (!VirtualQuery(address, &mbi, sizeof(mbi))) break;
+            const uint64_t length = std::min<uint64_t>(mbi.RegionSize, end - offset);
+            if (mbi.State == MEM_COMMIT && VirtualFree(address, length, MEM_DECOMMIT))
+            {
+                released += length / pageSize;
+            }
+            offset += length;
+        }
+        return released;
+    }
 #else
     void PageFaultHandler(int sig, siginfo_t* info, void* context)
     {
-        if (sig == SIGSEGV)
+        void* faultAddress = info->si_addr;
+        const Memory* reservation = currentVirtualMachine == nullptr ? nullptr : currentVirtualMachine->memory;
+        const bool inReservation = reservation != nullptr && faultAddress >= reservation->heap &&
+            faultAddress < static_cast<char*>(reservation->heap) + reservation->reservedSize;
+        // Without hardening guest addresses are not masked into the reservation, so a fault of a guest instruction
+        // can land anywhere. Host code, in a SYSCALL, INVOKE_NATIVE or the allocator, may hold locks a guest
+        // interrupt would never release, none of its faults go to the guest
+        const bool guestAccess = currentExecutionUnit != nullptr && !currentExecutionUnit->inHostCall;
+        if (sig == SIGSEGV && inReservation)
         {
-            void* faultAddress = info->si_addr;
-            const Memory* memory = currentVirtualMachine->memory;
+            Memory* memory = currentVirtualMachine->memory;
+            ++memory->pageFaults;
 
-            if (faultAddress >= memory->heap &&
-                faultAddress < reinterpret_cast<void*>(reinterpret_cast<int64_t>(memory->heap) + memory->heapSize))
+            if (faultAddress < reinterpret_cast<void*>(reinterpret_cast<int64_t>(memory->heap) +
+                memory->stackAreaStart + memory->stackAreaSize))
             {
                 void* pageBase = reinterpret_cast<void*>((size_t)faultAddress & ~(PAGE_SIZE - 1));
                 size_t pageIndex = ((char*)pageBase - (char*)memory->heap) / PAGE_SIZE;
-                if (!((bool*)memory->metadata)[pageIndex])
+                auto* pages = static_cast<uint8_t*>(memory->metadata);
+                if (pages[pageIndex] == Memory::PAGE_RESERVED)
                 {
                     if (mprotect(pageBase, PAGE_SIZE, PROT_READ | PROT_WRITE) == 0)
                     {
-                        ((bool*)memory->metadata)[pageIndex] = true;
+                        pages[pageIndex] = Memory::PAGE_COMMITTED;
                         memset(pageBase, 0, PAGE_SIZE);
+                        memory->addCommittedPages(1);
                         return;
                     }
                 }
+                else if (guestAccess && pages[pageIndex] == Memory::PAGE_YELLOW_GUARD)
+                {
+                    // Lend the top guard page to the guest so that its overflow handler has a stack to run on
+                    if (mprotect(pageBase, PAGE_SIZE, PROT_READ | PROT_WRITE) == 0)
+                    {
+                        currentExecutionUnit->disarmedGuard = (char*)pageBase - (char*)memory->heap;
+                        siglongjmp(env, bytecode::INTERRUPT_STACK_OVERFLOW + 1);
+                    }
+                }
+                else if (guestAccess && pages[pageIndex] == Memory::PAGE_GUARD)
+                {
+                    siglongjmp(env, FATAL_FAULT);
+                }
             }
         }
 
+        // Any other fault while a guest instruction runs is the guest's, resume it in its IDT. Division traps instead
+        // of testing every divisor, so DIV and MOD cost no more than the host division
+        if (guestAccess)
+        {
+            siglongjmp(env, (sig == SIGFPE ? bytecode::INTERRUPT_DIVIDE_BY_ZERO : bytecode::INTERRUPT_PAGE_ERROR) + 1);
+        }
+
+        constexpr char message[] = "lvm: fault in host code\n";
+        write(STDERR_FILENO, message, sizeof(message) - 1);
         signal(sig, SIG_DFL);
         raise(sig);
     }
@@ -139,16 +224,28 @@ namespace lvm
         sigemptyset(&sa.sa_mask);
         sa.sa_flags = SA_SIGINFO;
 
-        if (sigaction(SIGSEGV, &sa, nullptr) == -1)
+        for (const int sig : {SIGSEGV, SIGBUS, SIGFPE})
         {
-            perror("Failed to install signal handler");
-            exit(EXIT_FAILURE);
+            if (sigaction(sig, &sa, nullptr) == -1)
+            {
+                perror("Failed to install signal handler");
+                exit(EXIT_FAILURE);
+            }
         }
     }
 
-    Memory::Memory(uint64_t heapSize) : heapSize(heapSize)
+    Memory::Memory(uint64_t heapSize, const bool hardened, const uint64_t stackSize, const uint64_t stackAreaSize) :
+        heapSize(heapSize), pageSize(PAGE_SIZE), stackAreaSize(stackAreaSize)
     {
-        heap = mmap(NULL, heapSize,PROT_NONE,MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        stackAreaStart = (heapSize + pageSize - 1) / pageSize * pageSize;
+        stackSlotSize = getStackGuardSize() + (stackSize + pageSize - 1) / pageSize * pageSize;
+        reservedSize = stackAreaStart + stackAreaSize;
+        if (hardened)
+        {
+            addressMask = std::bit_ceil(reservedSize + 1) - 1;
+            reservedSize = addressMask + 1 + GUARD_REGION_SIZE;
+        }
+        heap = mmap(NULL, reservedSize,PROT_NONE,MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
 
         if (heap == MAP_FAILED)
         {
@@ -156,7 +253,7 @@ namespace lvm
             exit(EXIT_FAILURE);
         }
 
-        this->metadata = calloc(heapSize / PAGE_SIZE, sizeof(uint8_t));
+        this->metadata = calloc((stackAreaStart + stackAreaSize) / PAGE_SIZE, sizeof(uint8_t));
         if (!this->metadata)
         {
             perror("Failed to allocate metadata");
@@ -194,41 +291,153 @@ namespace lvm
         return true;
     }
 
-#endif
+    bool Memory::setNoAccess(uint64_t address, uint64_t size)
+    {
+        size = (size + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+        void* pageBase = (void*)(address & ~(PAGE_SIZE - 1));
 
+        if (mprotect(pageBase, size, PROT_NONE) == -1)
+        {
+            perror("mprotect failed");
+            return false;
+        }
+        return true;
+    }
 
-    void Memory::init(const uint8_t* text, const uint64_t textLength, const uint8_t* rodata,
-                      const uint64_t rodataLength, const uint8_t* data, const uint64_t dataLength,
-                      const uint64_t bssLength)
+    void Memory::markCommitted(const uint64_t address, const uint64_t size)
     {
-        const uint64_t textPtr = reinterpret_cast<uint64_t>(heap) + allocateMemoryWithoutHead(nullptr, textLength);
-        memcpy(reinterpret_cast<void*>(textPtr), text, textLength);
+        if (size == 0) return;
+        auto* pages = static_cast<uint8_t*>(metadata);
+        for (uint64_t page = address / pageSize; page <= (address + size - 1) / pageSize; ++page)
+        {
+            if (pages[page] != PAGE_COMMITTED)
+            {
+                pages[page] = PAGE_COMMITTED;
+                addCommittedPages(1);
+            }
+        }
+    }
 
-        const uint64_t rodataPtr = reinterpret_cast<uint64_t>(heap) + allocateMemoryWithoutHead(nullptr, rodataLength);
-        memcpy(reinterpret_cast<void*>(rodataPtr), rodata, rodataLength);
+    void Memory::markGuard(const uint64_t address, const uint64_t size)
+    {
+        auto* pages = static_cast<uint8_t*>(metadata);
+        const uint64_t first = address / pageSize;
+        const uint64_t last = (address + size) / pageSize;
+        void* pageBase = static_cast<char*>(heap) + address;
+        if (!setNoAccess(reinterpret_cast<uint64_t>(pageBase), size)) return;
+        madvise(pageBase, size, MADV_DONTNEED);
+        for (uint64_t page = first; page < last; ++page)
+        {
+            if (pages[page] == PAGE_COMMITTED) --committedPages;
+            pages[page] = PAGE_GUARD;
+        }
+        // The top guard page is the yellow zone, a hit on it is reported to the guest, anything below stops the thread
+        pages[last - 1] = PAGE_YELLOW_GUARD;
+    }
+
+    uint64_t Memory::releasePages(const uint64_t start, const uint64_t end)
+    {
+        auto* pages = static_cast<uint8_t*>(metadata);
+        uint64_t released = 0;
+        uint64_t page = start / pageSize;
+        const uint64_t last = end / pageSize;
+        while (page < last)
+        {
+            if (pages[page] != PAGE_COMMITTED)
+            {
+                ++page;
+                continue;
+            }
+            const uint64_t first = page;
+            while (page < last && pages[page] == PAGE_COMMITTED) ++page;
+            void* address = static_cast<char*>(heap) + first * pageSize;
+            const uint64_t length = (page - first) * pageSize;
+            // PROT_NONE first so that PageFaultHandler re-commits the pages on their next use
+            if (mprotect(address, length, PROT_NONE) == -1)
+            {
+                perror("mprotect failed");
+                continue;
+            }
+            madvise(address, length, MADV_DONTNEED);
+            std::fill(pages + first, pages + page, PAGE_RESERVED);
+            released += page - first;
+        }
+        return released;
+    }
 
-        const uint64_t dataPtr = reinterpret_cast<uint64_t>(heap) + allocateMemoryWithoutHead(nullptr, dataLength);
-        memcpy(reinterpret_cast<void*>(dataPtr), data, dataLength);
+#endif
 
-        const uint64_t bssPtr = reinterpret_cast<uint64_t>(heap) + allocateMemoryWithoutHead(nullptr, bssLength);
 
-        setReadonly(textPtr, textLength);
-        setReadonly(rodataPtr, rodataLength);
-        setReadwrite(dataPtr, dataLength);
-        setReadwrite(bssPtr, bssLength);
+    Memory::~Memory()
+    {
+#ifdef  __WIN32
+        VirtualFree(heap, 0, MEM_RELEASE);
+#else
+        munmap(heap, reservedSize);
+        free(metadata);
+#endif
+        delete freeMemoryList;
     }
 
+    bool Memory::init(const Module* module)
+    {
+        const uint64_t textOffset = allocateMemoryWithoutHead(nullptr, module->textLength);
+        allocateMemoryWithoutHead(nullptr, module->rodataLength);
+        allocateMemoryWithoutHead(nullptr, module->dataLength);
+        allocateMemoryWithoutHead(nullptr, module->bssLength);
+        return load(module, textOffset);
+    }
+
+    bool Memory::load(const Module* module, const uint64_t address)
+    {
+        // Sections are unpacked straight into their place in the heap, compressed ones without a staging buffer
+        const uint64_t length = module->textLength + module->rodataLength + module->dataLength + module->bssLength;
+        const uint64_t base = reinterpret_cast<uint64_t>(heap);
+        auto* destination = reinterpret_cast<uint8_t*>(base + address);
+        setReadwrite(base + address, length);
+        if (!module->unpackSection(MODULE_TEXT, destination) ||
+            !module->unpackSection(MODULE_RODATA, destination + module->textLength) ||
+            !module->unpackSection(MODULE_DATA, destination + module->textLength + module->rodataLength))
+            return false;
+        if (const uint64_t readonlyEnd = getReadonlyEnd(module, address); readonlyEnd > address)
+            setReadonly(base + address, readonlyEnd - address);
+        markCommitted(address, length);
+        return true;
+    }
+
+    uint64_t Memory::getReadonlyEnd(const Module* module, const uint64_t address) const
+    {
+        return std::max(address, (address + module->textLength + module->rodataLength) / pageSize * pageSize);
+    }
+
+
+    // Depth of _lock held by the current thread, so a faulting atomic instruction can give it back
+    thread_local uint64_t heldLocks = 0;
 
     void Memory::lock()
     {
         this->_lock.lock();
+        ++heldLocks;
     }
 
     void Memory::unlock()
     {
+        --heldLocks;
         this->_lock.unlock();
     }
 
+    void Memory::releaseLocks()
+    {
+        while (heldLocks > 0) unlock();
+    }
+
+    bool Memory::contains(const uint64_t address, const uint64_t size) const
+    {
+        if (address >= stackAreaStart)
+            return address <= stackAreaStart + stackAreaSize && size <= stackAreaStart + stackAreaSize - address;
+        return address <= heapSize && size <= heapSize - address;
+    }
+
     uint64_t Memory::allocateMemory(ThreadHandle* threadHandle, const uint64_t size)
     {
         std::lock_guard lock(_mutex);
@@ -242,7 +451,11 @@ namespace lvm
                 freeMemory->start += length;
                 const uint64_t ptr = reinterpret_cast<uint64_t>(heap) + start;
                 setReadwrite(ptr, length);
+                markCommitted(start, length);
                 *reinterpret_cast<uint64_t*>(ptr) = size;
+                usedSize += length;
+                ++allocations;
+                allocatedBytes += size;
                 return start + 8;
             }
             freeMemory = freeMemory->next;
@@ -250,51 +463,64 @@ namespace lvm
         throw VMException("Out of memory");
     }
 
-    uint64_t Memory::reallocateMemory(ThreadHandle* threadHandle, uint64_t address, uint64_t newSize)
+    bool Memory::getBlockSize(const uint64_t address, uint64_t* size) const
+    {
+        // The header is the guest's to overwrite, so the size it holds has to keep the block inside the heap
+        if (address < 8 || address > heapSize) return false;
+        *size = *reinterpret_cast<uint64_t*>(reinterpret_cast<uint64_t>(heap) + address - 8);
+        return *size <= heapSize - address;
+    }
+
+    bool Memory::reallocateMemory(ThreadHandle* threadHandle, const uint64_t address, const uint64_t newSize,
+                                  uint64_t* newAddress)
     {
         std::lock_guard lock(_mutex);
+        uint64_t oldSize;
+        if (!getBlockSize(address, &oldSize)) return false;
         const auto heap = reinterpret_cast<uint64_t>(this->heap);
-        const uint64_t oldSize = *reinterpret_cast<uint64_t*>(heap + address - 8);
-        auto* bytes = new uint8_t[oldSize];
-        memcpy(bytes, reinterpret_cast<void*>(heap + address), oldSize);
+        *newAddress = this->allocateMemory(threadHandle, newSize);
+        memmove(reinterpret_cast<void*>(heap + *newAddress), reinterpret_cast<void*>(heap + address),
+                std::min(oldSize, newSize));
         this->freeMemory(threadHandle, address);
-        const uint64_t newAddress = this->allocateMemory(threadHandle, newSize);
-        memcpy(reinterpret_cast<void*>(heap + newAddress), bytes, std::min(oldSize, newSize));
-        delete[] bytes;
-        return newAddress;
+        return true;
     }
 
-    void Memory::freeMemory(ThreadHandle* threadHandle, uint64_t address)
+    bool Memory::freeMemory(ThreadHandle* threadHandle, uint64_t address)
     {
         std::lock_guard lock(_mutex);
+        uint64_t size;
+        if (!getBlockSize(address, &size)) return false;
         address -= 8;
-        const uint64_t size = *reinterpret_cast<uint64_t*>(reinterpret_cast<uint64_t>(heap) + address) + 8;
-        FreeMemory* freeMemory = this->freeMemoryList->next;
-        while (freeMemory->next != nullptr)
+        const uint64_t end = address + size + 8;
+        FreeMemory* previous = this->freeMemoryList;
+        while (previous->next != nullptr && previous->next->start < address) previous = previous->next;
+        FreeMemory* next = previous->next;
+        if (previous != this->freeMemoryList && previous->end == address)
         {
-            if (freeMemory->end == address)
-            {
-                freeMemory->end += size;
-                break;
-            }
-            if (freeMemory->start == address + size)
-            {
-                freeMemory->start -= size;
-                break;
-            }
-            if (freeMemory->end < address && freeMemory->next->start > address + size)
+            previous->end = end;
+            if (next != nullptr && next->start == end)
             {
-                FreeMemory* next = freeMemory->next;
-                freeMemory->next = new FreeMemory(address, address + size);
-                freeMemory->next->next = next;
-                break;
+                previous->end = next->end;
+                previous->next = next->next;
+                next->next = nullptr;
+                delete next;
             }
-            freeMemory = freeMemory->next;
         }
-        if (freeMemory->end < address && freeMemory->next == nullptr)
+        else if (next != nullptr && next->start == end)
         {
-            freeMemory->next = new FreeMemory(address, address + size);
+            next->start = address;
         }
+        else
+        {
+            previous->next = new FreeMemory(address, end);
+            previous->next->next = next;
+        }
+        usedSize -= end - address;
+        ++frees;
+        freedBytes += end - address - 8;
+        freedSinceScavenge += end - address;
+        if (scavengeThreshold != 0 && freedSinceScavenge >= scavengeThreshold) scavenge();
+        return true;
     }
 
     uint64_t Memory::allocateMemoryWithoutHead(ThreadHandle* threadHandle, uint64_t size)
@@ -307,6 +533,7 @@ namespace lvm
             {
                 const uint64_t start = freeMemory->start;
                 freeMemory->start += size;
+                usedSize += size;
                 return start;
             }
             freeMemory = freeMemory->next;
@@ -314,6 +541,81 @@ namespace lvm
         throw VMException("Out of memory");
     }
 
+    uint64_t Memory::getStackGuardSize() const
+    {
+        // At least one yellow and one red page, whatever the page size
+        return std::max((DEFAULT_STACK_GUARD_SIZE + pageSize - 1) / pageSize * pageSize, 2 * pageSize);
+    }
+
+    uint64_t Memory::allocateStack(ThreadHandle* threadHandle)
+    {
+        std::lock_guard lock(_mutex);
+        uint64_t slot;
+        if (!freeStackSlots.empty())
+        {
+            slot = freeStackSlots.back();
+            freeStackSlots.pop_back();
+        }
+        else
+        {
+            if ((nextStackSlot + 1) * stackSlotSize > stackAreaSize) throw VMException("Out of stack space");
+            slot = nextStackSlot++;
+            markGuard(stackAreaStart + slot * stackSlotSize, getStackGuardSize());
+        }
+        // Nothing is committed here, the fault handler commits pages as the stack grows down towards the guard
+        return stackAreaStart + (slot + 1) * stackSlotSize;
+    }
+
+    void Memory::freeStack(ThreadHandle* threadHandle, const uint64_t stackTop)
+    {
+        std::lock_guard lock(_mutex);
+        const uint64_t slotStart = stackTop - stackSlotSize;
+        const uint64_t guardSize = getStackGuardSize();
+        const uint64_t released = releasePages(slotStart + guardSize, stackTop);
+        committedPages -= released;
+        releasedPages += released;
+        // The yellow page is still open if the thread never returned from its overflow handler
+        markGuard(slotStart, guardSize);
+        freeStackSlots.push_back((slotStart - stackAreaStart) / stackSlotSize);
+    }
+
+    void Memory::scavenge()
+    {
+        std::lock_guard lock(_mutex);
+        for (const FreeMemory* freeMemory = this->freeMemoryList->next; freeMemory != nullptr;
+             freeMemory = freeMemory->next)
+        {
+            const uint64_t start = (freeMemory->start + pageSize - 1) / pageSize * pageSize;
+            const uint64_t end = freeMemory->end / pageSize * pageSize;
+            if (start < end)
+            {
+                const uint64_t released = releasePages(start, end);
+                committedPages -= released;
+                releasedPages += released;
+            }
+        }
+        freedSinceScavenge = 0;
+    }
+
+    void Memory::addCommittedPages(const uint64_t pages)
+    {
+        const uint64_t committed = committedPages += pages;
+        uint64_t peak = peakCommittedPages;
+        while (committed > peak && !peakCommittedPages.compare_exchange_weak(peak, committed))
+        {
+        }
+    }
+
+    uint64_t Memory::getCommittedSize() const
+    {
+        return committedPages * pageSize;
+    }
+
+    uint64_t Memory::getReleasedSize() const
+    {
+        return releasedPages * pageSize;
+    }
+
 
     FreeMemory::FreeMemory(uint64_t start, uint64_t end) : start(start), end(end)
     {
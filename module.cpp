@@ -1,8 +1,22 @@
 #include "module.h"
 
-#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
 
+#include "bytes.h"
+#include "crc32c.h"
+#include "debuginfo.h"
+#include "linker.h"
+#include "lz4.h"
 #include "vm.h"
+#ifndef __WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 //
 // Created by XiaoLi on 25-8-14.
 //
@@ -10,6 +24,50 @@
 
 namespace lvm
 {
+    constexpr uint64_t MODULE_PREFIX_SIZE = 13;
+    constexpr uint64_t HEADER_CHECKSUM_OFFSET = 37;
+
+    class SectionEntry
+    {
+    public:
+        uint32_t kind = 0;
+        uint32_t version = 1;
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        uint32_t alignment = MODULE_SECTION_ALIGNMENT;
+        uint32_t flags = 0;
+        uint32_t checksum = 0;
+
+        // Reads the next table entry and checks that the section lies inside the image, as aligned as it claims
+        bool read(ByteReader& table, const uint64_t headerSize)
+        {
+            kind = table.read(4);
+            version = table.read(4);
+            offset = table.read(8);
+            size = table.read(8);
+            alignment = table.read(4);
+            flags = table.read(4);
+            checksum = table.read(4);
+            table.read(4);
+            return !table.failed && alignment != 0 && (alignment & (alignment - 1)) == 0 && offset % alignment == 0 &&
+                offset >= headerSize && offset <= table.length && size <= table.length - offset;
+        }
+    };
+
+    Module* reject(std::string* error, const std::string& reason)
+    {
+        if (error != nullptr) *error = reason;
+        return nullptr;
+    }
+
+    uint32_t getHeaderChecksum(const uint8_t* raw, const uint64_t headerSize)
+    {
+        constexpr uint8_t zero[4] = {};
+        uint32_t crc = crc32c(raw, HEADER_CHECKSUM_OFFSET);
+        crc = crc32c(zero, sizeof(zero), crc);
+        return crc32c(raw + HEADER_CHECKSUM_OFFSET + 4, headerSize - HEADER_CHECKSUM_OFFSET - 4, crc);
+    }
+
     Module::Module(const uint8_t* text, const uint64_t textLength, const uint8_t* rodata, const uint64_t rodataLength,
                    const uint8_t* data, const uint64_t dataLength, const uint64_t bssLength,
                    const uint64_t entryPoint): text(text), textLength(textLength), rodata(rodata),
@@ -20,64 +78,422 @@ namespace lvm
 
     Module::~Module()
     {
-        delete[] text;
-        delete[] rodata;
-        delete[] data;
+        if (ownsSections)
+        {
+            delete[] text;
+            delete[] rodata;
+            delete[] data;
+        }
+        if (image != nullptr)
+        {
+#ifdef __WIN32
+            delete[] image;
+#else
+            munmap(const_cast<uint8_t*>(image), imageLength);
+#endif
+        }
+        delete debugInfo;
+        delete linkInfo;
     }
 
-    uint8_t* Module::raw() const
-    {
-        std::vector<uint8_t> v;
-        v.push_back('l');
-        v.push_back('v');
-        v.push_back('m');
-        v.push_back('e');
-        v.push_back(ENDIAN);
-        for (int i = 0; i < sizeof(LVM_VERSION); i++)v.push_back(LVM_VERSION >> (i * 8));
-        for (int i = 0; i < sizeof(textLength); i++)v.push_back(textLength >> (i * 8));
-        for (int i = 0; i < textLength; i++)v.push_back(text[i]);
-        for (int i = 0; i < sizeof(rodataLength); i++)v.push_back(rodataLength >> (i * 8));
-        for (int i = 0; i < rodataLength; i++)v.push_back(rodata[i]);
-        for (int i = 0; i < sizeof(dataLength); i++)v.push_back(dataLength >> (i * 8));
-        for (int i = 0; i < dataLength; i++)v.push_back(data[i]);
-        for (int i = 0; i < sizeof(bssLength); i++)v.push_back(bssLength >> (i * 8));
-        for (int i = 0; i < sizeof(entryPoint); i++)v.push_back(entryPoint >> (i * 8));
+    std::vector<uint8_t> Module::buildImage(const bool compress) const
+    {
+        std::vector<SectionEntry> entries;
+        std::vector<const uint8_t*> payloads;
+        std::vector<std::vector<uint8_t>> buffers;
+        std::vector<uint8_t> symbols;
+        std::vector<uint8_t> lines;
+        std::vector<uint8_t> exports;
+        std::vector<uint8_t> imports;
+        std::vector<uint8_t> relocations;
+        const auto addSection = [&](const uint32_t kind, const uint32_t version, const uint32_t flags,
+                                    const uint8_t* payload, const uint64_t size)
+        {
+            SectionEntry entry;
+            entry.kind = kind;
+            entry.version = version;
+            entry.flags = flags;
+            entry.size = size;
+            entries.push_back(entry);
+            payloads.push_back(payload);
+        };
+        const uint8_t* contents[] = {text, rodata, data};
+        const uint64_t lengths[] = {textLength, rodataLength, dataLength};
+        const uint64_t packedLengths[] = {textPackedLength, rodataPackedLength, dataPackedLength};
+        for (uint32_t kind = MODULE_TEXT; kind <= MODULE_DATA; ++kind)
+        {
+            const uint8_t* payload = contents[kind - MODULE_TEXT];
+            const uint64_t length = lengths[kind - MODULE_TEXT];
+            if (packedLengths[kind - MODULE_TEXT] != 0)
+            {
+                payload = buffers.emplace_back(length).data();
+                unpackSection(kind, buffers.back().data());
+            }
+            if (compress && length != 0)
+            {
+                std::vector<uint8_t> packed;
+                writeInteger(packed, length, 8);
+                const std::vector<uint8_t> block = lz4Compress(payload, length);
+                packed.insert(packed.end(), block.begin(), block.end());
+                if (packed.size() < length)
+                {
+                    const std::vector<uint8_t>& stored = buffers.emplace_back(std::move(packed));
+                    addSection(kind, 1, SECTION_REQUIRED | SECTION_LZ4, stored.data(), stored.size());
+                    continue;
+                }
+            }
+            addSection(kind, 1, SECTION_REQUIRED, payload, length);
+        }
+        if (linkInfo != nullptr && !linkInfo->exports.empty())
+        {
+            exports = linkInfo->rawExports();
+            addSection(MODULE_EXPORTS, LINK_EXPORTS_VERSION, SECTION_REQUIRED, exports.data(), exports.size());
+        }
+        if (linkInfo != nullptr && !linkInfo->imports.empty())
+        {
+            imports = linkInfo->rawImports();
+            addSection(MODULE_IMPORTS, LINK_IMPORTS_VERSION, SECTION_REQUIRED, imports.data(), imports.size());
+        }
+        if (linkInfo != nullptr && !linkInfo->relocations.empty())
+        {
+            relocations = linkInfo->rawRelocations();
+            addSection(MODULE_RELOCATIONS, LINK_RELOCATIONS_VERSION, SECTION_REQUIRED, relocations.data(),
+                       relocations.size());
+        }
+        if (debugInfo != nullptr && !debugInfo->symbols.empty())
+        {
+            symbols = debugInfo->rawSymbols();
+            addSection(MODULE_SYMBOLS, DEBUG_SYMBOLS_VERSION, SECTION_DEBUG, symbols.data(), symbols.size());
+        }
+        if (debugInfo != nullptr && !debugInfo->lines.empty())
+        {
+            lines = debugInfo->rawLines();
+            addSection(MODULE_LINES, DEBUG_LINES_VERSION, SECTION_DEBUG, lines.data(), lines.size());
+        }
+
+        const uint64_t headerSize = MODULE_HEADER_SIZE + entries.size() * MODULE_SECTION_ENTRY_SIZE;
+        std::vector<uint8_t> v(headerSize);
+        for (uint64_t i = 0; i < entries.size(); ++i)
+        {
+            v.resize((v.size() + entries[i].alignment - 1) / entries[i].alignment * entries[i].alignment);
+            entries[i].offset = v.size();
+            if (entries[i].size != 0) v.insert(v.end(), payloads[i], payloads[i] + entries[i].size);
+            entries[i].checksum = crc32c(payloads[i], entries[i].size);
+        }
+
+        std::vector<uint8_t> header = {'l', 'v', 'm', 'e', ENDIAN};
+        writeInteger(header, LVM_VERSION, 8);
+        writeInteger(header, headerSize, 4);
+        writeInteger(header, entries.size(), 4);
+        writeInteger(header, bssLength, 8);
+        writeInteger(header, entryPoint, 8);
+        writeInteger(header, 0, 4);
+        header.resize(MODULE_HEADER_SIZE);
+        for (const SectionEntry& entry : entries)
+        {
+            writeInteger(header, entry.kind, 4);
+            writeInteger(header, entry.version, 4);
+            writeInteger(header, entry.offset, 8);
+            writeInteger(header, entry.size, 8);
+            writeInteger(header, entry.alignment, 4);
+            writeInteger(header, entry.flags, 4);
+            writeInteger(header, entry.checksum, 4);
+            writeInteger(header, 0, 4);
+        }
+        std::ranges::copy(header, v.begin());
+        const uint32_t checksum = getHeaderChecksum(v.data(), headerSize);
+        for (uint64_t i = 0; i < 4; ++i) v[HEADER_CHECKSUM_OFFSET + i] = checksum >> (i * 8);
+        return v;
+    }
+
+    uint8_t* Module::raw(const bool compress) const
+    {
+        const std::vector<uint8_t> v = buildImage(compress);
         auto* raw = new uint8_t[v.size()];
-        for (int i = 0; i < v.size(); i++)raw[i] = v[i];
+        std::ranges::copy(v, raw);
         return raw;
     }
 
-    Module* Module::fromRaw(const uint8_t* raw)
+    uint64_t Module::rawLength(const bool compress) const
     {
-        uint64_t index = 0;
-        if (raw[index++] != 'l' || raw[index++] != 'v' || raw[index++] != 'm' || raw[index++] != 'e')
+        return buildImage(compress).size();
+    }
+
+    Module* Module::fromRaw(const uint8_t* raw, const uint64_t length, std::string* error)
+    {
+        if (length < MODULE_PREFIX_SIZE) return reject(error, "File is too short to be an lvm module");
+        if (raw[0] != 'l' || raw[1] != 'v' || raw[2] != 'm' || raw[3] != 'e')
+            return reject(error, "Not an lvm module");
+        if (raw[4] != ENDIAN) return reject(error, "Module was built for the other byte order");
+        ByteReader prefix(raw + 5, 8);
+        const uint64_t version = prefix.read(8);
+        if (version == LVM_LEGACY_VERSION) return fromLegacy(raw, length, error);
+        if (version != LVM_VERSION) return reject(error, "Unsupported module version " + std::to_string(version));
+        return fromSections(raw, length, false, error);
+    }
+
+    Module* Module::fromLegacy(const uint8_t* raw, const uint64_t length, std::string* error)
+    {
+        ByteReader reader(raw, length);
+        reader.index = MODULE_PREFIX_SIZE;
+        const uint8_t* sections[3] = {};
+        uint64_t lengths[3] = {};
+        for (uint64_t i = 0; i < 3; ++i)
         {
-            return nullptr;
+            lengths[i] = reader.read(8);
+            if (reader.failed || lengths[i] > length - reader.index) return reject(error, "Truncated module");
+            sections[i] = raw + reader.index;
+            reader.index += lengths[i];
         }
-        if (raw[index++] != ENDIAN)
+        const uint64_t bssLength = reader.read(8);
+        const uint64_t entryPoint = reader.read(8);
+        if (reader.failed) return reject(error, "Truncated module");
+        uint8_t* copies[3];
+        for (uint64_t i = 0; i < 3; ++i)
         {
-            return nullptr;
+            copies[i] = new uint8_t[lengths[i]];
+            memcpy(copies[i], sections[i], lengths[i]);
+        }
+        return new Module(copies[0], lengths[0], copies[1], lengths[1], copies[2], lengths[2], bssLength, entryPoint);
+    }
+
+    Module* Module::fromSections(const uint8_t* raw, const uint64_t length, const bool inPlace, std::string* error)
+    {
+        ByteReader table(raw, length);
+        table.index = MODULE_PREFIX_SIZE;
+        const uint64_t headerSize = table.read(4);
+        const uint64_t sectionCount = table.read(4);
+        const uint64_t bssLength = table.read(8);
+        const uint64_t entryPoint = table.read(8);
+        const uint32_t checksum = table.read(4);
+        if (table.failed || length < MODULE_HEADER_SIZE) return reject(error, "Truncated module header");
+        if (sectionCount > (length - MODULE_HEADER_SIZE) / MODULE_SECTION_ENTRY_SIZE ||
+            headerSize != MODULE_HEADER_SIZE + sectionCount * MODULE_SECTION_ENTRY_SIZE)
+            return reject(error, "Bad section table");
+        if (getHeaderChecksum(raw, headerSize) != checksum) return reject(error, "Module header checksum mismatch");
+
+        // Index by kind, MODULE_TEXT to MODULE_DATA; packed is the stored length of a compressed section
+        const uint8_t* sections[4] = {};
+        uint64_t lengths[4] = {};
+        uint64_t packed[4] = {};
+        // Link tables are read once the image length is known, indexed by kind - MODULE_EXPORTS
+        SectionEntry links[3];
+        table.index = MODULE_HEADER_SIZE;
+        for (uint64_t i = 0; i < sectionCount; ++i)
+        {
+            SectionEntry entry;
+            if (!entry.read(table, headerSize))
+                return reject(error, "Section " + std::to_string(i) + " is out of bounds or misaligned");
+            if (entry.kind >= MODULE_EXPORTS && entry.kind <= MODULE_RELOCATIONS)
+            {
+                if (entry.version != 1 || entry.flags & SECTION_LZ4 || links[entry.kind - MODULE_EXPORTS].kind != 0)
+                    return reject(error, "Unsupported or duplicate link section " + std::to_string(i));
+                if (crc32c(raw + entry.offset, entry.size) != entry.checksum)
+                    return reject(error, "Checksum mismatch in section " + std::to_string(i));
+                links[entry.kind - MODULE_EXPORTS] = entry;
+                continue;
+            }
+            if (entry.kind != MODULE_TEXT && entry.kind != MODULE_RODATA && entry.kind != MODULE_DATA)
+            {
+                const bool known = entry.kind == MODULE_SYMBOLS || entry.kind == MODULE_LINES;
+                if (!known && entry.flags & SECTION_REQUIRED)
+                    return reject(error, "Unknown required section kind " + std::to_string(entry.kind));
+                continue;
+            }
+            if (entry.version != 1 || entry.flags & ~(SECTION_REQUIRED | SECTION_DEBUG | SECTION_LZ4))
+                return reject(error, "Unsupported version or flags of section " + std::to_string(i));
+            if (sections[entry.kind] != nullptr) return reject(error, "Duplicate section " + std::to_string(i));
+            if (crc32c(raw + entry.offset, entry.size) != entry.checksum)
+                return reject(error, "Checksum mismatch in section " + std::to_string(i));
+            sections[entry.kind] = raw + entry.offset;
+            lengths[entry.kind] = entry.size;
+            if (entry.flags & SECTION_LZ4)
+            {
+                ByteReader payload(raw + entry.offset, entry.size);
+                lengths[entry.kind] = payload.read(8);
+                // LZ4 cannot expand a byte to more than 255, anything beyond that is a lie about the length
+                if (payload.failed || entry.size == 8 || lengths[entry.kind] / 255 > entry.size)
+                    return reject(error, "Bad compressed section " + std::to_string(i));
+                sections[entry.kind] += 8;
+                packed[entry.kind] = entry.size - 8;
+            }
+        }
+        if (sections[MODULE_TEXT] == nullptr) return reject(error, "Module has no text section");
+        LinkInfo* linkInfo = nullptr;
+        if (links[0].kind != 0 || links[1].kind != 0 || links[2].kind != 0)
+        {
+            linkInfo = new LinkInfo();
+            const uint64_t imageLength = lengths[MODULE_TEXT] + lengths[MODULE_RODATA] + lengths[MODULE_DATA];
+            const SectionEntry& exports = links[0];
+            const SectionEntry& imports = links[1];
+            const SectionEntry& relocations = links[2];
+            if ((exports.kind != 0 && !linkInfo->readExports(raw + exports.offset, exports.size, imageLength)) ||
+                (imports.kind != 0 && !linkInfo->readImports(raw + imports.offset, imports.size, imageLength)) ||
+                (relocations.kind != 0 &&
+                    !linkInfo->readRelocations(raw + relocations.offset, relocations.size, imageLength)))
+            {
+                delete linkInfo;
+                return reject(error, "Bad link tables");
+            }
+        }
+
+        Module* module;
+        if (inPlace)
+        {
+            for (const uint8_t*& section : sections) if (section == nullptr) section = raw;
+            module = new Module(sections[MODULE_TEXT], lengths[MODULE_TEXT], sections[MODULE_RODATA],
+                                lengths[MODULE_RODATA], sections[MODULE_DATA], lengths[MODULE_DATA], bssLength,
+                                entryPoint);
+            module->ownsSections = false;
+        }
+        else
+        {
+            uint8_t* copies[4] = {};
+            for (uint64_t kind = MODULE_TEXT; kind <= MODULE_DATA; ++kind)
+            {
+                const uint64_t stored = packed[kind] != 0 ? packed[kind] : lengths[kind];
+                copies[kind] = new uint8_t[stored];
+                if (stored != 0) memcpy(copies[kind], sections[kind], stored);
+            }
+            module = new Module(copies[MODULE_TEXT], lengths[MODULE_TEXT], copies[MODULE_RODATA],
+                                lengths[MODULE_RODATA], copies[MODULE_DATA], lengths[MODULE_DATA], bssLength,
+                                entryPoint);
+        }
+        module->textPackedLength = packed[MODULE_TEXT];
+        module->rodataPackedLength = packed[MODULE_RODATA];
+        module->dataPackedLength = packed[MODULE_DATA];
+        module->linkInfo = linkInfo;
+        return module;
+    }
+
+    Module* Module::fromFile(const std::string& path, std::string* error)
+    {
+#ifdef __WIN32
+        std::ifstream input(path, std::ios::binary);
+        if (!input) return reject(error, "Failed to read " + path);
+        const std::vector<uint8_t> bytes{std::istreambuf_iterator(input), std::istreambuf_iterator<char>()};
+        auto* raw = new uint8_t[bytes.size()];
+        std::ranges::copy(bytes, raw);
+        const uint64_t length = bytes.size();
+#else
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd == -1) return reject(error, "Failed to read " + path);
+        struct stat status{};
+        if (fstat(fd, &status) == -1 || status.st_size < static_cast<off_t>(MODULE_PREFIX_SIZE))
+        {
+            close(fd);
+            return reject(error, "File is too short to be an lvm module");
         }
-        if ((*reinterpret_cast<const uint64_t*>(&raw[index])) != LVM_VERSION)
+        const uint64_t length = status.st_size;
+        void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED) return reject(error, "Failed to map " + path);
+        const auto* raw = static_cast<const uint8_t*>(mapping);
+#endif
+        ByteReader prefix(raw, length);
+        prefix.index = 5;
+        const bool sectioned = memcmp(raw, "lvme", 4) == 0 && raw[4] == ENDIAN && prefix.read(8) == LVM_VERSION;
+        Module* module = sectioned ? fromSections(raw, length, true, error) : fromRaw(raw, length, error);
+        if (module == nullptr)
         {
+#ifdef __WIN32
+            delete[] raw;
+#else
+            munmap(mapping, length);
+#endif
             return nullptr;
         }
-        index += 8;
-        const uint64_t textLength = *reinterpret_cast<const uint64_t*>(&raw[index]);
-        index += 8;
-        auto* text = new uint8_t[textLength]{};
-        for (int i = 0; i < textLength; i++)text[i] = raw[index++];
-        const uint64_t rodataLength = *reinterpret_cast<const uint64_t*>(&raw[index]);
-        index += 8;
-        auto* rodata = new uint8_t[rodataLength]{};
-        for (int i = 0; i < rodataLength; i++)rodata[i] = raw[index++];
-        const uint64_t dataLength = *reinterpret_cast<const uint64_t*>(&raw[index]);
-        index += 8;
-        auto* data = new uint8_t[dataLength]{};
-        for (int i = 0; i < dataLength; i++)data[i] = raw[index++];
-        const uint64_t bssLength = *reinterpret_cast<const uint64_t*>(&raw[index]);
-        index += 8;
-        const uint64_t entryPoint = *reinterpret_cast<const uint64_t*>(&raw[index]);
-        return new Module(text, textLength, rodata, rodataLength, data, dataLength, bssLength, entryPoint);
+        module->image = raw;
+        module->imageLength = length;
+        return module;
+    }
+
+    bool Module::loadDebugInfo(const uint8_t* raw, const uint64_t length)
+    {
+        if (length < MODULE_PREFIX_SIZE) return false;
+        ByteReader prefix(raw + 5, 8);
+        auto* loaded = new DebugInfo();
+        if (prefix.read(8) == LVM_LEGACY_VERSION)
+        {
+            // Version 0 modules carried their debug records right after the entry point
+            const uint64_t coreLength = MODULE_PREFIX_SIZE + 8 + textLength + 8 + rodataLength + 8 + dataLength + 16;
+            delete loaded;
+            loaded = length > coreLength ? DebugInfo::fromTrailer(raw + coreLength, length - coreLength) : nullptr;
+        }
+        else
+        {
+            ByteReader table(raw, length);
+            table.index = MODULE_PREFIX_SIZE;
+            const uint64_t headerSize = table.read(4);
+            const uint64_t sectionCount = table.read(4);
+            table.index = MODULE_HEADER_SIZE;
+            for (uint64_t i = 0; i < sectionCount; ++i)
+            {
+                SectionEntry entry;
+                if (!entry.read(table, headerSize)) break;
+                if ((entry.kind != MODULE_SYMBOLS && entry.kind != MODULE_LINES) || entry.flags & SECTION_LZ4) continue;
+                if (crc32c(raw + entry.offset, entry.size) != entry.checksum) continue;
+                if (entry.kind == MODULE_SYMBOLS && entry.version == DEBUG_SYMBOLS_VERSION)
+                    loaded->readSymbols(raw + entry.offset, entry.size);
+                else if (entry.kind == MODULE_LINES && entry.version == DEBUG_LINES_VERSION)
+                    loaded->readLines(raw + entry.offset, entry.size);
+            }
+            if (loaded->symbols.empty() && loaded->lines.empty())
+            {
+                delete loaded;
+                loaded = nullptr;
+            }
+        }
+        delete debugInfo;
+        debugInfo = loaded;
+        return debugInfo != nullptr;
+    }
+
+    bool Module::loadDebugInfo()
+    {
+        return image != nullptr && loadDebugInfo(image, imageLength);
+    }
+
+    bool Module::unpackSection(const uint32_t kind, uint8_t* destination) const
+    {
+        const uint8_t* sections[] = {text, rodata, data};
+        const uint64_t lengths[] = {textLength, rodataLength, dataLength};
+        const uint64_t packedLengths[] = {textPackedLength, rodataPackedLength, dataPackedLength};
+        const uint8_t* section = sections[kind - MODULE_TEXT];
+        const uint64_t length = lengths[kind - MODULE_TEXT];
+        const uint64_t packedLength = packedLengths[kind - MODULE_TEXT];
+        if (packedLength != 0) return lz4Decompress(section, packedLength, destination, length);
+        if (length != 0) memcpy(destination, section, length);
+        return true;
+    }
+
+    bool Module::unpack()
+    {
+        if (textPackedLength == 0 && rodataPackedLength == 0 && dataPackedLength == 0) return true;
+        auto* unpackedText = new uint8_t[textLength];
+        auto* unpackedRodata = new uint8_t[rodataLength];
+        auto* unpackedData = new uint8_t[dataLength];
+        if (!unpackSection(MODULE_TEXT, unpackedText) || !unpackSection(MODULE_RODATA, unpackedRodata) ||
+            !unpackSection(MODULE_DATA, unpackedData))
+        {
+            delete[] unpackedText;
+            delete[] unpackedRodata;
+            delete[] unpackedData;
+            return false;
+        }
+        if (ownsSections)
+        {
+            delete[] text;
+            delete[] rodata;
+            delete[] data;
+        }
+        text = unpackedText;
+        rodata = unpackedRodata;
+        data = unpackedData;
+        textPackedLength = 0;
+        rodataPackedLength = 0;
+        dataPackedLength = 0;
+        ownsSections = true;
+        return true;
     }
 }
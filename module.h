@@ -5,9 +5,38 @@
 #ifndef MODULE_H
 #define MODULE_H
 #include <cstdint>
+#include <string>
+#include <vector>
 
 namespace lvm
 {
+    class DebugInfo;
+    class LinkInfo;
+
+    // Version 1 images: a header, a table of sections and the sections, each at an offset aligned as recorded.
+    //
+    //     0   "lvme", endian, version (8), header size (4), section count (4), bss length (8), entry point (8),
+    //         CRC-32C of the header and table with this field zeroed (4), padding to MODULE_HEADER_SIZE
+    //     48  per section: kind (4), version (4), offset (8), size (8), alignment (4), flags (4), CRC-32C (4),
+    //         reserved (4)
+    constexpr uint64_t MODULE_HEADER_SIZE = 48;
+    constexpr uint64_t MODULE_SECTION_ENTRY_SIZE = 40;
+    constexpr uint64_t MODULE_SECTION_ALIGNMENT = 16;
+    constexpr uint32_t MODULE_TEXT = 1;
+    constexpr uint32_t MODULE_RODATA = 2;
+    constexpr uint32_t MODULE_DATA = 3;
+    constexpr uint32_t MODULE_SYMBOLS = 4;
+    constexpr uint32_t MODULE_LINES = 5;
+    constexpr uint32_t MODULE_EXPORTS = 6;
+    constexpr uint32_t MODULE_IMPORTS = 7;
+    constexpr uint32_t MODULE_RELOCATIONS = 8;
+    // A loader that does not know a required section rejects the image, other unknown sections are skipped
+    constexpr uint32_t SECTION_REQUIRED = 1;
+    // Checksummed and parsed only when debug info is asked for
+    constexpr uint32_t SECTION_DEBUG = 1 << 1;
+    // Text, rodata or data stored as its unpacked length (8) followed by an LZ4 block, the CRC covers the stored bytes
+    constexpr uint32_t SECTION_LZ4 = 1 << 2;
+
     class Module
     {
     public:
@@ -19,12 +48,44 @@ namespace lvm
         const uint64_t dataLength;
         const uint64_t bssLength;
         const uint64_t entryPoint;
+        // Non-zero for a section still LZ4 compressed: its pointer is the LZ4 block of this length and its length
+        // field the unpacked length. Memory::init unpacks it straight into the heap.
+        uint64_t textPackedLength = 0;
+        uint64_t rodataPackedLength = 0;
+        uint64_t dataPackedLength = 0;
+        // Only there when a tool asked for it with loadDebugInfo, or set by whoever built the module
+        DebugInfo* debugInfo = nullptr;
+        // Exports, imports and relocations, nullptr for a module that links with nothing
+        LinkInfo* linkInfo = nullptr;
 
         Module(const uint8_t* text, uint64_t textLength, const uint8_t* rodata, uint64_t rodataLength,
                const uint8_t* data, uint64_t dataLength, uint64_t bssLength, uint64_t entryPoint);
         ~Module();
-        [[nodiscard]] uint8_t* raw() const;
-        static Module* fromRaw(const uint8_t* raw);
+        // Compressed sections are only kept compressed when that makes them smaller
+        [[nodiscard]] uint8_t* raw(bool compress = false) const;
+        [[nodiscard]] uint64_t rawLength(bool compress = false) const;
+        // Checks the whole image in one pass before using any of it; nullptr, and the reason in error, if it is bad
+        static Module* fromRaw(const uint8_t* raw, uint64_t length, std::string* error = nullptr);
+        // Maps the file, the sections of a version 1 image are used in place instead of being copied
+        static Module* fromFile(const std::string& path, std::string* error = nullptr);
+        // Reads the debug sections of the image the module was loaded from
+        bool loadDebugInfo(const uint8_t* raw, uint64_t length);
+        // Same for a module from fromFile, which keeps its image mapped
+        bool loadDebugInfo();
+        // Writes the unpacked contents of MODULE_TEXT, MODULE_RODATA or MODULE_DATA to destination, which has room
+        // for all of it; false if a compressed section is corrupt
+        bool unpackSection(uint32_t kind, uint8_t* destination) const;
+        // Replaces compressed sections by unpacked copies, for tools that read text, rodata and data directly
+        bool unpack();
+
+    private:
+        const uint8_t* image = nullptr;
+        uint64_t imageLength = 0;
+        bool ownsSections = true;
+
+        [[nodiscard]] std::vector<uint8_t> buildImage(bool compress) const;
+        static Module* fromLegacy(const uint8_t* raw, uint64_t length, std::string* error);
+        static Module* fromSections(const uint8_t* raw, uint64_t length, bool inPlace, std::string* error);
     };
 }
 #endif //MODULE_H
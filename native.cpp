@@ -0,0 +1,154 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#include "native.h"
+
+#include <bit>
+#include <string>
+
+#include "bytecode.h"
+#include "exception.h"
+#include "vm.h"
+
+#ifndef __WIN32
+#include <dlfcn.h>
+#endif
+
+namespace lvm
+{
+    using namespace bytecode;
+
+    // Arguments are sorted into the host's integer and floating point argument registers the way a C compiler would,
+    // then every function is called through one prototype that fills all of those registers. The callee only reads
+    // the ones it declares, so no per-signature call stubs (or libffi) are needed; arguments passed on the stack are
+    // not supported.
+#if defined(__x86_64__) && !defined(__WIN32)
+    constexpr uint64_t INTEGER_ARGUMENT_REGISTERS = 6;
+    constexpr uint64_t FLOAT_ARGUMENT_REGISTERS = 8;
+    // Variadic, so that al holds the number of vector registers used as a variadic callee expects
+    template <typename T>
+    using NativeFunction = T (*)(uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, ...);
+#define NATIVE_CALL(T, function, integers, floats) reinterpret_cast<NativeFunction<T>>(function)( \
+    (integers)[0], (integers)[1], (integers)[2], (integers)[3], (integers)[4], (integers)[5], \
+    (floats)[0], (floats)[1], (floats)[2], (floats)[3], (floats)[4], (floats)[5], (floats)[6], (floats)[7])
+#elif defined(__aarch64__) && !defined(__WIN32)
+    constexpr uint64_t INTEGER_ARGUMENT_REGISTERS = 8;
+    constexpr uint64_t FLOAT_ARGUMENT_REGISTERS = 8;
+    template <typename T>
+    using NativeFunction = T (*)(uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t,
+                                 double, double, double, double, double, double, double, double);
+#define NATIVE_CALL(T, function, integers, floats) reinterpret_cast<NativeFunction<T>>(function)( \
+    (integers)[0], (integers)[1], (integers)[2], (integers)[3], (integers)[4], (integers)[5], (integers)[6], \
+    (integers)[7], (floats)[0], (floats)[1], (floats)[2], (floats)[3], (floats)[4], (floats)[5], (floats)[6], \
+    (floats)[7])
+#else
+    // Windows x64 assigns argument registers by position, only integer and pointer arguments are supported there
+    constexpr uint64_t INTEGER_ARGUMENT_REGISTERS = 4;
+    constexpr uint64_t FLOAT_ARGUMENT_REGISTERS = 0;
+    template <typename T>
+    using NativeFunction = T (*)(uint64_t, uint64_t, uint64_t, uint64_t);
+#define NATIVE_CALL(T, function, integers, floats) reinterpret_cast<NativeFunction<T>>(function)( \
+    (integers)[0], (integers)[1], (integers)[2], (integers)[3])
+#endif
+
+    uint64_t loadNativeLibrary(const char* path)
+    {
+#ifdef __WIN32
+        return reinterpret_cast<uint64_t>(LoadLibraryA(path));
+#else
+        return reinterpret_cast<uint64_t>(dlopen(path, RTLD_NOW | RTLD_LOCAL));
+#endif
+    }
+
+    uint64_t loadNativeSymbol(const uint64_t library, const char* name)
+    {
+        if (library == 0) return 0;
+#ifdef __WIN32
+        return reinterpret_cast<uint64_t>(GetProcAddress(reinterpret_cast<HMODULE>(library), name));
+#else
+        return reinterpret_cast<uint64_t>(dlsym(reinterpret_cast<void*>(library), name));
+#endif
+    }
+
+    void invokeNative(const uint64_t function, const uint64_t signature, uint64_t* registers, const Memory* memory)
+    {
+        const auto base = reinterpret_cast<uint64_t>(memory->heap);
+        uint64_t integers[8] = {};
+        double floats[8] = {};
+        uint64_t integerCount = 0;
+        uint64_t floatCount = 0;
+        const uint64_t count = signature >> 4 & 0xF;
+        if (count > NATIVE_MAX_ARGUMENTS) throw VMException("Too many native arguments: " + std::to_string(count));
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            const uint8_t type = signature >> (8 + 4 * i) & 0xF;
+            const uint64_t value = registers[1 + i];
+            if (type == FLOAT_TYPE || type == DOUBLE_TYPE)
+            {
+                if (floatCount == FLOAT_ARGUMENT_REGISTERS)
+                    throw VMException("Native call needs floating point arguments on the stack");
+                // A float goes in the low 32 bits of its vector register, which is where the guest keeps it too
+                floats[floatCount++] = std::bit_cast<double>(type == FLOAT_TYPE ? value & 0xFFFFFFFF : value);
+                continue;
+            }
+            if (integerCount == INTEGER_ARGUMENT_REGISTERS)
+                throw VMException("Native call needs integer arguments on the stack");
+            switch (type)
+            {
+            // Callers extend narrow integers, some callees rely on it
+            case BYTE_TYPE:
+                integers[integerCount++] = static_cast<int8_t>(value);
+                break;
+            case SHORT_TYPE:
+                integers[integerCount++] = static_cast<int16_t>(value);
+                break;
+            case INT_TYPE:
+                integers[integerCount++] = static_cast<int32_t>(value);
+                break;
+            case LONG_TYPE:
+                integers[integerCount++] = value;
+                break;
+            case POINTER_TYPE:
+                integers[integerCount++] = value == 0 ? 0 : base + (value & memory->addressMask);
+                break;
+            default:
+                throw VMException("Unsupported native argument type: " + std::to_string(type));
+            }
+        }
+        uint64_t& result = registers[RETURN_VALUE_REGISTER];
+        switch (signature & 0xF)
+        {
+        case VOID_TYPE:
+            NATIVE_CALL(void, function, integers, floats);
+            break;
+        case BYTE_TYPE:
+            result = static_cast<int8_t>(NATIVE_CALL(uint64_t, function, integers, floats));
+            break;
+        case SHORT_TYPE:
+            result = static_cast<int16_t>(NATIVE_CALL(uint64_t, function, integers, floats));
+            break;
+        case INT_TYPE:
+            result = static_cast<int32_t>(NATIVE_CALL(uint64_t, function, integers, floats));
+            break;
+        case LONG_TYPE:
+            result = NATIVE_CALL(uint64_t, function, integers, floats);
+            break;
+        case FLOAT_TYPE:
+            result = std::bit_cast<uint32_t>(NATIVE_CALL(float, function, integers, floats));
+            break;
+        case DOUBLE_TYPE:
+            result = std::bit_cast<uint64_t>(NATIVE_CALL(double, function, integers, floats));
+            break;
+        case POINTER_TYPE:
+            {
+                const uint64_t pointer = NATIVE_CALL(uint64_t, function, integers, floats);
+                // Pointers into the heap, e.g. the strchr of a guest string, come back as guest addresses
+                result = pointer - base < memory->reservedSize ? pointer - base : pointer;
+                break;
+            }
+        default:
+            throw VMException("Unsupported native return type: " + std::to_string(signature & 0xF));
+        }
+    }
+}
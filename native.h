@@ -0,0 +1,40 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#ifndef NATIVE_H
+#define NATIVE_H
+#include <cstdint>
+#include <initializer_list>
+
+namespace lvm
+{
+    class Memory;
+
+    // The 8 byte signature operand of INVOKE_NATIVE: the return type in bits 0-3, the argument count in bits 4-7 and
+    // the type of argument i in the 4 bits from bit 8 + 4 * i, all of them BYTE_TYPE ... POINTER_TYPE or VOID_TYPE
+    constexpr uint64_t NATIVE_MAX_ARGUMENTS = 14;
+
+    constexpr uint64_t nativeSignature(const uint8_t returnType, const std::initializer_list<uint8_t> arguments)
+    {
+        uint64_t signature = returnType | arguments.size() << 4;
+        uint64_t shift = 8;
+        for (const uint8_t type : arguments)
+        {
+            signature |= static_cast<uint64_t>(type) << shift;
+            shift += 4;
+        }
+        return signature;
+    }
+
+    // dlopen / LoadLibrary, 0 on failure
+    uint64_t loadNativeLibrary(const char* path);
+    // dlsym / GetProcAddress, 0 on failure
+    uint64_t loadNativeSymbol(uint64_t library, const char* name);
+    // Calls function with r1 ... rN as its arguments, passed in the argument registers of the host ABI; pointer
+    // arguments are guest addresses, translated to host addresses, with 0 staying NULL. The result, converted back to
+    // a guest address if it is a pointer into the heap, is written to RETURN_VALUE_REGISTER. Throws VMException on a
+    // malformed signature or one that needs arguments on the stack.
+    void invokeNative(uint64_t function, uint64_t signature, uint64_t* registers, const Memory* memory);
+}
+#endif //NATIVE_H
@@ -0,0 +1,143 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#include "perfmap.h"
+
+#include <cstdio>
+#include <cstring>
+#include <set>
+
+#include "analysis.h"
+#include "bytecode.h"
+#include "vm.h"
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace lvm
+{
+    using namespace bytecode;
+
+#if defined(__linux__) && defined(__x86_64__)
+    // push rbp; mov rbp, rsp; lea rdx, [rsp - 8]; call rsi; pop rbp; ret
+    // rdx is the slot the call stores its return address in, the callee gets it as its third argument
+    constexpr uint8_t TRAMPOLINE_CODE[] = {0x55, 0x48, 0x89, 0xe5, 0x48, 0x8d, 0x54, 0x24, 0xf8, 0xff, 0xd6, 0x5d, 0xc3};
+    // pop rbp; ret, the tail of the trampoline, so returning to any stub is the same as returning to the trampoline
+    constexpr uint8_t STUB_CODE[PERF_STUB_SIZE] = {0x5d, 0xc3, 0xcc, 0xcc};
+
+    // From asm/prctl.h of Linux 6.6, which older headers do not have
+    constexpr int ARCH_SHSTK_STATUS = 0x5005;
+    constexpr uint64_t ARCH_SHSTK_SHSTK = 1;
+
+    void enterGuest(ExecutionUnit* executionUnit, void*, uint64_t* returnSlot)
+    {
+        executionUnit->perfReturnSlot = returnSlot;
+        *returnSlot = currentPerfMap->getStub(executionUnit->registers[PC_REGISTER]);
+        executionUnit->execute();
+        executionUnit->perfReturnSlot = nullptr;
+    }
+#endif
+
+    bool isShadowStackEnabled()
+    {
+#if defined(__linux__) && defined(__x86_64__)
+        // Kernels without user shadow stacks reject the request, which is the same as having none
+        uint64_t features = 0;
+        if (syscall(SYS_arch_prctl, ARCH_SHSTK_STATUS, &features) != 0) return false;
+        return (features & ARCH_SHSTK_SHSTK) != 0;
+#else
+        return false;
+#endif
+    }
+
+    PerfMap::PerfMap(const Module* module, const bool tagging) : tagging(tagging), textLength(module->textLength)
+    {
+        // Without symbols functions start where the control flow graph finds them
+        std::set<uint64_t> starts = {0};
+        const DebugInfo* debugInfo = module->debugInfo;
+        if (debugInfo != nullptr && !debugInfo->symbols.empty())
+        {
+            for (const Symbol& symbol : debugInfo->symbols)
+                if (symbol.address < textLength) starts.insert(symbol.address);
+        }
+        else
+        {
+            for (const auto& [start, function] : ControlFlowGraph(module).functions) starts.insert(start);
+        }
+        for (auto start = starts.begin(); start != starts.end(); ++start)
+        {
+            const uint64_t end = std::next(start) == starts.end() ? textLength : *std::next(start);
+            char name[24];
+            snprintf(name, sizeof(name), "guest_0x%llx", static_cast<unsigned long long>(*start));
+            const Symbol* symbol = debugInfo == nullptr ? nullptr : debugInfo->findSymbol(*start);
+            functions.push_back({*start, end - *start, symbol == nullptr ? name : symbol->name});
+        }
+#if defined(__linux__) && defined(__x86_64__)
+        const uint64_t pageSize = sysconf(_SC_PAGESIZE);
+        regionSize = (PERF_TRAMPOLINE_SIZE + (textLength + 1) * PERF_STUB_SIZE + pageSize - 1) / pageSize * pageSize;
+        void* address = mmap(nullptr, regionSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (address == MAP_FAILED) return;
+        region = static_cast<uint8_t*>(address);
+        memset(region, 0xcc, PERF_TRAMPOLINE_SIZE);
+        memcpy(region, TRAMPOLINE_CODE, sizeof(TRAMPOLINE_CODE));
+        for (uint64_t i = 0; i <= textLength; ++i)
+            memcpy(region + PERF_TRAMPOLINE_SIZE + i * PERF_STUB_SIZE, STUB_CODE, PERF_STUB_SIZE);
+        if (mprotect(region, regionSize, PROT_READ | PROT_EXEC) != 0)
+        {
+            munmap(region, regionSize);
+            region = nullptr;
+            return;
+        }
+        stubs = reinterpret_cast<uint64_t>(region) + PERF_TRAMPOLINE_SIZE;
+#endif
+    }
+
+    PerfMap::~PerfMap()
+    {
+#ifdef __linux__
+        if (region != nullptr) munmap(region, regionSize);
+#endif
+    }
+
+    bool PerfMap::isSupported() const
+    {
+        return region != nullptr;
+    }
+
+    bool PerfMap::write() const
+    {
+#ifdef __linux__
+        const std::string path = "/tmp/perf-" + std::to_string(getpid()) + ".map";
+        FILE* file = fopen(path.c_str(), "w");
+        if (file == nullptr) return false;
+        fprintf(file, "%llx %llx lvm_perf_trampoline\n", reinterpret_cast<unsigned long long>(region),
+                static_cast<unsigned long long>(PERF_TRAMPOLINE_SIZE));
+        for (const Symbol& function : functions)
+        {
+            fprintf(file, "%llx %llx %s\n", static_cast<unsigned long long>(getStub(function.address)),
+                    static_cast<unsigned long long>(function.size * PERF_STUB_SIZE), function.name.c_str());
+        }
+        fprintf(file, "%llx %llx guest_outside_text\n", static_cast<unsigned long long>(getStub(textLength)),
+                static_cast<unsigned long long>(PERF_STUB_SIZE));
+        return fclose(file) == 0;
+#else
+        return false;
+#endif
+    }
+
+    void PerfMap::execute(ExecutionUnit* executionUnit) const
+    {
+#if defined(__linux__) && defined(__x86_64__)
+        if (tagging && region != nullptr)
+        {
+            using Trampoline = void (*)(ExecutionUnit*, void (*)(ExecutionUnit*, void*, uint64_t*));
+            reinterpret_cast<Trampoline>(region)(executionUnit, enterGuest);
+            return;
+        }
+#endif
+        executionUnit->execute();
+    }
+}
@@ -0,0 +1,55 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#ifndef PERFMAP_H
+#define PERFMAP_H
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "debuginfo.h"
+#include "module.h"
+
+namespace lvm
+{
+    constexpr uint64_t PERF_TRAMPOLINE_SIZE = 16;
+    constexpr uint64_t PERF_STUB_SIZE = 4;
+
+    class ExecutionUnit;
+
+    // Gives guest code host addresses that perf can name: every text byte owns a PERF_STUB_SIZE stub in an
+    // executable range, and /tmp/perf-<pid>.map lists the stubs of each guest function.
+    // With tagging on, threads enter execute() through a trampoline whose return address is pointed at the stub of
+    // the current guest function on every call and return, so frame pointer call graphs end in guest functions.
+    // The forged return address never matches the CET shadow stack, tagging cannot run with one enabled.
+    class PerfMap
+    {
+    public:
+        const bool tagging;
+
+        PerfMap(const Module* module, bool tagging);
+        ~PerfMap();
+        [[nodiscard]] bool isSupported() const;
+        bool write() const;
+        void execute(ExecutionUnit* executionUnit) const;
+
+        [[nodiscard]] uint64_t getStub(const uint64_t address) const
+        {
+            return stubs + (address < textLength ? address : textLength) * PERF_STUB_SIZE;
+        }
+
+    private:
+        uint8_t* region = nullptr;
+        uint64_t regionSize = 0;
+        uint64_t stubs = 0;
+        uint64_t textLength;
+        std::vector<Symbol> functions;
+    };
+
+    // Whether the calling thread runs with a CET shadow stack, which --perf-tag cannot run with
+    bool isShadowStackEnabled();
+
+    inline PerfMap* currentPerfMap = nullptr;
+}
+#endif //PERFMAP_H
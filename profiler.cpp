@@ -0,0 +1,206 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+#include "bytecode.h"
+#include "debuginfo.h"
+#include "profiler.h"
+#include "vm.h"
+#ifndef __WIN32
+#include <signal.h>
+#include <sys/time.h>
+#endif
+
+
+namespace lvm
+{
+    using namespace bytecode;
+
+#ifndef __WIN32
+    void ProfileSignalHandler(int sig, siginfo_t* info, void* context)
+    {
+        // Host threads that are not running guest code, like the one waiting in VirtualMachine::run, are skipped
+        const ExecutionUnit* executionUnit = currentExecutionUnit;
+        Profiler* profiler = currentProfiler;
+        if (executionUnit == nullptr || profiler == nullptr) return;
+        const int savedErrno = errno;
+        profiler->record(executionUnit->registers, executionUnit->stackTop);
+        errno = savedErrno;
+    }
+#endif
+
+    Profiler::Profiler(VirtualMachine* virtualMachine, const uint64_t frequency) : virtualMachine(virtualMachine),
+        frequency(frequency)
+    {
+        this->samples = new Sample[PROFILE_BUFFER_SIZE];
+        for (uint64_t i = 0; i < PROFILE_BUFFER_SIZE; ++i) this->samples[i].sequence = i;
+    }
+
+    Profiler::~Profiler()
+    {
+        stop();
+        if (currentProfiler == this) currentProfiler = nullptr;
+        delete[] this->samples;
+    }
+
+    bool Profiler::start()
+    {
+#ifdef __WIN32
+        std::cerr << "Profiling is not supported on this platform" << std::endl;
+        return false;
+#else
+        if (frequency == 0 || frequency > 1000000)
+        {
+            std::cerr << "Profile frequency must be between 1 and 1000000 Hz" << std::endl;
+            return false;
+        }
+        currentProfiler = this;
+
+        struct sigaction sa;
+        sa.sa_sigaction = ProfileSignalHandler;
+        sigemptyset(&sa.sa_mask);
+        sa.sa_flags = SA_SIGINFO | SA_RESTART;
+        if (sigaction(SIGPROF, &sa, nullptr) == -1)
+        {
+            perror("Failed to install profiler signal handler");
+            return false;
+        }
+
+        collecting = true;
+        this->collector = new std::thread([this]
+        {
+            sigset_t set;
+            sigemptyset(&set);
+            sigaddset(&set, SIGPROF);
+            pthread_sigmask(SIG_BLOCK, &set, nullptr);
+            while (collecting)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                collect();
+            }
+        });
+
+        // ITIMER_PROF counts CPU time of the whole process and signals a thread that is using it
+        const uint64_t interval = 1000000 / frequency;
+        itimerval timer{};
+        timer.it_interval.tv_sec = static_cast<time_t>(interval / 1000000);
+        timer.it_interval.tv_usec = static_cast<suseconds_t>(interval % 1000000);
+        timer.it_value = timer.it_interval;
+        if (setitimer(ITIMER_PROF, &timer, nullptr) == -1)
+        {
+            perror("Failed to start profiler timer");
+            stop();
+            return false;
+        }
+        return true;
+#endif
+    }
+
+    void Profiler::stop()
+    {
+#ifndef __WIN32
+        itimerval timer{};
+        setitimer(ITIMER_PROF, &timer, nullptr);
+#endif
+        if (this->collector != nullptr)
+        {
+            collecting = false;
+            this->collector->join();
+            delete this->collector;
+            this->collector = nullptr;
+        }
+        collect();
+    }
+
+    // Called from the signal handler, so it only touches the ring and guest memory known to be committed
+    void Profiler::record(const uint64_t* registers, const uint64_t stackTop)
+    {
+        uint64_t position = head.load(std::memory_order_relaxed);
+        Sample* sample;
+        for (;;)
+        {
+            sample = &this->samples[position % PROFILE_BUFFER_SIZE];
+            const uint64_t sequence = sample->sequence.load(std::memory_order_acquire);
+            if (sequence == position)
+            {
+                if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+            }
+            else if (sequence < position)
+            {
+                ++droppedSamples;
+                return;
+            }
+            else
+            {
+                position = head.load(std::memory_order_relaxed);
+            }
+        }
+
+        const auto base = reinterpret_cast<uint64_t>(virtualMachine->memory->heap);
+        uint64_t depth = 0;
+        sample->frames[depth++] = registers[PC_REGISTER];
+        // [BP] holds the caller's BP and [BP + 8] the return address, frames between SP and the stack top are mapped
+        uint64_t bp = registers[BP_REGISTER];
+        const uint64_t sp = registers[SP_REGISTER];
+        while (depth < PROFILE_MAX_DEPTH && bp >= sp && bp <= stackTop - 16)
+        {
+            sample->frames[depth++] = *reinterpret_cast<uint64_t*>(base + bp + 8);
+            const uint64_t next = *reinterpret_cast<uint64_t*>(base + bp);
+            if (next <= bp) break;
+            bp = next;
+        }
+        sample->depth = depth;
+        sample->sequence.store(position + 1, std::memory_order_release);
+    }
+
+    void Profiler::collect()
+    {
+        std::lock_guard lock(_mutex);
+        for (;;)
+        {
+            Sample& sample = this->samples[tail % PROFILE_BUFFER_SIZE];
+            if (sample.sequence.load(std::memory_order_acquire) != tail + 1) break;
+            ++stacks[std::vector(sample.frames, sample.frames + sample.depth)];
+            sample.sequence.store(tail + PROFILE_BUFFER_SIZE, std::memory_order_release);
+            ++tail;
+        }
+    }
+
+    std::string Profiler::symbolize(const uint64_t address) const
+    {
+        if (virtualMachine->debugInfo != nullptr) return virtualMachine->debugInfo->getFunctionName(address);
+        char name[19];
+        snprintf(name, sizeof(name), "0x%llx", static_cast<unsigned long long>(address));
+        return name;
+    }
+
+    bool Profiler::writeCollapsed(const std::string& path)
+    {
+        std::lock_guard lock(_mutex);
+        FILE* file = fopen(path.c_str(), "w");
+        if (!file)
+        {
+            perror("Failed to open profile output");
+            return false;
+        }
+        // One line per distinct stack, outermost frame first, as expected by flamegraph.pl and speedscope
+        for (const auto& [frames, count] : stacks)
+        {
+            std::string line;
+            for (auto frame = frames.rbegin(); frame != frames.rend(); ++frame)
+            {
+                if (!line.empty()) line += ';';
+                line += symbolize(*frame);
+            }
+            fprintf(file, "%s %llu\n", line.c_str(), static_cast<unsigned long long>(count));
+        }
+        fclose(file);
+        if (droppedSamples != 0)
+            std::cerr << "Profiler dropped " << droppedSamples << " samples" << std::endl;
+        return true;
+    }
+}
@@ -0,0 +1,61 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#ifndef PROFILER_H
+#define PROFILER_H
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lvm
+{
+    constexpr uint64_t DEFAULT_PROFILE_FREQUENCY = 1000;
+    constexpr uint64_t PROFILE_MAX_DEPTH = 64;
+    constexpr uint64_t PROFILE_BUFFER_SIZE = 4096;
+
+    class VirtualMachine;
+
+    class Sample
+    {
+    public:
+        std::atomic<uint64_t> sequence = 0;
+        uint64_t depth = 0;
+        uint64_t frames[PROFILE_MAX_DEPTH];
+    };
+
+    // Samples guest threads on SIGPROF: PC plus the return addresses found by walking the BP chain.
+    // The signal handler only claims a slot of a preallocated ring, a collector thread folds the ring into stacks.
+    class Profiler
+    {
+    public:
+        std::atomic<uint64_t> droppedSamples = 0;
+
+        Profiler(VirtualMachine* virtualMachine, uint64_t frequency);
+        ~Profiler();
+        bool start();
+        void stop();
+        void record(const uint64_t* registers, uint64_t stackTop);
+        [[nodiscard]] std::string symbolize(uint64_t address) const;
+        bool writeCollapsed(const std::string& path);
+
+    private:
+        VirtualMachine* virtualMachine;
+        const uint64_t frequency;
+        Sample* samples;
+        std::atomic<uint64_t> head = 0;
+        uint64_t tail = 0;
+        std::atomic<bool> collecting = false;
+        std::thread* collector = nullptr;
+        std::mutex _mutex;
+        std::map<std::vector<uint64_t>, uint64_t> stacks;
+
+        void collect();
+    };
+
+    inline Profiler* currentProfiler = nullptr;
+}
+#endif //PROFILER_H
@@ -0,0 +1,281 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#include "simd.h"
+
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#include "bytecode.h"
+
+namespace lvm
+{
+    using namespace bytecode;
+
+    using ElementWiseKernel = void (*)(const void*, const void*, uint64_t, void*);
+    using ReductionKernel = uint64_t (*)(const void*, const void*, uint64_t);
+
+    // One set of kernels per instruction set, each table indexed by type - INT_TYPE
+    class VectorKernels
+    {
+    public:
+        std::string_view isa;
+        ElementWiseKernel add[4];
+        ElementWiseKernel mul[4];
+        ElementWiseKernel fma[4];
+        ReductionKernel sum[4];
+        ReductionKernel min[4];
+        ReductionKernel max[4];
+        ReductionKernel dot[4];
+    };
+
+#if defined(__GNUC__) || defined(__clang__)
+    template <typename T, uint64_t Bytes>
+    struct VectorType
+    {
+        typedef T type __attribute__((vector_size(Bytes)));
+    };
+#else
+    template <typename T, uint64_t Bytes>
+    struct VectorType
+    {
+        using type = T;
+    };
+#endif
+
+    // The operations work on both scalars and GCC/Clang vectors, so one loop body serves the vector part and the tail.
+    // They update their first operand, element-wise as result and in reductions as the running total.
+    struct Add
+    {
+        template <typename V>
+        void operator()(V& result, const V& x, const V& y) const { result = x + y; }
+    };
+
+    struct Mul
+    {
+        template <typename V>
+        void operator()(V& result, const V& x, const V& y) const { result = x * y; }
+    };
+
+    struct Fma
+    {
+        template <typename V>
+        void operator()(V& result, const V& x, const V& y) const { result = x * y + result; }
+    };
+
+    struct Sum
+    {
+        template <typename V>
+        void operator()(V& total, const V& x, const V&) const { total = total + x; }
+    };
+
+    struct Min
+    {
+        template <typename V>
+        void operator()(V& total, const V& x, const V&) const { total = x < total ? x : total; }
+    };
+
+    struct Max
+    {
+        template <typename V>
+        void operator()(V& total, const V& x, const V&) const { total = x > total ? x : total; }
+    };
+
+    // Bytes is the vector width, 0 for plain scalar loops
+    template <typename T, uint64_t Bytes, typename Operation>
+    [[gnu::always_inline]] inline void elementWise(const T* a, const T* b, const uint64_t count, T* result,
+                                                   const Operation operation)
+    {
+        uint64_t i = 0;
+        if constexpr (Bytes != 0)
+        {
+            using V = typename VectorType<T, Bytes>::type;
+            for (; i + Bytes / sizeof(T) <= count; i += Bytes / sizeof(T))
+            {
+                V x, y, z;
+                memcpy(&x, a + i, Bytes);
+                memcpy(&y, b + i, Bytes);
+                memcpy(&z, result + i, Bytes);
+                operation(z, x, y);
+                memcpy(result + i, &z, Bytes);
+            }
+        }
+        for (; i < count; ++i) operation(result[i], a[i], b[i]);
+    }
+
+    // Four independent accumulators keep the adder busy instead of waiting on the previous sum
+    template <typename T, uint64_t Bytes, typename Operation, typename Combine>
+    [[gnu::always_inline]] inline T reduce(const T* a, const T* b, const uint64_t count, const T initial,
+                                           const Operation operation, const Combine combine)
+    {
+        T total = initial;
+        uint64_t i = 0;
+        if constexpr (Bytes != 0)
+        {
+            using V = typename VectorType<T, Bytes>::type;
+            constexpr uint64_t lanes = Bytes / sizeof(T);
+            if (count >= 4 * lanes)
+            {
+                V accumulators[4];
+                for (V& accumulator : accumulators) accumulator = V{} + initial;
+                for (; i + 4 * lanes <= count; i += 4 * lanes)
+                {
+                    for (uint64_t k = 0; k < 4; ++k)
+                    {
+                        V x, y;
+                        memcpy(&x, a + i + k * lanes, Bytes);
+                        memcpy(&y, b + i + k * lanes, Bytes);
+                        operation(accumulators[k], x, y);
+                    }
+                }
+                combine(accumulators[0], accumulators[1], accumulators[1]);
+                combine(accumulators[2], accumulators[3], accumulators[3]);
+                combine(accumulators[0], accumulators[2], accumulators[2]);
+                for (uint64_t lane = 0; lane < lanes; ++lane)
+                {
+                    const T value = accumulators[0][lane];
+                    combine(total, value, value);
+                }
+            }
+        }
+        for (; i < count; ++i) operation(total, a[i], b[i]);
+        return total;
+    }
+
+    template <typename T>
+    uint64_t toRegister(const T value)
+    {
+        if constexpr (std::is_same_v<T, float>) return std::bit_cast<uint32_t>(value);
+        else if constexpr (std::is_same_v<T, double>) return std::bit_cast<uint64_t>(value);
+        else return static_cast<int64_t>(static_cast<std::make_signed_t<T>>(value));
+    }
+
+    // Integers are added and multiplied unsigned so that they wrap, and compared signed
+    template <typename T>
+    using Wrapping = T;
+    template <typename T>
+    using Ordered = std::conditional_t<std::is_integral_v<T>, std::make_signed_t<T>, T>;
+
+#define VECTOR_KERNELS(NAME, ATTRIBUTES, BYTES)                                                                    \
+    template <typename T, typename Operation>                                                                      \
+    ATTRIBUTES void NAME##ElementWise(const void* a, const void* b, const uint64_t count, void* result)            \
+    {                                                                                                              \
+        elementWise<T, BYTES>(static_cast<const T*>(a), static_cast<const T*>(b), count, static_cast<T*>(result),  \
+                              Operation());                                                                        \
+    }                                                                                                              \
+    template <typename T, typename Operation, typename Combine>                                                    \
+    ATTRIBUTES uint64_t NAME##Reduce(const void* a, const void* b, const uint64_t count)                           \
+    {                                                                                                              \
+        T initial{};                                                                                               \
+        if constexpr (std::is_same_v<Operation, Min>) initial = std::numeric_limits<T>::max();                     \
+        if constexpr (std::is_same_v<Operation, Max>) initial = std::numeric_limits<T>::lowest();                  \
+        return toRegister(reduce<T, BYTES>(static_cast<const T*>(a), static_cast<const T*>(b), count, initial,     \
+                                           Operation(), Combine()));                                               \
+    }                                                                                                              \
+    const VectorKernels NAME##Kernels = {                                                                          \
+        #NAME,                                                                                                     \
+        VECTOR_TYPES(NAME##ElementWise, Wrapping, Add), VECTOR_TYPES(NAME##ElementWise, Wrapping, Mul),            \
+        VECTOR_TYPES(NAME##ElementWise, Wrapping, Fma), VECTOR_TYPES(NAME##Reduce, Wrapping, Sum, Sum),            \
+        VECTOR_TYPES(NAME##Reduce, Ordered, Min, Min), VECTOR_TYPES(NAME##Reduce, Ordered, Max, Max),              \
+        VECTOR_TYPES(NAME##Reduce, Wrapping, Fma, Sum),                                                            \
+    };
+
+#define VECTOR_TYPES(KERNEL, ORDER, ...)                                                                           \
+    {                                                                                                              \
+        KERNEL<ORDER<uint32_t>, __VA_ARGS__>, KERNEL<ORDER<uint64_t>, __VA_ARGS__>, KERNEL<float, __VA_ARGS__>,    \
+        KERNEL<double, __VA_ARGS__>                                                                                \
+    }
+
+    VECTOR_KERNELS(scalar, , 0)
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    VECTOR_KERNELS(sse2, , 16)
+    VECTOR_KERNELS(avx2, __attribute__((target("avx2,fma"))), 32)
+    VECTOR_KERNELS(avx512, __attribute__((target("avx512f,avx512dq"))), 64)
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+    VECTOR_KERNELS(neon, , 16)
+#endif
+
+    const VectorKernels* selectKernels(const std::string_view isa)
+    {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+        __builtin_cpu_init();
+        const bool hasAvx512 = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq");
+        const bool hasAvx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        if (isa.empty()) return hasAvx512 ? &avx512Kernels : hasAvx2 ? &avx2Kernels : &sse2Kernels;
+        if (isa == "avx512") return hasAvx512 ? &avx512Kernels : nullptr;
+        if (isa == "avx2") return hasAvx2 ? &avx2Kernels : nullptr;
+        if (isa == "sse2") return &sse2Kernels;
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+        if (isa.empty() || isa == "neon") return &neonKernels;
+#endif
+        return isa.empty() || isa == "scalar" ? &scalarKernels : nullptr;
+    }
+
+    const VectorKernels* vectorKernels = selectKernels({});
+
+    uint64_t getVectorElementSize(const uint8_t type)
+    {
+        switch (type)
+        {
+        case INT_TYPE:
+        case FLOAT_TYPE:
+            return 4;
+        case LONG_TYPE:
+        case DOUBLE_TYPE:
+            return 8;
+        default:
+            return 0;
+        }
+    }
+
+    void vectorAdd(const uint8_t type, const void* a, const void* b, const uint64_t count, void* result)
+    {
+        vectorKernels->add[type - INT_TYPE](a, b, count, result);
+    }
+
+    void vectorMul(const uint8_t type, const void* a, const void* b, const uint64_t count, void* result)
+    {
+        vectorKernels->mul[type - INT_TYPE](a, b, count, result);
+    }
+
+    void vectorFma(const uint8_t type, const void* a, const void* b, const uint64_t count, void* result)
+    {
+        vectorKernels->fma[type - INT_TYPE](a, b, count, result);
+    }
+
+    uint64_t vectorSum(const uint8_t type, const void* a, const uint64_t count)
+    {
+        return vectorKernels->sum[type - INT_TYPE](a, a, count);
+    }
+
+    uint64_t vectorMin(const uint8_t type, const void* a, const uint64_t count)
+    {
+        return count == 0 ? 0 : vectorKernels->min[type - INT_TYPE](a, a, count);
+    }
+
+    uint64_t vectorMax(const uint8_t type, const void* a, const uint64_t count)
+    {
+        return count == 0 ? 0 : vectorKernels->max[type - INT_TYPE](a, a, count);
+    }
+
+    uint64_t vectorDot(const uint8_t type, const void* a, const void* b, const uint64_t count)
+    {
+        return vectorKernels->dot[type - INT_TYPE](a, b, count);
+    }
+
+    std::string_view getVectorIsa()
+    {
+        return vectorKernels->isa;
+    }
+
+    bool selectVectorIsa(const std::string_view isa)
+    {
+        const VectorKernels* kernels = selectKernels(isa);
+        if (kernels == nullptr) return false;
+        vectorKernels = kernels;
+        return true;
+    }
+}
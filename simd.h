@@ -0,0 +1,34 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#ifndef SIMD_H
+#define SIMD_H
+#include <cstdint>
+#include <string_view>
+
+namespace lvm
+{
+    // Kernels behind the VECTOR_* opcodes, over count elements of INT_TYPE, LONG_TYPE, FLOAT_TYPE or DOUBLE_TYPE.
+    // The widest instruction set the CPU supports is picked once: AVX-512, AVX2 + FMA or SSE2 on x86-64, NEON on
+    // AArch64, scalar loops elsewhere. Integers wrap like ADD and MUL do.
+
+    // Element size of a vector element type, 0 for the types the VECTOR_* opcodes do not support
+    uint64_t getVectorElementSize(uint8_t type);
+    // result[i] = a[i] op b[i]; result may be a or b but must not partially overlap them
+    void vectorAdd(uint8_t type, const void* a, const void* b, uint64_t count, void* result);
+    void vectorMul(uint8_t type, const void* a, const void* b, uint64_t count, void* result);
+    // result[i] += a[i] * b[i], fused on CPUs with FMA
+    void vectorFma(uint8_t type, const void* a, const void* b, uint64_t count, void* result);
+    // Reductions return the value as it is held in a register: floats in the low 32 bits, ints sign extended.
+    // Floating point sums are reassociated across lanes; empty ranges give 0.
+    uint64_t vectorSum(uint8_t type, const void* a, uint64_t count);
+    uint64_t vectorMin(uint8_t type, const void* a, uint64_t count);
+    uint64_t vectorMax(uint8_t type, const void* a, uint64_t count);
+    uint64_t vectorDot(uint8_t type, const void* a, const void* b, uint64_t count);
+    // "avx512", "avx2", "sse2", "neon" or "scalar"
+    std::string_view getVectorIsa();
+    // Switches to the kernels of isa, false if the CPU or the build does not have them
+    bool selectVectorIsa(std::string_view isa);
+}
+#endif //SIMD_H
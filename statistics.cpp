@@ -0,0 +1,112 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#include "statistics.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <iomanip>
+#include <ranges>
+
+namespace lvm
+{
+    void Statistics::collect(VirtualMachine* virtualMachine)
+    {
+        virtualMachine->getJoinedCounts(instructionsRetired, inlineCaches);
+        std::ranges::sort(instructionsRetired);
+#ifdef LVM_COUNT_INSTRUCTIONS
+        instructionsCounted = true;
+#endif
+        threadsCreated = virtualMachine->threadsCreated;
+        compiledEntries = virtualMachine->compiledEntries;
+        const Memory* memory = virtualMachine->memory;
+        pageSize = memory->pageSize;
+        committedPages = memory->committedPages;
+        peakCommittedPages = memory->peakCommittedPages;
+        pageFaults = memory->pageFaults;
+        allocations = memory->allocations;
+        allocatedBytes = memory->allocatedBytes;
+        frees = memory->frees;
+        freedBytes = memory->freedBytes;
+    }
+
+    void Statistics::writeText(std::ostream& output) const
+    {
+        uint64_t total = 0;
+        for (const uint64_t count : instructionsRetired | std::views::values) total += count;
+        output << std::fixed << std::setprecision(3);
+        output << "load time             " << loadTime / 1e6 << " ms" << std::endl;
+        output << "init time             " << initTime / 1e6 << " ms" << std::endl;
+        output << "run time              " << runTime / 1e6 << " ms" << std::endl;
+        if (instructionsCounted)
+        {
+            output << "instructions retired  " << total;
+            if (runTime != 0) output << " (" << total * 1e3 / runTime << " M/s)";
+            output << std::endl;
+            for (const auto& [threadID, count] : instructionsRetired)
+                output << "  thread " << std::left << std::setw(13) << threadID << std::right << count << std::endl;
+        }
+        else
+        {
+            output << "instructions retired  not counted, build with LVM_COUNT_INSTRUCTIONS" << std::endl;
+        }
+        output << "threads created       " << threadsCreated << std::endl;
+        output << "compiled entries      " << compiledEntries << std::endl;
+        if (!inlineCaches.empty())
+        {
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            for (const auto& [siteHits, siteMisses] : inlineCaches | std::views::values)
+            {
+                hits += siteHits;
+                misses += siteMisses;
+            }
+            output << "inline caches         " << inlineCaches.size() << " sites, " << hits * 100.0 / (hits + misses)
+                << "% hits" << std::endl;
+            // The busiest sites
+            std::vector<std::pair<uint64_t, uint64_t>> sites;
+            for (const auto& [site, counts] : inlineCaches) sites.emplace_back(counts.first + counts.second, site);
+            std::ranges::sort(sites, std::greater());
+            for (uint64_t i = 0; i < sites.size() && i < 10; ++i)
+            {
+                const auto& [siteHits, siteMisses] = inlineCaches.at(sites[i].second);
+                char site[24];
+                snprintf(site, sizeof(site), "0x%llx", static_cast<unsigned long long>(sites[i].second));
+                output << "  site " << std::left << std::setw(15) << site << std::right << siteHits << " hits, "
+                    << siteMisses << " misses (" << siteHits * 100.0 / (siteHits + siteMisses) << "%)" << std::endl;
+            }
+        }
+        output << "committed pages       " << committedPages << " (peak " << peakCommittedPages << ", "
+            << peakCommittedPages * pageSize / 1024 << " KiB)" << std::endl;
+        output << "page faults           " << pageFaults << std::endl;
+        output << "malloc                " << allocations << " (" << allocatedBytes << " bytes)" << std::endl;
+        output << "free                  " << frees << " (" << freedBytes << " bytes)" << std::endl;
+    }
+
+    void Statistics::writeJson(std::ostream& output) const
+    {
+        output << "{\"load_ns\":" << loadTime << ",\"init_ns\":" << initTime << ",\"run_ns\":" << runTime
+            << ",\"threads\":[";
+        for (uint64_t i = 0; i < instructionsRetired.size(); ++i)
+        {
+            if (i != 0) output << ",";
+            output << "{\"id\":" << instructionsRetired[i].first;
+            if (instructionsCounted) output << ",\"instructions\":" << instructionsRetired[i].second;
+            output << "}";
+        }
+        output << "],\"threads_created\":" << threadsCreated << ",\"compiled_entries\":" << compiledEntries
+            << ",\"inline_caches\":[";
+        for (auto site = inlineCaches.begin(); site != inlineCaches.end(); ++site)
+        {
+            if (site != inlineCaches.begin()) output << ",";
+            output << "{\"site\":" << site->first << ",\"hits\":" << site->second.first << ",\"misses\":"
+                << site->second.second << "}";
+        }
+        output << "],\"page_size\":" << pageSize
+            << ",\"committed_pages\":" << committedPages << ",\"peak_committed_pages\":" << peakCommittedPages
+            << ",\"page_faults\":" << pageFaults << ",\"malloc_count\":" << allocations << ",\"malloc_bytes\":"
+            << allocatedBytes << ",\"free_count\":" << frees << ",\"free_bytes\":" << freedBytes << "}" << std::endl;
+    }
+}
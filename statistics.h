@@ -0,0 +1,46 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#ifndef STATISTICS_H
+#define STATISTICS_H
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include "vm.h"
+
+namespace lvm
+{
+    // What --stats reports, collected from the virtual machine after run() and before destroy()
+    class Statistics
+    {
+    public:
+        uint64_t loadTime = 0; // nanoseconds
+        uint64_t initTime = 0;
+        uint64_t runTime = 0;
+        // Thread ID and instructions retired of the threads joined by run(), a thread still running at EXIT is left out
+        std::vector<std::pair<uint64_t, uint64_t>> instructionsRetired;
+        // Whether the build counts instructions at all, see LVM_COUNT_INSTRUCTIONS
+        bool instructionsCounted = false;
+        uint64_t threadsCreated = 0;
+        uint64_t compiledEntries = 0;
+        // Hits and misses of the inline caches of INVOKE and JUMP through registers, by site, joined threads together
+        std::map<uint64_t, std::pair<uint64_t, uint64_t>> inlineCaches;
+        uint64_t pageSize = 0;
+        uint64_t committedPages = 0;
+        uint64_t peakCommittedPages = 0;
+        uint64_t pageFaults = 0;
+        uint64_t allocations = 0;
+        uint64_t allocatedBytes = 0;
+        uint64_t frees = 0;
+        uint64_t freedBytes = 0;
+
+        void collect(VirtualMachine* virtualMachine);
+        void writeText(std::ostream& output) const;
+        void writeJson(std::ostream& output) const;
+    };
+}
+#endif //STATISTICS_H
@@ -0,0 +1,56 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#ifndef TIER_H
+#define TIER_H
+#include <atomic>
+#include <cstdint>
+
+namespace lvm
+{
+    // Taken back edges to a loop header, or calls to a function, before the interpreter asks the tier for its code
+    constexpr uint64_t DEFAULT_OSR_THRESHOLD = 1000;
+
+    // Native code for guest code. It works on the interpreter's own state, the register file and the heap at base,
+    // so it can be entered in the middle of a running function (on-stack replacement) and can leave at any
+    // instruction boundary. It starts at registers[PC_REGISTER] and returns with registers[PC_REGISTER] at the first
+    // instruction the interpreter should run: a SYSCALL, I/O or thread instruction, or anything else it does not
+    // compile. While an instruction touches guest memory registers[PC_REGISTER] must already be past it, as in the
+    // interpreter, so that a fault is delivered to the guest with the same return address.
+    using CompiledCode = void (*)(uint64_t* registers, uint64_t base, uint64_t addressMask);
+
+    // An optimized tier the interpreter hands hot loops to, shared by all threads of a VM
+    class Tier
+    {
+    public:
+        virtual ~Tier() = default;
+        // Compiled code that can be entered at the guest address, nullptr if there is none. Asked about once per
+        // address, possibly from several threads at once.
+        virtual CompiledCode lookup(uint64_t address) = 0;
+    };
+
+    // Back edges to a loop header, or calls of a function, still to go before the tier is asked for its code, and
+    // that code. Shared by all threads, which count down without a locked instruction and may lose a few counts to
+    // each other. The countdown stays at 0 once there is code to enter, and at ~0 if the tier has none.
+    class LoopHeader
+    {
+    public:
+        std::atomic<uint64_t> countdown = 0;
+        std::atomic<CompiledCode> code = nullptr;
+    };
+
+    // Targets an INVOKE or JUMP through a register remembers; a site that sees more is megamorphic and keeps
+    // replacing the oldest
+    constexpr uint64_t INLINE_CACHE_SIZE = 4;
+
+    // Last targets of one INVOKE or JUMP through a register in the main module, with the hits and misses among them
+    class InlineCache
+    {
+    public:
+        uint64_t targets[INLINE_CACHE_SIZE] = {};
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+}
+#endif //TIER_H
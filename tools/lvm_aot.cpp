@@ -0,0 +1,79 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <argparse/argparse.hpp>
+
+#include "aot.h"
+#include "vm.h"
+
+int main(int argc, const char** argv)
+{
+    argparse::ArgumentParser program("lvm-aot", lvm::VERSION_STRING);
+    program.add_argument("file")
+           .help("Module file to compile")
+           .required();
+    program.add_argument("--output", "-o")
+           .help("Shared object to write, the module file with .so by default")
+           .default_value(std::string(""));
+    program.add_argument("--emit-c")
+           .help("Write the generated C instead of building it")
+           .default_value(false)
+           .implicit_value(true);
+    program.add_argument("--cc")
+           .help("C compiler used to build the shared object")
+           .default_value(std::string("cc"));
+    program.add_argument("--cflags")
+           .help("Optimization flags passed to the C compiler")
+           .default_value(std::string("-O2"));
+    try
+    {
+        program.parse_args(argc, argv);
+    }
+    catch (const std::runtime_error& err)
+    {
+        std::cerr << err.what() << std::endl;
+        std::cerr << program;
+        return 1;
+    }
+    const std::string path = program.get("file");
+    std::string error;
+    lvm::Module* module = lvm::Module::fromFile(path, &error);
+    if (module == nullptr || !module->unpack())
+    {
+        std::cerr << path << ": " << (module == nullptr ? error : "Corrupt compressed section") << std::endl;
+        return 1;
+    }
+    module->loadDebugInfo();
+    const std::string source = lvm::translateModule(module);
+    delete module;
+
+    const bool emitC = program.get<bool>("--emit-c");
+    std::string output = program.get("--output");
+    if (output.empty()) output = path.substr(0, path.rfind('.')) + (emitC ? ".c" : ".so");
+    const std::string sourcePath = emitC ? output : output + ".c";
+    {
+        std::ofstream file(sourcePath);
+        file << source;
+        if (!file)
+        {
+            std::cerr << sourcePath << ": Cannot write" << std::endl;
+            return 1;
+        }
+    }
+    if (emitC) return 0;
+    const std::string command = program.get("--cc") + " " + program.get("--cflags") +
+        " -shared -fPIC -fno-strict-aliasing -o '" + output + "' '" + sourcePath + "' -lm";
+    const int status = std::system(command.c_str());
+    std::remove(sourcePath.c_str());
+    if (status != 0)
+    {
+        std::cerr << "Failed: " << command << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,77 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <argparse/argparse.hpp>
+
+#include "assembler.h"
+#include "debuginfo.h"
+#include "vm.h"
+
+int main(int argc, const char** argv)
+{
+    argparse::ArgumentParser program("lvm-asm", lvm::VERSION_STRING);
+    program.add_argument("source")
+           .help("Assembly source file")
+           .required();
+    program.add_argument("--output", "-o")
+           .help("Output module file")
+           .default_value(std::string("a.lvme"));
+    program.add_argument("--strip")
+           .help("Leave out the function symbols and the line table")
+           .default_value(false)
+           .implicit_value(true);
+    program.add_argument("--compress")
+           .help("Store text, rodata and data LZ4 compressed where that makes them smaller")
+           .default_value(false)
+           .implicit_value(true);
+    try
+    {
+        program.parse_args(argc, argv);
+    }
+    catch (const std::runtime_error& err)
+    {
+        std::cerr << err.what() << std::endl;
+        std::cerr << program;
+        return 1;
+    }
+    const std::string path = program.get("source");
+    std::ifstream input(path);
+    if (!input)
+    {
+        std::cerr << "Failed to read file" << std::endl;
+        return 1;
+    }
+    std::stringstream source;
+    source << input.rdbuf();
+    lvm::Module* module;
+    try
+    {
+        module = lvm::Assembler::assemble(source.str(), path);
+    }
+    catch (const std::runtime_error& err)
+    {
+        std::cerr << path << ":" << err.what() << std::endl;
+        return 1;
+    }
+    if (program.get<bool>("--strip"))
+    {
+        delete module->debugInfo;
+        module->debugInfo = nullptr;
+    }
+    const bool compress = program.get<bool>("--compress");
+    const uint8_t* raw = module->raw(compress);
+    std::ofstream output(program.get("--output"), std::ios::binary);
+    output.write(reinterpret_cast<const char*>(raw), static_cast<std::streamsize>(module->rawLength(compress)));
+    delete[] raw;
+    delete module;
+    if (!output)
+    {
+        std::cerr << "Failed to write file" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,45 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#include <iostream>
+#include <argparse/argparse.hpp>
+
+#include "analysis.h"
+#include "assembler.h"
+#include "vm.h"
+
+int main(int argc, const char** argv)
+{
+    argparse::ArgumentParser program("lvm-dis", lvm::VERSION_STRING);
+    program.add_argument("file")
+           .help("Module file to disassemble")
+           .required();
+    program.add_argument("--cfg")
+           .help("Print functions, basic blocks and calls instead of the disassembly")
+           .default_value(false)
+           .implicit_value(true);
+    try
+    {
+        program.parse_args(argc, argv);
+    }
+    catch (const std::runtime_error& err)
+    {
+        std::cerr << err.what() << std::endl;
+        std::cerr << program;
+        return 1;
+    }
+    std::string error;
+    lvm::Module* module = lvm::Module::fromFile(program.get("file"), &error);
+    if (module == nullptr || !module->unpack())
+    {
+        std::cerr << program.get("file") << ": " << (module == nullptr ? error : "Corrupt compressed section")
+            << std::endl;
+        return 1;
+    }
+    module->loadDebugInfo();
+    if (program.get<bool>("--cfg")) std::cout << lvm::ControlFlowGraph(module).toString();
+    else std::cout << lvm::Assembler::disassemble(module);
+    delete module;
+    return 0;
+}
@@ -0,0 +1,160 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#include "tracer.h"
+
+#include <algorithm>
+#include <charconv>
+#include <iostream>
+#include <string_view>
+#include <utility>
+
+#include "debuginfo.h"
+
+namespace lvm
+{
+    Tracer::Tracer(std::string path, const DebugInfo* debugInfo) : path(std::move(path)), debugInfo(debugInfo)
+    {
+    }
+
+    Tracer::~Tracer()
+    {
+        stop();
+        if (currentTracer == this) currentTracer = nullptr;
+        for (const TraceBuffer* buffer : buffers) delete buffer;
+    }
+
+    bool Tracer::start()
+    {
+        file = fopen(path.c_str(), "w");
+        if (!file)
+        {
+            perror("Failed to open trace output");
+            return false;
+        }
+        setvbuf(file, nullptr, _IOFBF, 1 << 20);
+        fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", file);
+        origin = std::chrono::steady_clock::now().time_since_epoch().count();
+        currentTracer = this;
+        flushing = true;
+        this->flusher = new std::thread([this]
+        {
+            while (flushing)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                flush();
+            }
+        });
+        return true;
+    }
+
+    void Tracer::stop()
+    {
+        if (this->flusher != nullptr)
+        {
+            flushing = false;
+            this->flusher->join();
+            delete this->flusher;
+            this->flusher = nullptr;
+        }
+        if (file == nullptr) return;
+        flush();
+        std::lock_guard lock(_mutex);
+        uint64_t droppedEvents = 0;
+        for (const TraceBuffer* buffer : buffers)
+        {
+            const std::string event = R"({"name":"thread_name","ph":"M","pid":1,"tid":)" +
+                std::to_string(buffer->threadID) + R"(,"args":{"name":"guest thread )" +
+                std::to_string(buffer->threadID) + "\"}}";
+            writeEvent(event.c_str());
+            droppedEvents += buffer->droppedEvents;
+        }
+        fputs("\n]}\n", file);
+        fclose(file);
+        file = nullptr;
+        if (droppedEvents != 0)
+            std::cerr << "Tracer dropped " << droppedEvents << " events, the trace buffers were full" << std::endl;
+    }
+
+    TraceBuffer* Tracer::createBuffer(const uint64_t threadID)
+    {
+        std::lock_guard lock(_mutex);
+        auto* buffer = new TraceBuffer(threadID);
+        buffers.push_back(buffer);
+        return buffer;
+    }
+
+    // Timestamps are written as microseconds with three decimals without going through floating point
+    char* writeTimestamp(char* position, char* end, const uint64_t nanoseconds)
+    {
+        position = std::to_chars(position, end, nanoseconds / 1000).ptr;
+        *position++ = '.';
+        const uint64_t fraction = nanoseconds % 1000;
+        *position++ = static_cast<char>('0' + fraction / 100);
+        *position++ = static_cast<char>('0' + fraction / 10 % 10);
+        *position++ = static_cast<char>('0' + fraction % 10);
+        return position;
+    }
+
+    // Escaped for JSON and cut to TRACE_NAME_LENGTH characters
+    char* writeName(char* position, const std::string_view name)
+    {
+        for (const char c : name.substr(0, TRACE_NAME_LENGTH))
+        {
+            if (c == '"' || c == '\\') *position++ = '\\';
+            *position++ = static_cast<unsigned char>(c) < 0x20 ? '?' : c;
+        }
+        return position;
+    }
+
+    void Tracer::flush()
+    {
+        std::lock_guard lock(_mutex);
+        char event[TRACE_NAME_LENGTH * 2 + 128];
+        char* end = event + sizeof(event);
+        for (TraceBuffer* buffer : buffers)
+        {
+            const uint64_t head = buffer->head.load(std::memory_order_acquire);
+            uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+            for (; tail != head; ++tail)
+            {
+                const TraceEvent& traceEvent = buffer->events[tail % TRACE_BUFFER_SIZE];
+                char* position = event;
+                if (traceEvent.phase == TRACE_BEGIN)
+                {
+                    position = std::ranges::copy(std::string_view(R"({"name":")"), position).out;
+                    const Symbol* symbol = debugInfo == nullptr ? nullptr : debugInfo->findSymbol(traceEvent.address);
+                    if (symbol != nullptr)
+                    {
+                        position = writeName(position, symbol->name);
+                    }
+                    else
+                    {
+                        position = std::ranges::copy(std::string_view("0x"), position).out;
+                        position = std::to_chars(position, end, traceEvent.address, 16).ptr;
+                    }
+                    position = std::ranges::copy(std::string_view(R"(","ph":"B","ts":)"), position).out;
+                }
+                else
+                {
+                    position = std::ranges::copy(std::string_view(R"({"ph":"E","ts":)"), position).out;
+                }
+                position = writeTimestamp(position, end, traceEvent.timestamp - origin);
+                position = std::ranges::copy(std::string_view(R"(,"pid":1,"tid":)"), position).out;
+                position = std::to_chars(position, end, buffer->threadID).ptr;
+                *position++ = '}';
+                *position = '\0';
+                writeEvent(event);
+            }
+            buffer->tail.store(tail, std::memory_order_release);
+        }
+    }
+
+    void Tracer::writeEvent(const char* event)
+    {
+        if (!firstEvent) fputs(",\n", file);
+        fputs(event, file);
+        firstEvent = false;
+    }
+}
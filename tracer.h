@@ -0,0 +1,116 @@
+//
+// Created by XiaoLi on 26-10-18.
+//
+
+#ifndef TRACER_H
+#define TRACER_H
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lvm
+{
+    constexpr uint64_t TRACE_BUFFER_SIZE = 1 << 16;
+    constexpr uint8_t TRACE_BEGIN = 0;
+    constexpr uint8_t TRACE_END = 1;
+    constexpr uint64_t TRACE_NAME_LENGTH = 256;
+
+    class DebugInfo;
+
+    class TraceEvent
+    {
+    public:
+        uint64_t timestamp;
+        uint64_t address;
+        uint8_t phase;
+    };
+
+    // Single producer, single consumer ring: the guest thread appends, the tracer's flusher thread drains.
+    // A full ring drops the event instead of waiting, so the dispatch loop never blocks. Events stay balanced: once a
+    // begin is dropped everything up to its end is dropped with it, and an end whose begin is in the ring is written
+    // late, before the next event that fits.
+    class TraceBuffer
+    {
+    public:
+        const uint64_t threadID;
+        std::atomic<uint64_t> head = 0;
+        std::atomic<uint64_t> tail = 0;
+        std::atomic<uint64_t> droppedEvents = 0;
+        TraceEvent events[TRACE_BUFFER_SIZE];
+
+        explicit TraceBuffer(const uint64_t threadID) : threadID(threadID)
+        {
+        }
+
+        void record(const uint8_t phase, const uint64_t address)
+        {
+            if (droppedDepth != 0)
+            {
+                droppedDepth += phase == TRACE_BEGIN ? 1 : -1;
+                droppedEvents.store(droppedEvents.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return;
+            }
+            while (owedEnds != 0 && append(TRACE_END, 0)) --owedEnds;
+            if (owedEnds != 0 || !append(phase, address))
+            {
+                if (phase == TRACE_END)
+                {
+                    ++owedEnds;
+                    return;
+                }
+                droppedDepth = 1;
+                droppedEvents.store(droppedEvents.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            }
+        }
+
+    private:
+        // Only touched by the guest thread: begins dropped and not yet ended, and ends still to be written
+        uint64_t droppedDepth = 0;
+        uint64_t owedEnds = 0;
+
+        bool append(const uint8_t phase, const uint64_t address)
+        {
+            const uint64_t position = head.load(std::memory_order_relaxed);
+            if (position - tail.load(std::memory_order_acquire) == TRACE_BUFFER_SIZE) return false;
+            TraceEvent& event = events[position % TRACE_BUFFER_SIZE];
+            event.timestamp = std::chrono::steady_clock::now().time_since_epoch().count();
+            event.address = address;
+            event.phase = phase;
+            head.store(position + 1, std::memory_order_release);
+            return true;
+        }
+    };
+
+    // Guest function entries and exits of every thread, written as Chrome trace events (chrome://tracing, Perfetto)
+    class Tracer
+    {
+    public:
+        Tracer(std::string path, const DebugInfo* debugInfo);
+        ~Tracer();
+        bool start();
+        void stop();
+        TraceBuffer* createBuffer(uint64_t threadID);
+
+    private:
+        const std::string path;
+        const DebugInfo* debugInfo;
+        FILE* file = nullptr;
+        uint64_t origin = 0;
+        bool firstEvent = true;
+        std::vector<TraceBuffer*> buffers;
+        std::mutex _mutex;
+        std::atomic<bool> flushing = false;
+        std::thread* flusher = nullptr;
+
+        void flush();
+        void writeEvent(const char* event);
+    };
+
+    inline Tracer* currentTracer = nullptr;
+}
+#endif //TRACER_H
@@ -1,15 +1,26 @@
 //
 // Created by XiaoLi on 25-8-14.
 //
+#include <bit>
 #include <fstream>
 #include <iostream>
 #include <utility>
 #include <cmath>
+#include <cstring>
 #include <ranges>
 
+#include "analysis.h"
 #include "bytecode.h"
+#include "crc32c.h"
 #include "exception.h"
+#include "hash.h"
+#include "instrumentation.h"
+#include "linker.h"
 #include "module.h"
+#include "native.h"
+#include "perfmap.h"
+#include "simd.h"
+#include "tracer.h"
 #include "vm.h"
 
 #ifdef _MSC_VER
@@ -21,25 +32,101 @@
 #define DISPATCH(opcode) break
 #else
 #define TARGET(opcode) opcode
+#ifdef LVM_SHARED_DISPATCH_TAIL
 #define DISPATCH() goto end_dispatch
-#define DISPATCH_TABLE_ENTRY(opcode) [opcode] = &&opcode
+#else
+// Every handler fetches the next instruction and jumps to its handler itself, so that each of those indirect jumps is
+// predicted from the handler it is in rather than all of them from one shared jump
+#define DISPATCH()                                                                                      \
+    do                                                                                                  \
+    {                                                                                                   \
+        CHECK_INSTRUCTION_LENGTH();                                                                     \
+        const uint8_t nextCode = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));   \
+        INSTRUMENT_DISPATCH(nextCode);                                                                  \
+        COUNT_INSTRUCTION();                                                                            \
+        goto *dispatchTable[nextCode];                                                                  \
+    } while (0)
+#endif
+#define DISPATCH_TABLE_ENTRY(opcode, layout) [opcode] = &&opcode,
+#endif
+// The instructions loops are made of, and those that leave for the host anyway; the compiler keeps the hot handlers
+// together on the fall through paths and moves the cold ones out of their way
+#define HOT_TARGET(opcode) [[likely]] TARGET(opcode)
+#define COLD_TARGET(opcode) [[unlikely]] TARGET(opcode)
+
+#ifdef LVM_INSTRUMENT_DISPATCH
+#define INSTRUMENT_DISPATCH(code) dispatchCounters->record(code)
+#else
+#define INSTRUMENT_DISPATCH(code)
+#endif
+#ifdef LVM_CHECK_INSTRUCTION_LENGTH
+#define CHECK_INSTRUCTION_LENGTH() this->checkInstructionLength(base, addressMask)
+#else
+#define CHECK_INSTRUCTION_LENGTH()
+#endif
+#ifdef LVM_COUNT_INSTRUCTIONS
+#define COUNT_INSTRUCTION() ++this->instructionsRetired
+#else
+#define COUNT_INSTRUCTION()
 #endif
 
+// Points the perf trampoline's return address at the stub of the guest function control just moved to
+#define PERF_TAG() if (perfReturnSlot != nullptr) *perfReturnSlot = currentPerfMap->getStub(registers[PC_REGISTER])
+
+// Guest function entries and exits for --trace, appended to the thread's lock-free ring
+#define TRACE(phase, address) if (traceBuffer != nullptr) traceBuffer->record(phase, address)
+
+// addressMask is ~0 unless the heap runs hardened, where it keeps every access inside the reservation
+#define HOST_ADDRESS(address) (base + ((address) & addressMask))
+
+// A taken branch to or before itself is a loop back edge, next is the address after the branch. Only the main
+// module is compiled, edges into libraries are not counted.
+#define BACK_EDGE(next) \
+    if (loopHeaders != nullptr && registers[PC_REGISTER] < (next) && registers[PC_REGISTER] < textLength) [[unlikely]] \
+        this->countEdge(loopHeaders[registers[PC_REGISTER]], tier, base, addressMask)
+// Function entries are counted like loop headers, so that call-heavy code reaches the tier as well
+#define CALL_EDGE() if (loopHeaders != nullptr && registers[PC_REGISTER] < textLength) [[unlikely]] \
+    this->countEdge(loopHeaders[registers[PC_REGISTER]], tier, base, addressMask)
+// INVOKE and JUMP through a register of two bytes at next - 2, which have an inline cache
+#define INDIRECT_CALL_EDGE(next) if (tier != nullptr) [[unlikely]] \
+    this->onIndirectEdge(tier, (next) - 2, base, addressMask)
+#define INDIRECT_BACK_EDGE(next) if (tier != nullptr && registers[PC_REGISTER] < (next)) [[unlikely]] \
+    this->onIndirectEdge(tier, (next) - 2, base, addressMask)
+
+// count elements of size bytes at address lie in guest memory, without count * size wrapping around
+#define CONTAINS_ELEMENTS(address, count, size) \
+    ((count) <= ~0ULL / (size) && memory->contains(address, (count) * (size)))
+
 
 namespace lvm
 {
     using namespace bytecode;
 
-    VirtualMachine::VirtualMachine(uint64_t heapSize, uint64_t stackSize) : stackSize(stackSize)
+    const char* getDispatchKind()
+    {
+#if defined(USE_SWITCH_DISPATCH)
+        return "switch";
+#elif defined(LVM_SHARED_DISPATCH_TAIL)
+        return "shared-tail";
+#else
+        return "replicated";
+#endif
+    }
+
+    VirtualMachine::VirtualMachine(uint64_t heapSize, uint64_t stackSize, bool hardened, uint64_t stackAreaSize) :
+        stackSize(stackSize)
     {
-        this->memory = new Memory(heapSize);
+        this->memory = new Memory(heapSize, hardened, stackSize, stackAreaSize);
     }
 
     int VirtualMachine::init(const Module* module)
     {
-        this->memory->init(module->text, module->textLength, module->rodata, module->rodataLength, module->data,
-                           module->dataLength, module->bssLength);
+        if (!this->memory->init(module)) return 1;
+        this->linker = new Linker(this->memory);
+        this->linker->addModule(module, 0);
         this->entryPoint = module->entryPoint;
+        this->textLength = module->textLength;
+        this->debugInfo = module->debugInfo;
 
         this->fd2FileHandle.insert(std::make_pair(0, new FileHandle("stdin", 0, 0, stdin, nullptr)));
         this->fd2FileHandle.insert(std::make_pair(1, new FileHandle("stdout", 0, 0, nullptr, stdout)));
@@ -52,6 +139,14 @@ namespace lvm
 
     void VirtualMachine::destroy()
     {
+        delete this->linker;
+        this->linker = nullptr;
+        delete this->tier;
+        this->tier = nullptr;
+        delete[] this->loopHeaders;
+        this->loopHeaders = nullptr;
+        delete[] this->inlineCacheSlots;
+        this->inlineCacheSlots = nullptr;
         delete this->memory;
         this->memory = nullptr;
         for (const auto& val : this->fd2FileHandle | std::views::values)
@@ -61,22 +156,66 @@ namespace lvm
 
     int VirtualMachine::run()
     {
-        this->createThread(nullptr, this->entryPoint);
+        if (this->tier != nullptr && this->loopHeaders == nullptr)
+        {
+            this->loopHeaders = new LoopHeader[this->textLength];
+            for (uint64_t i = 0; i < this->textLength; ++i) this->loopHeaders[i].countdown = this->osrThreshold;
+            const auto* text = static_cast<const uint8_t*>(this->memory->heap);
+            this->inlineCacheSlots = new uint32_t[this->textLength]{};
+            for (uint64_t offset = 0; offset < this->textLength;)
+            {
+                const uint64_t size = getInstructionLength(text, this->textLength, offset);
+                if (size != 0 && (text[offset] == INVOKE || text[offset] == JUMP))
+                {
+                    this->inlineCacheSites.push_back(offset);
+                    this->inlineCacheSlots[offset] = this->inlineCacheSites.size();
+                }
+                offset += size == 0 ? 1 : size;
+            }
+        }
+        // Before the first thread starts, which could EXIT right away
         running = true;
+        this->createThread(nullptr, this->entryPoint);
         while (running && !threadID2Handle.empty())
         {
             const ThreadHandle* threadHandle = threadID2Handle.begin()->second;
             threadHandle->_thread->join();
             destroyThread(threadHandle);
         }
+        // The thread that exited is about to finish, any other may run on
+        std::vector<const ThreadHandle*> finished;
+        for (const ThreadHandle* threadHandle : threadID2Handle | std::views::values)
+        {
+            if (threadHandle->executionUnit == exitingUnit || threadHandle->finished) finished.push_back(threadHandle);
+        }
+        for (const ThreadHandle* threadHandle : finished)
+        {
+            threadHandle->_thread->join();
+            destroyThread(threadHandle);
+        }
         return 0;
     }
 
+    bool VirtualMachine::hasRunningThreads() const
+    {
+        return !threadID2Handle.empty();
+    }
+
+    void VirtualMachine::getJoinedCounts(std::vector<std::pair<uint64_t, uint64_t>>& instructionsRetired,
+                                         std::map<uint64_t, std::pair<uint64_t, uint64_t>>& inlineCaches)
+    {
+        std::lock_guard lock(_mutex);
+        instructionsRetired = this->retiredInstructions;
+        inlineCaches = this->inlineCacheCounts;
+    }
+
     uint64_t VirtualMachine::createThread(ThreadHandle* threadHandle, const uint64_t entryPoint)
     {
         uint64_t threadID = this->getThreadID();
         ExecutionUnit* executionUnit = this->createExecutionUnit(threadHandle, entryPoint);
         auto* handle = new ThreadHandle(threadID, executionUnit);
+        ++this->threadsCreated;
+        if (currentTracer != nullptr) executionUnit->traceBuffer = currentTracer->createBuffer(threadID);
         executionUnit->setThreadHandle(handle);
         this->threadID2Handle.insert(std::make_pair(threadID, handle));
         handle->start();
@@ -86,14 +225,22 @@ namespace lvm
     ExecutionUnit* VirtualMachine::createExecutionUnit(ThreadHandle* threadHandle, const uint64_t entryPoint)
     {
         auto* executionUnit = new ExecutionUnit(this);
-        const uint64_t stack = this->memory->allocateMemory(threadHandle, this->stackSize);
-        executionUnit->init(stack + this->stackSize - 1, entryPoint);
+        const uint64_t stackTop = this->memory->allocateStack(threadHandle);
+        executionUnit->stackTop = stackTop;
+        executionUnit->init(stackTop - 1, entryPoint);
         return executionUnit;
     }
 
     void VirtualMachine::destroyThread(const ThreadHandle* threadHandle)
     {
+        this->memory->freeStack(nullptr, threadHandle->executionUnit->stackTop);
+        {
+            std::lock_guard lock(_mutex);
+            retiredInstructions.emplace_back(threadHandle->threadID, threadHandle->executionUnit->instructionsRetired);
+            threadHandle->executionUnit->countInlineCaches(inlineCacheCounts);
+        }
         threadHandle->executionUnit->destroy();
+        if (threadHandle->executionUnit == exitingUnit) exitingUnit = nullptr;
         threadID2Handle.erase(threadHandle->threadID);
         if (threadHandle->threadID <= lastThreadID) lastThreadID = threadHandle->threadID - 1;
         delete threadHandle;
@@ -138,6 +285,7 @@ namespace lvm
     void VirtualMachine::exit(uint64_t status)
     {
         // TODO
+        exitingUnit = currentExecutionUnit;
         running = false;
     }
 
@@ -177,7 +325,12 @@ namespace lvm
         std::lock_guard lock(_mutex);
         if (this->_thread == nullptr)
         {
-            this->_thread = new std::thread(&ExecutionUnit::execute, this->executionUnit);
+            this->_thread = new std::thread([this, perfMap = currentPerfMap]
+            {
+                if (perfMap != nullptr) perfMap->execute(this->executionUnit);
+                else this->executionUnit->execute();
+                this->finished = true;
+            });
         }
     }
 
@@ -193,6 +346,8 @@ namespace lvm
         this->registers[BP_REGISTER] = stackBase;
         this->registers[SP_REGISTER] = stackBase;
         this->registers[PC_REGISTER] = entryPoint;
+        if (this->virtualMachine->inlineCacheSlots != nullptr)
+            this->inlineCaches = new InlineCache[this->virtualMachine->inlineCacheSites.size()];
     }
 
     void ExecutionUnit::setThreadHandle(ThreadHandle* threadHandle)
@@ -207,68 +362,55 @@ namespace lvm
         ThreadHandle* threadHandle = this->threadHandle;
         Memory* memory = this->virtualMachine->memory;
         const auto base = reinterpret_cast<uint64_t>(memory->heap);
+        const uint64_t addressMask = memory->addressMask;
         uint64_t* registers = this->registers;
+        uint64_t* const perfReturnSlot = this->perfReturnSlot;
+        TraceBuffer* const traceBuffer = this->traceBuffer;
+        Tier* const tier = this->virtualMachine->tier;
+        LoopHeader* const loopHeaders = this->virtualMachine->loopHeaders;
+        const uint64_t textLength = this->virtualMachine->textLength;
+        // Bottom of this thread's stack slot, guard pages included
+        const uint64_t stackLimit = this->stackTop - memory->stackSlotSize;
+        const uint64_t stackGuardSize = memory->getStackGuardSize();
+#ifdef LVM_INSTRUMENT_DISPATCH
+        auto* dispatchCounters = new DispatchCounters();
+#endif
+#ifndef __WIN32
+        // Guest faults raised by PageFaultHandler resume here and are delivered through the guest IDT
+        if (const int fault = sigsetjmp(env, 1); fault != 0)
+        {
+            this->inHostCall = false;
+#ifdef LVM_CHECK_INSTRUCTION_LENGTH
+            this->checkedInstruction = ~0ULL;
+#endif
+            memory->releaseLocks();
+            if (this->deliveringFault || fault == FATAL_FAULT)
+            {
+                std::cerr << "Unrecoverable fault, stopping thread " << threadHandle->threadID << std::endl;
+                goto end;
+            }
+            this->deliveringFault = true;
+            this->interrupt(fault - 1);
+            this->deliveringFault = false;
+            PERF_TAG();
+        }
+#endif
         // std::cout << registers[PC_REGISTER] << ": " << getInstructionName(
         // *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER])) << std::endl;
 #ifdef USE_SWITCH_DISPATCH
         for (;;)
         {
-            switch (const uint8_t code = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++))
+            CHECK_INSTRUCTION_LENGTH();
+            const uint8_t code = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+            INSTRUMENT_DISPATCH(code);
+            COUNT_INSTRUCTION();
+            switch (code)
             {
 
 #else
+        // One handler per entry of the opcode table, an opcode without a TARGET here does not compile
         static void* dispatchTable[] = {
-            DISPATCH_TABLE_ENTRY(NOP),DISPATCH_TABLE_ENTRY(PUSH_1),DISPATCH_TABLE_ENTRY(PUSH_2),
-            DISPATCH_TABLE_ENTRY(PUSH_4),DISPATCH_TABLE_ENTRY(PUSH_8),DISPATCH_TABLE_ENTRY(POP_1),
-            DISPATCH_TABLE_ENTRY(POP_2),DISPATCH_TABLE_ENTRY(POP_4),DISPATCH_TABLE_ENTRY(POP_8),
-            DISPATCH_TABLE_ENTRY(LOAD_1),DISPATCH_TABLE_ENTRY(LOAD_2),DISPATCH_TABLE_ENTRY(LOAD_4),
-            DISPATCH_TABLE_ENTRY(LOAD_8),DISPATCH_TABLE_ENTRY(STORE_1),DISPATCH_TABLE_ENTRY(STORE_2),
-            DISPATCH_TABLE_ENTRY(STORE_4),DISPATCH_TABLE_ENTRY(STORE_8),DISPATCH_TABLE_ENTRY(CMP),
-            DISPATCH_TABLE_ENTRY(ATOMIC_CMP),DISPATCH_TABLE_ENTRY(MOV_E),DISPATCH_TABLE_ENTRY(MOV_NE),
-            DISPATCH_TABLE_ENTRY(MOV_L),DISPATCH_TABLE_ENTRY(MOV_LE),DISPATCH_TABLE_ENTRY(MOV_G),
-            DISPATCH_TABLE_ENTRY(MOV_GE),DISPATCH_TABLE_ENTRY(MOV_UL),DISPATCH_TABLE_ENTRY(MOV_ULE),
-            DISPATCH_TABLE_ENTRY(MOV_UG),DISPATCH_TABLE_ENTRY(MOV_UGE),DISPATCH_TABLE_ENTRY(MOV),
-            DISPATCH_TABLE_ENTRY(MOV_IMMEDIATE1),DISPATCH_TABLE_ENTRY(MOV_IMMEDIATE2),
-            DISPATCH_TABLE_ENTRY(MOV_IMMEDIATE4),DISPATCH_TABLE_ENTRY(MOV_IMMEDIATE8),DISPATCH_TABLE_ENTRY(JUMP),
-            DISPATCH_TABLE_ENTRY(JUMP_IMMEDIATE),DISPATCH_TABLE_ENTRY(JE),DISPATCH_TABLE_ENTRY(JNE),
-            DISPATCH_TABLE_ENTRY(JL),DISPATCH_TABLE_ENTRY(JLE),DISPATCH_TABLE_ENTRY(JG),DISPATCH_TABLE_ENTRY(JGE),
-            DISPATCH_TABLE_ENTRY(JUL),DISPATCH_TABLE_ENTRY(JULE),DISPATCH_TABLE_ENTRY(JUG),
-            DISPATCH_TABLE_ENTRY(JUGE),DISPATCH_TABLE_ENTRY(MALLOC),DISPATCH_TABLE_ENTRY(FREE),
-            DISPATCH_TABLE_ENTRY(REALLOC),
-            DISPATCH_TABLE_ENTRY(ADD),DISPATCH_TABLE_ENTRY(SUB),DISPATCH_TABLE_ENTRY(MUL),DISPATCH_TABLE_ENTRY(DIV),
-            DISPATCH_TABLE_ENTRY(MOD),DISPATCH_TABLE_ENTRY(AND),DISPATCH_TABLE_ENTRY(OR),DISPATCH_TABLE_ENTRY(XOR),
-            DISPATCH_TABLE_ENTRY(NOT), DISPATCH_TABLE_ENTRY(NEG),DISPATCH_TABLE_ENTRY(SHL),DISPATCH_TABLE_ENTRY(SHR),
-            DISPATCH_TABLE_ENTRY(USHR),DISPATCH_TABLE_ENTRY(INC),DISPATCH_TABLE_ENTRY(DEC),
-            DISPATCH_TABLE_ENTRY(ADD_DOUBLE), DISPATCH_TABLE_ENTRY(SUB_DOUBLE),DISPATCH_TABLE_ENTRY(MUL_DOUBLE),
-            DISPATCH_TABLE_ENTRY(DIV_DOUBLE),DISPATCH_TABLE_ENTRY(MOD_DOUBLE),DISPATCH_TABLE_ENTRY(ADD_FLOAT),
-            DISPATCH_TABLE_ENTRY(SUB_FLOAT),DISPATCH_TABLE_ENTRY(MUL_FLOAT),DISPATCH_TABLE_ENTRY(DIV_FLOAT),
-            DISPATCH_TABLE_ENTRY(MOD_FLOAT),DISPATCH_TABLE_ENTRY(ATOMIC_ADD),DISPATCH_TABLE_ENTRY(ATOMIC_SUB),
-            DISPATCH_TABLE_ENTRY(ATOMIC_MUL),DISPATCH_TABLE_ENTRY(ATOMIC_DIV),DISPATCH_TABLE_ENTRY(ATOMIC_MOD),
-            DISPATCH_TABLE_ENTRY(ATOMIC_AND),DISPATCH_TABLE_ENTRY(ATOMIC_OR),DISPATCH_TABLE_ENTRY(ATOMIC_XOR),
-            DISPATCH_TABLE_ENTRY(ATOMIC_NOT),DISPATCH_TABLE_ENTRY(ATOMIC_NEG),DISPATCH_TABLE_ENTRY(ATOMIC_SHL),
-            DISPATCH_TABLE_ENTRY(ATOMIC_SHR),DISPATCH_TABLE_ENTRY(ATOMIC_USHR),DISPATCH_TABLE_ENTRY(ATOMIC_INC),
-            DISPATCH_TABLE_ENTRY(ATOMIC_DEC),DISPATCH_TABLE_ENTRY(ATOMIC_ADD_DOUBLE),
-            DISPATCH_TABLE_ENTRY(ATOMIC_SUB_DOUBLE),DISPATCH_TABLE_ENTRY(ATOMIC_MUL_DOUBLE),
-            DISPATCH_TABLE_ENTRY(ATOMIC_DIV_DOUBLE),DISPATCH_TABLE_ENTRY(ATOMIC_MOD_DOUBLE),
-            DISPATCH_TABLE_ENTRY(ATOMIC_ADD_FLOAT),DISPATCH_TABLE_ENTRY(ATOMIC_SUB_FLOAT),
-            DISPATCH_TABLE_ENTRY(ATOMIC_MUL_FLOAT),DISPATCH_TABLE_ENTRY(ATOMIC_DIV_FLOAT),
-            DISPATCH_TABLE_ENTRY(ATOMIC_MOD_FLOAT),DISPATCH_TABLE_ENTRY(CAS),DISPATCH_TABLE_ENTRY(INVOKE),
-            DISPATCH_TABLE_ENTRY(INVOKE_IMMEDIATE),DISPATCH_TABLE_ENTRY(RETURN),DISPATCH_TABLE_ENTRY(INTERRUPT),
-            DISPATCH_TABLE_ENTRY(INTERRUPT_RETURN),DISPATCH_TABLE_ENTRY(INT_TYPE_CAST),
-            DISPATCH_TABLE_ENTRY(LONG_TO_DOUBLE),DISPATCH_TABLE_ENTRY(DOUBLE_TO_LONG),
-            DISPATCH_TABLE_ENTRY(DOUBLE_TO_FLOAT),DISPATCH_TABLE_ENTRY(FLOAT_TO_DOUBLE),DISPATCH_TABLE_ENTRY(OPEN),
-            DISPATCH_TABLE_ENTRY(CLOSE),DISPATCH_TABLE_ENTRY(READ),DISPATCH_TABLE_ENTRY(WRITE),
-            DISPATCH_TABLE_ENTRY(CREATE_FRAME), DISPATCH_TABLE_ENTRY(DESTROY_FRAME), DISPATCH_TABLE_ENTRY(EXIT),
-            DISPATCH_TABLE_ENTRY(EXIT_IMMEDIATE), DISPATCH_TABLE_ENTRY(GET_FIELD_ADDRESS),
-            DISPATCH_TABLE_ENTRY(GET_LOCAL_ADDRESS),DISPATCH_TABLE_ENTRY(GET_PARAMETER_ADDRESS),
-            DISPATCH_TABLE_ENTRY(CREATE_THREAD),DISPATCH_TABLE_ENTRY(THREAD_CONTROL),DISPATCH_TABLE_ENTRY(LOAD_FIELD),
-            DISPATCH_TABLE_ENTRY(STORE_FIELD),DISPATCH_TABLE_ENTRY(LOAD_LOCAL),DISPATCH_TABLE_ENTRY(STORE_LOCAL),
-            DISPATCH_TABLE_ENTRY(LOAD_PARAMETER),DISPATCH_TABLE_ENTRY(STORE_PARAMETER),
-            DISPATCH_TABLE_ENTRY(JUMP_IF_TRUE), DISPATCH_TABLE_ENTRY(JUMP_IF_FALSE),DISPATCH_TABLE_ENTRY(SYSCALL),
-            DISPATCH_TABLE_ENTRY(THREAD_FINISH), DISPATCH_TABLE_ENTRY(NEG_DOUBLE), DISPATCH_TABLE_ENTRY(NEG_FLOAT),
-            DISPATCH_TABLE_ENTRY(ATOMIC_NEG_DOUBLE), DISPATCH_TABLE_ENTRY(ATOMIC_NEG_FLOAT),
-            DISPATCH_TABLE_ENTRY(JUMP_IF),
-            DISPATCH_TABLE_ENTRY(INVOKE_NATIVE)
+            LVM_OPCODE_LIST(DISPATCH_TABLE_ENTRY)
         };
         DISPATCH();
 #endif
@@ -281,44 +423,44 @@ namespace lvm
     TARGET(PUSH_1):
         {
             {
-                const uint8_t reg = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t reg = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 --registers[SP_REGISTER];
-                *reinterpret_cast<uint8_t*>(base + registers[SP_REGISTER]) = registers[reg];
+                *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[SP_REGISTER])) = registers[reg];
             }
             DISPATCH();
         }
     TARGET(PUSH_2):
         {
             {
-                const uint8_t reg = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t reg = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[SP_REGISTER] -= 2;
-                *reinterpret_cast<uint16_t*>(base + registers[SP_REGISTER]) = registers[reg];
+                *reinterpret_cast<uint16_t*>(HOST_ADDRESS(registers[SP_REGISTER])) = registers[reg];
             }
             DISPATCH();
         }
     TARGET(PUSH_4):
         {
             {
-                const uint8_t reg = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t reg = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[SP_REGISTER] -= 4;
-                *reinterpret_cast<uint32_t*>(base + registers[SP_REGISTER]) = registers[reg];
+                *reinterpret_cast<uint32_t*>(HOST_ADDRESS(registers[SP_REGISTER])) = registers[reg];
             }
             DISPATCH();
         }
-    TARGET(PUSH_8):
+    HOT_TARGET(PUSH_8):
         {
             {
-                const uint8_t reg = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t reg = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[SP_REGISTER] -= 8;
-                *reinterpret_cast<uint64_t*>(base + registers[SP_REGISTER]) = registers[reg];
+                *reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[SP_REGISTER])) = registers[reg];
             }
             DISPATCH();
         }
     TARGET(POP_1):
         {
             {
-                const uint8_t reg = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                registers[reg] = *reinterpret_cast<uint8_t*>(base + registers[SP_REGISTER]);
+                const uint8_t reg = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                registers[reg] = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[SP_REGISTER]));
                 ++registers[SP_REGISTER];
             }
             DISPATCH();
@@ -326,8 +468,8 @@ namespace lvm
     TARGET(POP_2):
         {
             {
-                const uint8_t reg = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                registers[reg] = *reinterpret_cast<uint16_t*>(base + registers[SP_REGISTER]);
+                const uint8_t reg = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                registers[reg] = *reinterpret_cast<uint16_t*>(HOST_ADDRESS(registers[SP_REGISTER]));
                 registers[SP_REGISTER] += 2;
             }
             DISPATCH();
@@ -335,99 +477,99 @@ namespace lvm
     TARGET(POP_4):
         {
             {
-                const uint8_t reg = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                registers[reg] = *reinterpret_cast<uint32_t*>(base + registers[SP_REGISTER]);
+                const uint8_t reg = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                registers[reg] = *reinterpret_cast<uint32_t*>(HOST_ADDRESS(registers[SP_REGISTER]));
                 registers[SP_REGISTER] += 4;
             }
             DISPATCH();
         }
-    TARGET(POP_8):
+    HOT_TARGET(POP_8):
         {
             {
-                const uint8_t reg = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                registers[reg] = *reinterpret_cast<uint64_t*>(base + registers[SP_REGISTER]);
+                const uint8_t reg = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                registers[reg] = *reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[SP_REGISTER]));
                 registers[SP_REGISTER] += 8;
             }
             DISPATCH();
         }
-    TARGET(LOAD_1):
+    HOT_TARGET(LOAD_1):
         {
             {
-                const uint8_t address = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                registers[target] = *reinterpret_cast<uint8_t*>(base + registers[address]);
+                const uint8_t address = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                registers[target] = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[address]));
             }
             DISPATCH();
         }
-    TARGET(LOAD_2):
+    HOT_TARGET(LOAD_2):
         {
             {
-                const uint8_t address = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                registers[target] = *reinterpret_cast<uint16_t*>(base + registers[address]);
+                const uint8_t address = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                registers[target] = *reinterpret_cast<uint16_t*>(HOST_ADDRESS(registers[address]));
             }
             DISPATCH();
         }
-    TARGET(LOAD_4):
+    HOT_TARGET(LOAD_4):
         {
             {
-                const uint8_t address = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                registers[target] = *reinterpret_cast<uint32_t*>(base + registers[address]);
+                const uint8_t address = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                registers[target] = *reinterpret_cast<uint32_t*>(HOST_ADDRESS(registers[address]));
             }
             DISPATCH();
         }
-    TARGET(LOAD_8):
+    HOT_TARGET(LOAD_8):
         {
             {
-                const uint8_t address = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                registers[target] = *reinterpret_cast<uint64_t*>(base + registers[address]);
+                const uint8_t address = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                registers[target] = *reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[address]));
             }
             DISPATCH();
         }
-    TARGET(STORE_1):
+    HOT_TARGET(STORE_1):
         {
             {
-                const uint8_t address = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t source = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                *reinterpret_cast<uint8_t*>(base + registers[address]) = registers[source];
+                const uint8_t address = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t source = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[address])) = registers[source];
             }
             DISPATCH();
         }
-    TARGET(STORE_2):
+    HOT_TARGET(STORE_2):
         {
             {
-                const uint8_t address = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t source = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                *reinterpret_cast<uint16_t*>(base + registers[address]) = registers[source];
+                const uint8_t address = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t source = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                *reinterpret_cast<uint16_t*>(HOST_ADDRESS(registers[address])) = registers[source];
             }
             DISPATCH();
         }
-    TARGET(STORE_4):
+    HOT_TARGET(STORE_4):
         {
             {
-                const uint8_t address = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t source = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                *reinterpret_cast<uint32_t*>(base + registers[address]) = registers[source];
+                const uint8_t address = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t source = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                *reinterpret_cast<uint32_t*>(HOST_ADDRESS(registers[address])) = registers[source];
             }
             DISPATCH();
         }
-    TARGET(STORE_8):
+    HOT_TARGET(STORE_8):
         {
             {
-                const uint8_t address = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t source = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                *reinterpret_cast<uint64_t*>(base + registers[address]) = registers[source];
+                const uint8_t address = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t source = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                *reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[address])) = registers[source];
             }
             DISPATCH();
         }
-    TARGET(CMP):
+    HOT_TARGET(CMP):
         {
             {
-                const uint8_t type = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t type = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 auto value1 = static_cast<int64_t>(registers[operand1]);
                 auto value2 = static_cast<int64_t>(registers[operand2]);
                 uint64_t flags = registers[FLAGS_REGISTER];
@@ -491,10 +633,10 @@ namespace lvm
         {
             {
                 memory->lock();
-                const uint8_t type = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                auto value1 = static_cast<int64_t>(*reinterpret_cast<uint64_t*>(base + registers[operand1]));
+                const uint8_t type = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                auto value1 = static_cast<int64_t>(*reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[operand1])));
                 auto value2 = static_cast<int64_t>(registers[operand2]);
                 uint64_t flags = registers[FLAGS_REGISTER];
                 if (type == FLOAT_TYPE)
@@ -555,8 +697,8 @@ namespace lvm
     TARGET(MOV_E):
         {
             {
-                const uint8_t value = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t value = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 if ((registers[FLAGS_REGISTER] & ZERO_MASK) != 0)
                     registers[target] = registers[value];
             }
@@ -565,8 +707,8 @@ namespace lvm
     TARGET(MOV_NE):
         {
             {
-                const uint8_t value = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t value = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 if ((registers[FLAGS_REGISTER] & ZERO_MASK) == 0)
                     registers[target] = registers[value];
             }
@@ -575,8 +717,8 @@ namespace lvm
     TARGET(MOV_L):
         {
             {
-                const uint8_t value = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t value = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 if (const uint64_t flags = registers[FLAGS_REGISTER]; ((flags & ZERO_MASK) == 0)
                     && ((flags & CARRY_MASK) != 0))
                     registers[target] = registers[value];
@@ -586,8 +728,8 @@ namespace lvm
     TARGET(MOV_LE):
         {
             {
-                const uint8_t value = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t value = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 if (const uint64_t flags = registers[FLAGS_REGISTER]; ((flags & ZERO_MASK) != 0)
                     || ((flags & CARRY_MASK) != 0))
                     registers[target] = registers[value];
@@ -597,8 +739,8 @@ namespace lvm
     TARGET(MOV_G):
         {
             {
-                const uint8_t value = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t value = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 if (const uint64_t flags = registers[FLAGS_REGISTER]; ((flags & ZERO_MASK) == 0)
                     && ((flags & CARRY_MASK) == 0))
                     registers[target] = registers[value];
@@ -608,8 +750,8 @@ namespace lvm
     TARGET(MOV_GE):
         {
             {
-                const uint8_t value = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t value = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 if (const uint64_t flags = registers[FLAGS_REGISTER]; ((flags & ZERO_MASK) != 0)
                     || ((flags & CARRY_MASK) == 0))
                     registers[target] = registers[value];
@@ -619,8 +761,8 @@ namespace lvm
     TARGET(MOV_UL):
         {
             {
-                const uint8_t value = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t value = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 if (const uint64_t flags = registers[FLAGS_REGISTER]; ((flags & ZERO_MASK) == 0)
                     && ((flags & UNSIGNED_MASK) != 0))
                     registers[target] = registers[value];
@@ -630,8 +772,8 @@ namespace lvm
     TARGET(MOV_ULE):
         {
             {
-                const uint8_t value = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t value = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 if (const uint64_t flags = registers[FLAGS_REGISTER]; ((flags & ZERO_MASK) != 0)
                     || ((flags & UNSIGNED_MASK) != 0))
                     registers[target] = registers[value];
@@ -641,8 +783,8 @@ namespace lvm
     TARGET(MOV_UG):
         {
             {
-                const uint8_t value = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t value = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 if (const uint64_t flags = registers[FLAGS_REGISTER]; ((flags & ZERO_MASK) == 0)
                     && ((flags & UNSIGNED_MASK) == 0))
                     registers[target] = registers[value];
@@ -652,229 +794,262 @@ namespace lvm
     TARGET(MOV_UGE):
         {
             {
-                const uint8_t value = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t value = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 if (const uint64_t flags = registers[FLAGS_REGISTER]; ((flags & ZERO_MASK) != 0)
                     || ((flags & UNSIGNED_MASK) == 0))
                     registers[target] = registers[value];
             }
             DISPATCH();
         }
-    TARGET(MOV):
+    HOT_TARGET(MOV):
         {
             {
-                const uint8_t source = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t source = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = registers[source];
             }
             DISPATCH();
         }
-    TARGET(MOV_IMMEDIATE1):
+    HOT_TARGET(MOV_IMMEDIATE1):
         {
             {
-                const uint8_t value = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t value = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = value;
             }
             DISPATCH();
         }
-    TARGET(MOV_IMMEDIATE2):
+    HOT_TARGET(MOV_IMMEDIATE2):
         {
             {
-                const uint16_t value = *reinterpret_cast<uint16_t*>(base + registers[PC_REGISTER]);
+                const uint16_t value = *reinterpret_cast<uint16_t*>(HOST_ADDRESS(registers[PC_REGISTER]));
                 registers[PC_REGISTER] += 2;
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = value;
             }
             DISPATCH();
         }
-    TARGET(MOV_IMMEDIATE4):
+    HOT_TARGET(MOV_IMMEDIATE4):
         {
             {
-                const uint32_t value = *reinterpret_cast<uint32_t*>(base + registers[PC_REGISTER]);
+                const uint32_t value = *reinterpret_cast<uint32_t*>(HOST_ADDRESS(registers[PC_REGISTER]));
                 registers[PC_REGISTER] += 4;
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = value;
             }
             DISPATCH();
         }
-    TARGET(MOV_IMMEDIATE8):
+    HOT_TARGET(MOV_IMMEDIATE8):
         {
             {
-                const uint64_t value = *reinterpret_cast<uint64_t*>(base + registers[PC_REGISTER]);
+                const uint64_t value = *reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[PC_REGISTER]));
                 registers[PC_REGISTER] += 8;
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = value;
             }
             DISPATCH();
         }
-    TARGET(JUMP):
+    HOT_TARGET(JUMP):
         {
             {
-                const uint8_t address = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t address = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t next = registers[PC_REGISTER];
                 registers[PC_REGISTER] = registers[address];
+                INDIRECT_BACK_EDGE(next);
             }
             DISPATCH();
         }
-    TARGET(JUMP_IMMEDIATE):
+    HOT_TARGET(JUMP_IMMEDIATE):
         {
             {
-                const uint64_t address = *reinterpret_cast<uint64_t*>(base + registers[PC_REGISTER]);
+                const uint64_t address = *reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[PC_REGISTER]));
+                const uint64_t next = registers[PC_REGISTER] + 8;
                 registers[PC_REGISTER] = address;
+                BACK_EDGE(next);
             }
             DISPATCH();
         }
-    TARGET(JE):
+    HOT_TARGET(JE):
         {
             {
-                const uint8_t address = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t address = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t next = registers[PC_REGISTER];
                 if ((registers[FLAGS_REGISTER] & ZERO_MASK) != 0)
                     registers[PC_REGISTER] = registers[address];
+                BACK_EDGE(next);
             }
             DISPATCH();
         }
-    TARGET(JNE):
+    HOT_TARGET(JNE):
         {
             {
-                const uint8_t address = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t address = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t next = registers[PC_REGISTER];
                 if ((registers[FLAGS_REGISTER] & ZERO_MASK) == 0)
                     registers[PC_REGISTER] = registers[address];
+                BACK_EDGE(next);
             }
             DISPATCH();
         }
-    TARGET(JL):
+    HOT_TARGET(JL):
         {
             {
-                const uint8_t address = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t address = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t next = registers[PC_REGISTER];
                 if (const uint64_t flags = registers[FLAGS_REGISTER]; ((flags & ZERO_MASK) == 0)
                     && ((flags & CARRY_MASK) != 0))
                     registers[PC_REGISTER] = registers[address];
+                BACK_EDGE(next);
             }
             DISPATCH();
         }
-    TARGET(JLE):
+    HOT_TARGET(JLE):
         {
             {
-                const uint8_t address = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t address = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t next = registers[PC_REGISTER];
                 if (const uint64_t flags = registers[FLAGS_REGISTER]; ((flags & ZERO_MASK) != 0)
                     || ((flags & CARRY_MASK) != 0))
                     registers[PC_REGISTER] = registers[address];
+                BACK_EDGE(next);
             }
             DISPATCH();
         }
-    TARGET(JG):
+    HOT_TARGET(JG):
         {
             {
-                const uint8_t address = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t address = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t next = registers[PC_REGISTER];
                 if (const uint64_t flags = registers[FLAGS_REGISTER]; ((flags & ZERO_MASK) == 0)
                     && ((flags & CARRY_MASK) == 0))
                     registers[PC_REGISTER] = registers[address];
+                BACK_EDGE(next);
             }
             DISPATCH();
         }
-    TARGET(JGE):
+    HOT_TARGET(JGE):
         {
             {
-                const uint8_t address = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t address = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t next = registers[PC_REGISTER];
                 if (const uint64_t flags = registers[FLAGS_REGISTER]; ((flags & ZERO_MASK) != 0)
                     || ((flags & CARRY_MASK) == 0))
                     registers[PC_REGISTER] = registers[address];
+                BACK_EDGE(next);
             }
             DISPATCH();
         }
-    TARGET(JUL):
+    HOT_TARGET(JUL):
         {
             {
-                const uint8_t address = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t address = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t next = registers[PC_REGISTER];
                 if (const uint64_t flags = registers[FLAGS_REGISTER]; ((flags & ZERO_MASK) == 0)
                     && ((flags & UNSIGNED_MASK) != 0))
                     registers[PC_REGISTER] = registers[address];
+                BACK_EDGE(next);
             }
             DISPATCH();
         }
-    TARGET(JULE):
+    HOT_TARGET(JULE):
         {
             {
-                const uint8_t address = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t address = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t next = registers[PC_REGISTER];
                 if (const uint64_t flags = registers[FLAGS_REGISTER]; ((flags & ZERO_MASK) != 0)
                     || ((flags & UNSIGNED_MASK) != 0))
                     registers[PC_REGISTER] = registers[address];
+                BACK_EDGE(next);
             }
             DISPATCH();
         }
-    TARGET(JUG):
+    HOT_TARGET(JUG):
         {
             {
-                const uint8_t address = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t address = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t next = registers[PC_REGISTER];
                 if (const uint64_t flags = registers[FLAGS_REGISTER]; ((flags & ZERO_MASK) == 0)
                     && ((flags & UNSIGNED_MASK) == 0))
                     registers[PC_REGISTER] = registers[address];
+                BACK_EDGE(next);
             }
             DISPATCH();
         }
-    TARGET(JUGE):
+    HOT_TARGET(JUGE):
         {
             {
-                const uint8_t address = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t address = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t next = registers[PC_REGISTER];
                 if (const uint64_t flags = registers[FLAGS_REGISTER]; ((flags & ZERO_MASK) != 0)
                     || ((flags & UNSIGNED_MASK) == 0))
                     registers[PC_REGISTER] = registers[address];
+                BACK_EDGE(next);
             }
             DISPATCH();
         }
     TARGET(MALLOC):
         {
             {
-                const uint8_t size = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t size = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                this->inHostCall = true;
                 registers[target] = memory->allocateMemory(threadHandle, registers[size]);
+                this->inHostCall = false;
             }
             DISPATCH();
         }
     TARGET(FREE):
         {
             {
-                const uint8_t ptr = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                memory->freeMemory(threadHandle, registers[ptr]);
+                const uint8_t ptr = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                this->inHostCall = true;
+                const bool freed = memory->freeMemory(threadHandle, registers[ptr]);
+                this->inHostCall = false;
+                if (!freed) this->interrupt(INTERRUPT_PAGE_ERROR);
             }
             DISPATCH();
         }
     TARGET(REALLOC):
         {
             {
-                const uint8_t ptr = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t size = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                registers[target] = memory->reallocateMemory(threadHandle, registers[ptr], registers[size]);
+                const uint8_t ptr = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t size = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                this->inHostCall = true;
+                const bool reallocated = memory->reallocateMemory(threadHandle, registers[ptr], registers[size],
+                                                                  &registers[target]);
+                this->inHostCall = false;
+                if (!reallocated) this->interrupt(INTERRUPT_PAGE_ERROR);
             }
             DISPATCH();
         }
-    TARGET(ADD):
+    HOT_TARGET(ADD):
         {
             {
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = registers[operand1] + registers[operand2];
             }
             DISPATCH();
         }
-    TARGET(SUB):
+    HOT_TARGET(SUB):
         {
             {
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = registers[operand1] - registers[operand2];
             }
             DISPATCH();
         }
-    TARGET(MUL):
+    HOT_TARGET(MUL):
         {
             {
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = registers[operand1] * registers[operand2];
             }
             DISPATCH();
@@ -882,9 +1057,9 @@ namespace lvm
     TARGET(DIV):
         {
             {
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = registers[operand1] / registers[operand2];
             }
             DISPATCH();
@@ -892,39 +1067,39 @@ namespace lvm
     TARGET(MOD):
         {
             {
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = registers[operand1] % registers[operand2];
             }
             DISPATCH();
         }
-    TARGET(AND):
+    HOT_TARGET(AND):
         {
             {
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = registers[operand1] & registers[operand2];
             }
             DISPATCH();
         }
-    TARGET(OR):
+    HOT_TARGET(OR):
         {
             {
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = registers[operand1] | registers[operand2];
             }
             DISPATCH();
         }
-    TARGET(XOR):
+    HOT_TARGET(XOR):
         {
             {
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = registers[operand1] ^ registers[operand2];
             }
             DISPATCH();
@@ -932,8 +1107,8 @@ namespace lvm
     TARGET(NOT):
         {
             {
-                const uint8_t operand = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = ~registers[operand];
             }
             DISPATCH();
@@ -941,86 +1116,86 @@ namespace lvm
     TARGET(NEG):
         {
             {
-                const uint8_t operand = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = static_cast<uint64_t>(-static_cast<int64_t>(registers[operand]));
             }
             DISPATCH();
         }
-    TARGET(SHL):
+    HOT_TARGET(SHL):
         {
             {
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = registers[operand1] << registers[operand2];
             }
             DISPATCH();
         }
-    TARGET(SHR):
+    HOT_TARGET(SHR):
         {
             {
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = static_cast<int64_t>(registers[operand1]) >> registers[operand2];
             }
             DISPATCH();
         }
-    TARGET(USHR):
+    HOT_TARGET(USHR):
         {
             {
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = registers[operand1] >> registers[operand2];
             }
             DISPATCH();
         }
-    TARGET(INC):
+    HOT_TARGET(INC):
         {
             {
-                const uint8_t operand = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 ++registers[operand];
             }
             DISPATCH();
         }
-    TARGET(DEC):
+    HOT_TARGET(DEC):
         {
             {
-                const uint8_t operand = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 --registers[operand];
             }
             DISPATCH();
         }
-    TARGET(ADD_DOUBLE):
+    HOT_TARGET(ADD_DOUBLE):
         {
             {
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = std::bit_cast<uint64_t>(
                     std::bit_cast<double>(registers[operand1]) + std::bit_cast<double>(registers[operand2]));
             }
             DISPATCH();
         }
-    TARGET(SUB_DOUBLE):
+    HOT_TARGET(SUB_DOUBLE):
         {
             {
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = std::bit_cast<uint64_t>(
                     std::bit_cast<double>(registers[operand1]) - std::bit_cast<double>(registers[operand2]));
             }
             DISPATCH();
         }
-    TARGET(MUL_DOUBLE):
+    HOT_TARGET(MUL_DOUBLE):
         {
             {
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = std::bit_cast<uint64_t>(
                     std::bit_cast<double>(registers[operand1]) * std::bit_cast<double>(registers[operand2]));
             }
@@ -1029,9 +1204,9 @@ namespace lvm
     TARGET(DIV_DOUBLE):
         {
             {
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = std::bit_cast<uint64_t>(
                     std::bit_cast<double>(registers[operand1]) / std::bit_cast<double>(registers[operand2]));
             }
@@ -1040,9 +1215,9 @@ namespace lvm
     TARGET(MOD_DOUBLE):
         {
             {
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = std::bit_cast<uint64_t>(std::fmod(
                     std::bit_cast<double>(registers[operand1]), std::bit_cast<double>(registers[operand2])));
             }
@@ -1051,9 +1226,9 @@ namespace lvm
     TARGET(ADD_FLOAT):
         {
             {
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = static_cast<uint64_t>(std::bit_cast<uint32_t>(
                     std::bit_cast<float>(static_cast<uint32_t>(registers[operand1] & 0xffffffffL)) +
                     std::bit_cast<float>(static_cast<uint32_t>(registers[operand2] & 0xffffffffL))));
@@ -1063,9 +1238,9 @@ namespace lvm
     TARGET(SUB_FLOAT):
         {
             {
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = static_cast<uint64_t>(std::bit_cast<uint32_t>(
                     std::bit_cast<float>(static_cast<uint32_t>(registers[operand1] & 0xffffffffL)) -
                     std::bit_cast<float>(static_cast<uint32_t>(registers[operand2] & 0xffffffffL))));
@@ -1075,9 +1250,9 @@ namespace lvm
     TARGET(MUL_FLOAT):
         {
             {
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = static_cast<uint64_t>(std::bit_cast<uint32_t>(
                     std::bit_cast<float>(static_cast<uint32_t>(registers[operand1] & 0xffffffffL)) *
                     std::bit_cast<float>(static_cast<uint32_t>(registers[operand2] & 0xffffffffL))));
@@ -1087,9 +1262,9 @@ namespace lvm
     TARGET(DIV_FLOAT):
         {
             {
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = static_cast<uint64_t>(std::bit_cast<uint32_t>(
                     std::bit_cast<float>(static_cast<uint32_t>(registers[operand1] & 0xffffffffL)) /
                     std::bit_cast<float>(static_cast<uint32_t>(registers[operand2] & 0xffffffffL))));
@@ -1099,9 +1274,9 @@ namespace lvm
     TARGET(MOD_FLOAT):
         {
             {
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = static_cast<uint64_t>(std::bit_cast<uint32_t>(
                     std::fmod(std::bit_cast<float>(static_cast<uint32_t>(registers[operand1] & 0xffffffffL)),
                               std::bit_cast<float>(static_cast<uint32_t>(registers[operand2] & 0xffffffffL)))));
@@ -1112,9 +1287,9 @@ namespace lvm
         {
             {
                 memory->lock();
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = registers[operand1] + registers[operand2];
                 memory->unlock();
             }
@@ -1124,9 +1299,9 @@ namespace lvm
         {
             {
                 memory->lock();
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = registers[operand1] - registers[operand2];
                 memory->unlock();
             }
@@ -1136,9 +1311,9 @@ namespace lvm
         {
             {
                 memory->lock();
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = registers[operand1] * registers[operand2];
                 memory->unlock();
             }
@@ -1148,9 +1323,9 @@ namespace lvm
         {
             {
                 memory->lock();
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = registers[operand1] / registers[operand2];
                 memory->unlock();
             }
@@ -1160,9 +1335,9 @@ namespace lvm
         {
             {
                 memory->lock();
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = registers[operand1] % registers[operand2];
                 memory->unlock();
             }
@@ -1172,9 +1347,9 @@ namespace lvm
         {
             {
                 memory->lock();
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = registers[operand1] & registers[operand2];
                 memory->unlock();
             }
@@ -1184,9 +1359,9 @@ namespace lvm
         {
             {
                 memory->lock();
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = registers[operand1] | registers[operand2];
                 memory->unlock();
             }
@@ -1196,9 +1371,9 @@ namespace lvm
         {
             {
                 memory->lock();
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = registers[operand1] ^ registers[operand2];
                 memory->unlock();
             }
@@ -1208,8 +1383,8 @@ namespace lvm
         {
             {
                 memory->lock();
-                const uint8_t operand = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = ~registers[operand];
                 memory->unlock();
             }
@@ -1219,8 +1394,8 @@ namespace lvm
         {
             {
                 memory->lock();
-                const uint8_t operand = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = static_cast<uint64_t>(-static_cast<int64_t>(registers[operand]));
                 memory->unlock();
             }
@@ -1230,9 +1405,9 @@ namespace lvm
         {
             {
                 memory->lock();
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = registers[operand1] << registers[operand2];
                 memory->unlock();
             }
@@ -1242,9 +1417,9 @@ namespace lvm
         {
             {
                 memory->lock();
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = static_cast<int64_t>(registers[operand1]) >> registers[operand2];
                 memory->unlock();
             }
@@ -1254,9 +1429,9 @@ namespace lvm
         {
             {
                 memory->lock();
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = registers[operand1] >> registers[operand2];
                 memory->unlock();
             }
@@ -1266,10 +1441,10 @@ namespace lvm
         {
             {
                 memory->lock();
-                const uint8_t operand = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 const uint64_t address = registers[operand];
-                const uint64_t tmp = *reinterpret_cast<uint64_t*>(base + address) + 1;
-                *reinterpret_cast<uint64_t*>(base + address) = tmp;
+                const uint64_t tmp = *reinterpret_cast<uint64_t*>(HOST_ADDRESS(address)) + 1;
+                *reinterpret_cast<uint64_t*>(HOST_ADDRESS(address)) = tmp;
                 memory->unlock();
             }
             DISPATCH();
@@ -1278,10 +1453,10 @@ namespace lvm
         {
             {
                 memory->lock();
-                const uint8_t operand = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 const uint64_t address = registers[operand];
-                const uint64_t tmp = *reinterpret_cast<uint64_t*>(base + address) - 1;
-                *reinterpret_cast<uint64_t*>(base + address) = tmp;
+                const uint64_t tmp = *reinterpret_cast<uint64_t*>(HOST_ADDRESS(address)) - 1;
+                *reinterpret_cast<uint64_t*>(HOST_ADDRESS(address)) = tmp;
                 memory->unlock();
             }
             DISPATCH();
@@ -1290,9 +1465,9 @@ namespace lvm
         {
             {
                 memory->lock();
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = std::bit_cast<uint64_t>(
                     std::bit_cast<double>(registers[operand1]) + std::bit_cast<double>(registers[operand2]));
                 memory->unlock();
@@ -1303,9 +1478,9 @@ namespace lvm
         {
             {
                 memory->lock();
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = std::bit_cast<uint64_t>(
                     std::bit_cast<double>(registers[operand1]) - std::bit_cast<double>(registers[operand2]));
                 memory->unlock();
@@ -1316,9 +1491,9 @@ namespace lvm
         {
             {
                 memory->lock();
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = std::bit_cast<uint64_t>(
                     std::bit_cast<double>(registers[operand1]) * std::bit_cast<double>(registers[operand2]));
                 memory->unlock();
@@ -1329,9 +1504,9 @@ namespace lvm
         {
             {
                 memory->lock();
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = std::bit_cast<uint64_t>(
                     std::bit_cast<double>(registers[operand1]) / std::bit_cast<double>(registers[operand2]));
                 memory->unlock();
@@ -1342,9 +1517,9 @@ namespace lvm
         {
             {
                 memory->lock();
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = std::bit_cast<uint64_t>(std::fmod(
                     std::bit_cast<double>(registers[operand1]), std::bit_cast<double>(registers[operand2])));
                 memory->unlock();
@@ -1355,9 +1530,9 @@ namespace lvm
         {
             {
                 memory->lock();
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = static_cast<uint64_t>(std::bit_cast<uint32_t>(
                     std::bit_cast<float>(static_cast<uint32_t>(registers[operand1] & 0xffffffffL)) +
                     std::bit_cast<float>(static_cast<uint32_t>(registers[operand2] & 0xffffffffL))));
@@ -1369,9 +1544,9 @@ namespace lvm
         {
             {
                 memory->lock();
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = static_cast<uint64_t>(std::bit_cast<uint32_t>(
                     std::bit_cast<float>(static_cast<uint32_t>(registers[operand1] & 0xffffffffL)) -
                     std::bit_cast<float>(static_cast<uint32_t>(registers[operand2] & 0xffffffffL))));
@@ -1383,9 +1558,9 @@ namespace lvm
         {
             {
                 memory->lock();
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = static_cast<uint64_t>(std::bit_cast<uint32_t>(
                     std::bit_cast<float>(static_cast<uint32_t>(registers[operand1] & 0xffffffffL)) *
                     std::bit_cast<float>(static_cast<uint32_t>(registers[operand2] & 0xffffffffL))));
@@ -1397,9 +1572,9 @@ namespace lvm
         {
             {
                 memory->lock();
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = static_cast<uint64_t>(std::bit_cast<uint32_t>(
                     std::bit_cast<float>(static_cast<uint32_t>(registers[operand1] & 0xffffffffL)) /
                     std::bit_cast<float>(static_cast<uint32_t>(registers[operand2] & 0xffffffffL))));
@@ -1411,9 +1586,9 @@ namespace lvm
         {
             {
                 memory->lock();
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = static_cast<uint64_t>(std::bit_cast<uint32_t>(
                     std::fmod(std::bit_cast<float>(static_cast<uint32_t>(registers[operand1] & 0xffffffffL)),
                               std::bit_cast<float>(static_cast<uint32_t>(registers[operand2] & 0xffffffffL)))));
@@ -1424,9 +1599,9 @@ namespace lvm
     TARGET(CAS):
         {
             {
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand3 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand3 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 uint64_t value1 = registers[operand1];
                 uint64_t value2 = registers[operand2];
                 uint64_t flags = registers[FLAGS_REGISTER];
@@ -1447,65 +1622,80 @@ namespace lvm
             }
             DISPATCH();
         }
-    TARGET(INVOKE):
+    HOT_TARGET(INVOKE):
         {
             {
-                const uint8_t address = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t address = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t next = registers[PC_REGISTER];
                 registers[SP_REGISTER] -= 8;
-                *reinterpret_cast<uint64_t*>(base + registers[SP_REGISTER]) = registers[
-                    PC_REGISTER];
+                *reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[SP_REGISTER])) = next;
                 registers[PC_REGISTER] = registers[address];
+                PERF_TAG();
+                TRACE(TRACE_BEGIN, registers[PC_REGISTER]);
+                INDIRECT_CALL_EDGE(next);
             }
             DISPATCH();
         }
-    TARGET(INVOKE_IMMEDIATE):
+    HOT_TARGET(INVOKE_IMMEDIATE):
         {
             {
-                const uint64_t address = *reinterpret_cast<uint64_t*>(base + registers[PC_REGISTER]);
+                const uint64_t address = *reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[PC_REGISTER]));
                 registers[SP_REGISTER] -= 8;
-                *reinterpret_cast<uint64_t*>(base + registers[SP_REGISTER]) = (registers[
+                *reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[SP_REGISTER])) = (registers[
                         PC_REGISTER] +
                     8);
                 registers[PC_REGISTER] = address;
+                PERF_TAG();
+                TRACE(TRACE_BEGIN, address);
+                CALL_EDGE();
             }
             DISPATCH();
         }
-    TARGET(RETURN):
+    HOT_TARGET(RETURN):
         {
             {
-                registers[PC_REGISTER] = *reinterpret_cast<uint64_t*>(base + registers[
-                    SP_REGISTER]);
+                registers[PC_REGISTER] = *reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[
+                    SP_REGISTER]));
                 registers[SP_REGISTER] += 8;
+                PERF_TAG();
+                TRACE(TRACE_END, registers[PC_REGISTER]);
             }
             DISPATCH();
         }
-    TARGET(INTERRUPT):
+    COLD_TARGET(INTERRUPT):
         {
             {
-                const uint8_t interruptNumber = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]
-                    ++);
+                const uint8_t interruptNumber = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]
+                    ++));
                 this->interrupt(interruptNumber);
+                PERF_TAG();
             }
             DISPATCH();
         }
-    TARGET(INTERRUPT_RETURN):
+    COLD_TARGET(INTERRUPT_RETURN):
         {
             {
-                registers[PC_REGISTER] = *reinterpret_cast<uint64_t*>(base + registers[
-                    SP_REGISTER]);
+                registers[PC_REGISTER] = *reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[
+                    SP_REGISTER]));
                 registers[SP_REGISTER] += 8;
-                registers[FLAGS_REGISTER] = *reinterpret_cast<uint64_t*>(base + registers[
-                    SP_REGISTER]);
+                registers[FLAGS_REGISTER] = *reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[
+                    SP_REGISTER]));
                 registers[SP_REGISTER] += 8;
+                if (this->disarmedGuard != 0 && registers[SP_REGISTER] >= this->disarmedGuard + memory->pageSize)
+                {
+                    Memory::setNoAccess(HOST_ADDRESS(this->disarmedGuard), memory->pageSize);
+                    this->disarmedGuard = 0;
+                }
+                PERF_TAG();
             }
             DISPATCH();
         }
     TARGET(INT_TYPE_CAST):
         {
             {
-                const uint8_t types = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t source = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t types = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t source = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 const uint8_t type1 = types >> 4;
                 const uint8_t type2 = types & 0x0f;
                 const uint64_t src = registers[source];
@@ -1526,8 +1716,8 @@ namespace lvm
     TARGET(LONG_TO_DOUBLE):
         {
             {
-                const uint8_t source = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t source = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = std::bit_cast<uint64_t>(
                     static_cast<double>(static_cast<int64_t>(registers[source])));
             }
@@ -1536,8 +1726,8 @@ namespace lvm
     TARGET(DOUBLE_TO_LONG):
         {
             {
-                const uint8_t source = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t source = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = std::bit_cast<uint64_t>(
                     static_cast<int64_t>(std::bit_cast<double>(registers[source])));
             }
@@ -1546,8 +1736,8 @@ namespace lvm
     TARGET(DOUBLE_TO_FLOAT):
         {
             {
-                const uint8_t source = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t source = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = std::bit_cast<uint32_t>(
                     static_cast<float>(std::bit_cast<double>(registers[source])));
             }
@@ -1556,137 +1746,160 @@ namespace lvm
     TARGET(FLOAT_TO_DOUBLE):
         {
             {
-                const uint8_t source = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t source = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[target] = std::bit_cast<uint64_t>(
                     static_cast<double>(std::bit_cast<float>(static_cast<uint32_t>(registers[source]))));
             }
             DISPATCH();
         }
-    TARGET(OPEN):
+    COLD_TARGET(OPEN):
         {
             {
-                const uint8_t pathRegister = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t flagsRegister = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]
-                    ++);
-                const uint8_t modeRegister = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t resultRegister = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]
-                    ++);
+                const uint8_t pathRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t flagsRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]
+                    ++));
+                const uint8_t modeRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t resultRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]
+                    ++));
                 uint64_t address = registers[pathRegister];
                 std::string path;
                 char c;
-                while ((c = static_cast<char>(*reinterpret_cast<uint8_t*>(base + address++))) != '\0') path += c;
-                registers[resultRegister] = virtualMachine->open(path.c_str(), flagsRegister, modeRegister);
+                while ((c = static_cast<char>(*reinterpret_cast<uint8_t*>(HOST_ADDRESS(address++)))) != '\0') path += c;
+                registers[resultRegister] = virtualMachine->open(path.c_str(), registers[flagsRegister],
+                                                                 registers[modeRegister]);
             }
             DISPATCH();
         }
-    TARGET(CLOSE):
+    COLD_TARGET(CLOSE):
         {
             {
-                const uint8_t fdRegister = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t resultRegister = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]
-                    ++);
+                const uint8_t fdRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t resultRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]
+                    ++));
                 registers[resultRegister] = virtualMachine->close(registers[fdRegister]);
             }
             DISPATCH();
         }
-    TARGET(READ):
+    COLD_TARGET(READ):
         {
             {
-                const uint8_t fdRegister = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t bufferRegister = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]
-                    ++);
-                const uint8_t countRegister = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]
-                    ++);
-                const uint8_t resultRegister = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]
-                    ++);
+                const uint8_t fdRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t bufferRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]
+                    ++));
+                const uint8_t countRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]
+                    ++));
+                const uint8_t resultRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]
+                    ++));
                 uint64_t bufferAddress = registers[bufferRegister];
                 uint64_t count = registers[countRegister];
+                if (!memory->contains(bufferAddress, count))
+                {
+                    this->interrupt(INTERRUPT_PAGE_ERROR);
+                    DISPATCH();
+                }
                 uint32_t readCount = virtualMachine->read(registers[fdRegister],
-                                                          reinterpret_cast<uint8_t*>(base + bufferAddress), count);
+                                                          reinterpret_cast<uint8_t*>(HOST_ADDRESS(bufferAddress)),
+                                                          count);
                 registers[resultRegister] = readCount;
             }
             DISPATCH();
         }
-    TARGET(WRITE):
+    COLD_TARGET(WRITE):
         {
             {
-                const uint8_t fdRegister = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t bufferRegister = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]
-                    ++);
-                const uint8_t countRegister = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]
-                    ++);
-                const uint8_t resultRegister = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]
-                    ++);
+                const uint8_t fdRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t bufferRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]
+                    ++));
+                const uint8_t countRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]
+                    ++));
+                const uint8_t resultRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]
+                    ++));
                 uint64_t address = registers[bufferRegister];
                 uint64_t count = registers[countRegister];
+                if (!memory->contains(address, count))
+                {
+                    this->interrupt(INTERRUPT_PAGE_ERROR);
+                    DISPATCH();
+                }
                 registers[resultRegister] = virtualMachine->write(registers[fdRegister],
-                                                                  reinterpret_cast<uint8_t*>(base + address),
+                                                                  reinterpret_cast<uint8_t*>(HOST_ADDRESS(address)),
                                                                   count);
             }
             DISPATCH();
         }
-    TARGET(CREATE_FRAME):
+    HOT_TARGET(CREATE_FRAME):
         {
             {
-                const uint64_t size = *reinterpret_cast<uint64_t*>(base + registers[PC_REGISTER]);
+                const uint64_t size = *reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[PC_REGISTER]));
                 registers[PC_REGISTER] += 8;
+                // Smaller frames run into the guard pages, a larger one could step over them into the stack of
+                // another thread and must fit between SP and the bottom of this thread's slot
+                if (size > stackGuardSize) [[unlikely]]
+                {
+                    const uint64_t sp = registers[SP_REGISTER];
+                    if (sp < stackLimit + 8 || size > sp - stackLimit - 8)
+                    {
+                        this->interrupt(INTERRUPT_STACK_OVERFLOW);
+                        DISPATCH();
+                    }
+                }
                 registers[SP_REGISTER] -= 8;
-                *reinterpret_cast<uint64_t*>(base + registers[SP_REGISTER]) = registers[
+                *reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[SP_REGISTER])) = registers[
                     BP_REGISTER];
                 registers[BP_REGISTER] = registers[SP_REGISTER];
                 registers[SP_REGISTER] -= size;
             }
             DISPATCH();
         }
-    TARGET(DESTROY_FRAME):
+    HOT_TARGET(DESTROY_FRAME):
         {
             {
-                const uint64_t size = *reinterpret_cast<uint64_t*>(base + registers[PC_REGISTER]);
+                const uint64_t size = *reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[PC_REGISTER]));
                 registers[PC_REGISTER] += 8;
                 registers[SP_REGISTER] += size;
-                registers[BP_REGISTER] = *reinterpret_cast<uint64_t*>(base + registers[
-                    SP_REGISTER]);
+                registers[BP_REGISTER] = *reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[
+                    SP_REGISTER]));
                 registers[SP_REGISTER] += 8;
             }
             DISPATCH();
         }
-    TARGET(EXIT):
+    COLD_TARGET(EXIT):
         {
             {
-                const uint8_t statusRegister = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]);
+                const uint8_t statusRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]));
                 virtualMachine->exit(registers[statusRegister]);
             }
             goto end;
         }
-    TARGET(EXIT_IMMEDIATE):
+    COLD_TARGET(EXIT_IMMEDIATE):
         {
             {
-                const uint64_t status = *reinterpret_cast<uint64_t*>(base + registers[PC_REGISTER]);
+                const uint64_t status = *reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[PC_REGISTER]));
                 virtualMachine->exit(status);
             }
             goto end;
         }
-    TARGET(GET_FIELD_ADDRESS):
+    HOT_TARGET(GET_FIELD_ADDRESS):
         {
             {
-                const uint8_t objectRegister = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]
-                    ++);
-                const uint64_t offset = *reinterpret_cast<uint64_t*>(base + registers[PC_REGISTER]);
+                const uint8_t objectRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]
+                    ++));
+                const uint64_t offset = *reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[PC_REGISTER]));
                 registers[PC_REGISTER] += 8;
-                const uint8_t targetRegister = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]
-                    ++);
+                const uint8_t targetRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]
+                    ++));
                 registers[targetRegister] = registers[objectRegister] + offset;
             }
             DISPATCH();
         }
-    TARGET(GET_LOCAL_ADDRESS):
+    HOT_TARGET(GET_LOCAL_ADDRESS):
         {
             {
-                const uint64_t offset = *reinterpret_cast<uint64_t*>(base + registers[PC_REGISTER]);
+                const uint64_t offset = *reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[PC_REGISTER]));
                 registers[PC_REGISTER] += 8;
-                const uint8_t targetRegister = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]
-                    ++);
+                const uint8_t targetRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]
+                    ++));
                 registers[targetRegister] = registers[BP_REGISTER] - offset;
             }
             DISPATCH();
@@ -1694,32 +1907,34 @@ namespace lvm
     TARGET(GET_PARAMETER_ADDRESS):
         {
             {
-                const uint64_t offset = *reinterpret_cast<uint64_t*>(base + registers[PC_REGISTER]);
+                const uint64_t offset = *reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[PC_REGISTER]));
                 registers[PC_REGISTER] += 8;
-                const uint8_t targetRegister = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]
-                    ++);
+                const uint8_t targetRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]
+                    ++));
                 registers[targetRegister] = registers[BP_REGISTER] + offset;
             }
             DISPATCH();
         }
-    TARGET(CREATE_THREAD):
+    COLD_TARGET(CREATE_THREAD):
         {
             {
-                const uint8_t entryPointRegister = *reinterpret_cast<uint8_t*>(base + registers[
-                    PC_REGISTER]++);
-                const uint8_t resultRegister = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]
-                    ++);
+                const uint8_t entryPointRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[
+                    PC_REGISTER]++));
+                const uint8_t resultRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]
+                    ++));
+                this->inHostCall = true;
                 registers[resultRegister] = virtualMachine->createThread(
                     threadHandle, registers[entryPointRegister]);
+                this->inHostCall = false;
             }
             DISPATCH();
         }
-    TARGET(THREAD_CONTROL):
+    COLD_TARGET(THREAD_CONTROL):
         {
             {
-                const uint8_t threadIDRegister = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]
-                    ++);
-                const uint8_t command = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t threadIDRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]
+                    ++));
+                const uint8_t command = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 ThreadHandle* handle = virtualMachine->threadID2Handle[registers[threadIDRegister]];
                 switch (command)
                 {
@@ -1733,17 +1948,17 @@ namespace lvm
                     }
                 case TC_GET_REGISTER:
                     {
-                        const uint8_t reg = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                        const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]
-                            ++);
+                        const uint8_t reg = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                        const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]
+                            ++));
                         registers[target] = handle->executionUnit->registers[reg];
                         break;
                     }
                 case TC_SET_REGISTER:
                     {
-                        const uint8_t reg = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                        const uint8_t value = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]
-                            ++);
+                        const uint8_t reg = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                        const uint8_t value = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]
+                            ++));
                         handle->executionUnit->registers[reg] = registers[value];
                         break;
                     }
@@ -1754,32 +1969,32 @@ namespace lvm
             }
             DISPATCH();
         }
-    TARGET(LOAD_FIELD):
+    HOT_TARGET(LOAD_FIELD):
         {
             {
-                const uint8_t size = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t objectRegister = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]
-                    ++);
-                const uint64_t offset = *reinterpret_cast<uint64_t*>(base + registers[PC_REGISTER]);
+                const uint8_t size = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t objectRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]
+                    ++));
+                const uint64_t offset = *reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[PC_REGISTER]));
                 registers[PC_REGISTER] += 8;
-                const uint8_t targetRegister = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]
-                    ++);
+                const uint8_t targetRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]
+                    ++));
                 const uint64_t address = registers[objectRegister] + offset;
                 if (size == 1)
                 {
-                    registers[targetRegister] = *reinterpret_cast<uint8_t*>(base + address) & 0xFF;
+                    registers[targetRegister] = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(address)) & 0xFF;
                 }
                 else if (size == 2)
                 {
-                    registers[targetRegister] = *reinterpret_cast<uint16_t*>(base + address) & 0xFFFF;
+                    registers[targetRegister] = *reinterpret_cast<uint16_t*>(HOST_ADDRESS(address)) & 0xFFFF;
                 }
                 else if (size == 4)
                 {
-                    registers[targetRegister] = *reinterpret_cast<uint32_t*>(base + address) & 0xFFFFFFFFL;
+                    registers[targetRegister] = *reinterpret_cast<uint32_t*>(HOST_ADDRESS(address)) & 0xFFFFFFFFL;
                 }
                 else if (size == 8)
                 {
-                    registers[targetRegister] = *reinterpret_cast<uint64_t*>(base + address);
+                    registers[targetRegister] = *reinterpret_cast<uint64_t*>(HOST_ADDRESS(address));
                 }
                 else
                 {
@@ -1788,33 +2003,33 @@ namespace lvm
             }
             DISPATCH();
         }
-    TARGET(STORE_FIELD):
+    HOT_TARGET(STORE_FIELD):
         {
             {
-                const uint8_t size = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t objectRegister = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]
-                    ++);
-                const uint64_t offset = *reinterpret_cast<uint64_t*>(base + registers[PC_REGISTER]);
+                const uint8_t size = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t objectRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]
+                    ++));
+                const uint64_t offset = *reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[PC_REGISTER]));
                 registers[PC_REGISTER] += 8;
-                const uint8_t valueRegister = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]
-                    ++);
+                const uint8_t valueRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]
+                    ++));
 
                 const uint64_t address = registers[objectRegister] + offset;
                 if (size == 1)
                 {
-                    *reinterpret_cast<uint8_t*>(base + address) = (registers[valueRegister] & 0xFF);
+                    *reinterpret_cast<uint8_t*>(HOST_ADDRESS(address)) = (registers[valueRegister] & 0xFF);
                 }
                 else if (size == 2)
                 {
-                    *reinterpret_cast<uint16_t*>(base + address) = (registers[valueRegister] & 0xFFFF);
+                    *reinterpret_cast<uint16_t*>(HOST_ADDRESS(address)) = (registers[valueRegister] & 0xFFFF);
                 }
                 else if (size == 4)
                 {
-                    *reinterpret_cast<uint32_t*>(base + address) = (registers[valueRegister] & 0xFFFFFFFFL);
+                    *reinterpret_cast<uint32_t*>(HOST_ADDRESS(address)) = (registers[valueRegister] & 0xFFFFFFFFL);
                 }
                 else if (size == 8)
                 {
-                    *reinterpret_cast<uint64_t*>(base + address) = registers[valueRegister];
+                    *reinterpret_cast<uint64_t*>(HOST_ADDRESS(address)) = registers[valueRegister];
                 }
                 else
                 {
@@ -1823,30 +2038,30 @@ namespace lvm
             }
             DISPATCH();
         }
-    TARGET(LOAD_LOCAL):
+    HOT_TARGET(LOAD_LOCAL):
         {
             {
-                const uint8_t size = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint64_t offset = *reinterpret_cast<uint64_t*>(base + registers[PC_REGISTER]);
+                const uint8_t size = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t offset = *reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[PC_REGISTER]));
                 registers[PC_REGISTER] += 8;
-                const uint8_t targetRegister = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]
-                    ++);
+                const uint8_t targetRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]
+                    ++));
                 const uint64_t address = registers[BP_REGISTER] - offset;
                 if (size == 1)
                 {
-                    registers[targetRegister] = *reinterpret_cast<uint8_t*>(base + address) & 0xFF;
+                    registers[targetRegister] = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(address)) & 0xFF;
                 }
                 else if (size == 2)
                 {
-                    registers[targetRegister] = *reinterpret_cast<uint16_t*>(base + address) & 0xFFFF;
+                    registers[targetRegister] = *reinterpret_cast<uint16_t*>(HOST_ADDRESS(address)) & 0xFFFF;
                 }
                 else if (size == 4)
                 {
-                    registers[targetRegister] = *reinterpret_cast<uint32_t*>(base + address) & 0xFFFFFFFFL;
+                    registers[targetRegister] = *reinterpret_cast<uint32_t*>(HOST_ADDRESS(address)) & 0xFFFFFFFFL;
                 }
                 else if (size == 8)
                 {
-                    registers[targetRegister] = *reinterpret_cast<uint64_t*>(base + address);
+                    registers[targetRegister] = *reinterpret_cast<uint64_t*>(HOST_ADDRESS(address));
                 }
                 else
                 {
@@ -1855,30 +2070,30 @@ namespace lvm
             }
             DISPATCH();
         }
-    TARGET(STORE_LOCAL):
+    HOT_TARGET(STORE_LOCAL):
         {
             {
-                const uint8_t size = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint64_t offset = *reinterpret_cast<uint64_t*>(base + registers[PC_REGISTER]);
+                const uint8_t size = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t offset = *reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[PC_REGISTER]));
                 registers[PC_REGISTER] += 8;
-                const uint8_t valueRegister = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]
-                    ++);
+                const uint8_t valueRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]
+                    ++));
                 const uint64_t address = registers[BP_REGISTER] - offset;
                 if (size == 1)
                 {
-                    *reinterpret_cast<uint8_t*>(base + address) = (registers[valueRegister] & 0xFF);
+                    *reinterpret_cast<uint8_t*>(HOST_ADDRESS(address)) = (registers[valueRegister] & 0xFF);
                 }
                 else if (size == 2)
                 {
-                    *reinterpret_cast<uint16_t*>(base + address) = (registers[valueRegister] & 0xFFFF);
+                    *reinterpret_cast<uint16_t*>(HOST_ADDRESS(address)) = (registers[valueRegister] & 0xFFFF);
                 }
                 else if (size == 4)
                 {
-                    *reinterpret_cast<uint32_t*>(base + address) = (registers[valueRegister] & 0xFFFFFFFFL);
+                    *reinterpret_cast<uint32_t*>(HOST_ADDRESS(address)) = (registers[valueRegister] & 0xFFFFFFFFL);
                 }
                 else if (size == 8)
                 {
-                    *reinterpret_cast<uint64_t*>(base + address) = registers[valueRegister];
+                    *reinterpret_cast<uint64_t*>(HOST_ADDRESS(address)) = registers[valueRegister];
                 }
                 else
                 {
@@ -1887,30 +2102,30 @@ namespace lvm
             }
             DISPATCH();
         }
-    TARGET(LOAD_PARAMETER):
+    HOT_TARGET(LOAD_PARAMETER):
         {
             {
-                const uint8_t size = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint64_t offset = *reinterpret_cast<uint64_t*>(base + registers[PC_REGISTER]);
+                const uint8_t size = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t offset = *reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[PC_REGISTER]));
                 registers[PC_REGISTER] += 8;
-                const uint8_t targetRegister = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]
-                    ++);
+                const uint8_t targetRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]
+                    ++));
                 const uint64_t address = registers[BP_REGISTER] + offset;
                 if (size == 1)
                 {
-                    registers[targetRegister] = *reinterpret_cast<uint8_t*>(base + address) & 0xFF;
+                    registers[targetRegister] = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(address)) & 0xFF;
                 }
                 else if (size == 2)
                 {
-                    registers[targetRegister] = *reinterpret_cast<uint16_t*>(base + address) & 0xFFFF;
+                    registers[targetRegister] = *reinterpret_cast<uint16_t*>(HOST_ADDRESS(address)) & 0xFFFF;
                 }
                 else if (size == 4)
                 {
-                    registers[targetRegister] = *reinterpret_cast<uint32_t*>(base + address) & 0xFFFFFFFFL;
+                    registers[targetRegister] = *reinterpret_cast<uint32_t*>(HOST_ADDRESS(address)) & 0xFFFFFFFFL;
                 }
                 else if (size == 8)
                 {
-                    registers[targetRegister] = *reinterpret_cast<uint64_t*>(base + address);
+                    registers[targetRegister] = *reinterpret_cast<uint64_t*>(HOST_ADDRESS(address));
                 }
                 else
                 {
@@ -1919,30 +2134,30 @@ namespace lvm
             }
             DISPATCH();
         }
-    TARGET(STORE_PARAMETER):
+    HOT_TARGET(STORE_PARAMETER):
         {
             {
-                const uint8_t size = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint64_t offset = *reinterpret_cast<uint64_t*>(base + registers[PC_REGISTER]);
+                const uint8_t size = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t offset = *reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[PC_REGISTER]));
                 registers[PC_REGISTER] += 8;
-                const uint8_t valueRegister = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]
-                    ++);
+                const uint8_t valueRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]
+                    ++));
                 const uint64_t address = registers[BP_REGISTER] + offset;
                 if (size == 1)
                 {
-                    *reinterpret_cast<uint8_t*>(base + address) = (registers[valueRegister] & 0xFF);
+                    *reinterpret_cast<uint8_t*>(HOST_ADDRESS(address)) = (registers[valueRegister] & 0xFF);
                 }
                 else if (size == 2)
                 {
-                    *reinterpret_cast<uint16_t*>(base + address) = (registers[valueRegister] & 0xFFFF);
+                    *reinterpret_cast<uint16_t*>(HOST_ADDRESS(address)) = (registers[valueRegister] & 0xFFFF);
                 }
                 else if (size == 4)
                 {
-                    *reinterpret_cast<uint32_t*>(base + address) = (registers[valueRegister] & 0xFFFFFFFFL);
+                    *reinterpret_cast<uint32_t*>(HOST_ADDRESS(address)) = (registers[valueRegister] & 0xFFFFFFFFL);
                 }
                 else if (size == 8)
                 {
-                    *reinterpret_cast<uint64_t*>(base + address) = registers[valueRegister];
+                    *reinterpret_cast<uint64_t*>(HOST_ADDRESS(address)) = registers[valueRegister];
                 }
                 else
                 {
@@ -1951,34 +2166,39 @@ namespace lvm
             }
             DISPATCH();
         }
-    TARGET(JUMP_IF_TRUE):
+    HOT_TARGET(JUMP_IF_TRUE):
         {
             {
-                const uint8_t reg = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t reg = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t next = registers[PC_REGISTER];
                 if (registers[reg] != 0)
                 {
                     registers[PC_REGISTER] = registers[target];
                 }
+                BACK_EDGE(next);
             }
             DISPATCH();
         }
-    TARGET(JUMP_IF_FALSE):
+    HOT_TARGET(JUMP_IF_FALSE):
         {
             {
-                const uint8_t reg = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t reg = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t next = registers[PC_REGISTER];
                 if (registers[reg] == 0)
                 {
                     registers[PC_REGISTER] = registers[target];
                 }
+                BACK_EDGE(next);
             }
             DISPATCH();
         }
-    TARGET(SYSCALL):
+    COLD_TARGET(SYSCALL):
         {
             {
-                const uint8_t syscallRegister = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t syscallRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                this->inHostCall = true;
                 switch (const uint64_t syscallNumber = registers[syscallRegister])
                 {
                 case SYSCALL_TEST:
@@ -1995,22 +2215,39 @@ namespace lvm
                     }
                 case SYSCALL_LOAD_NATIVE_LIBRARY:
                     {
-                        const char* path = reinterpret_cast<char*>(base + registers[1]);
+                        const char* path = reinterpret_cast<char*>(HOST_ADDRESS(registers[1]));
+                        registers[RETURN_VALUE_REGISTER] = loadNativeLibrary(path);
+                        break;
+                    }
+                case SYSCALL_LOAD_NATIVE_LIBRARY_SYMBOL:
+                    {
+                        const char* name = reinterpret_cast<char*>(HOST_ADDRESS(registers[2]));
+                        registers[RETURN_VALUE_REGISTER] = loadNativeSymbol(registers[1], name);
+                        break;
+                    }
+                case SYSCALL_LOAD_DYNAMIC_LIBRARY:
+                    {
+                        const char* path = reinterpret_cast<char*>(HOST_ADDRESS(registers[1]));
+                        std::string error;
+                        registers[RETURN_VALUE_REGISTER] = virtualMachine->linker->load(path, &error);
+                        if (registers[RETURN_VALUE_REGISTER] == LINK_FAILED)
+                            std::cerr << "Failed to load " << path << ": " << error << std::endl;
                         break;
                     }
                 default: ;
                 }
+                this->inHostCall = false;
             }
             DISPATCH();
         }
-    TARGET(THREAD_FINISH):
+    COLD_TARGET(THREAD_FINISH):
         {
             goto end;
         }
     TARGET(NEG_DOUBLE):
         {
             {
-                const uint8_t operand = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[operand] = std::bit_cast<uint64_t>(-std::bit_cast<double>(registers[operand]));
             }
             DISPATCH();
@@ -2018,7 +2255,7 @@ namespace lvm
     TARGET(NEG_FLOAT):
         {
             {
-                const uint8_t operand = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 registers[operand] = std::bit_cast<uint32_t>(
                     -std::bit_cast<float>(static_cast<uint32_t>(registers[operand] & 0xFFFFFFFFL)));
             }
@@ -2028,10 +2265,10 @@ namespace lvm
         {
             {
                 memory->lock();
-                const uint8_t operand = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 const uint64_t address = registers[operand];
-                const double tmp = -*reinterpret_cast<double*>(base + address);
-                *reinterpret_cast<double*>(base + address) = tmp;
+                const double tmp = -*reinterpret_cast<double*>(HOST_ADDRESS(address));
+                *reinterpret_cast<double*>(HOST_ADDRESS(address)) = tmp;
                 memory->unlock();
             }
             DISPATCH();
@@ -2040,22 +2277,23 @@ namespace lvm
         {
             {
                 memory->lock();
-                const uint8_t operand = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t operand = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
                 const uint64_t address = registers[operand];
-                const float tmp = -*reinterpret_cast<float*>(base + address);
-                *reinterpret_cast<float*>(base + address) = tmp;
+                const float tmp = -*reinterpret_cast<float*>(HOST_ADDRESS(address));
+                *reinterpret_cast<float*>(HOST_ADDRESS(address)) = tmp;
                 memory->unlock();
             }
             DISPATCH();
         }
-    TARGET(JUMP_IF):
+    HOT_TARGET(JUMP_IF):
         {
             {
-                const uint8_t type = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t condition = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                const uint8_t target = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+                const uint8_t type = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t condition = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand1 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t operand2 = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t target = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t next = registers[PC_REGISTER];
 
                 auto value1 = static_cast<int64_t>(registers[operand1]);
                 auto value2 = static_cast<int64_t>(registers[operand2]);
@@ -2136,15 +2374,305 @@ namespace lvm
                         if (signedLess)
                             registers[PC_REGISTER] = targetAddress;
                 }
+                BACK_EDGE(next);
+            }
+            DISPATCH();
+        }
+    COLD_TARGET(INVOKE_NATIVE):
+        {
+            {
+                const uint8_t function = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t signature = *reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[PC_REGISTER]));
+                registers[PC_REGISTER] += 8;
+                this->inHostCall = true;
+                invokeNative(registers[function], signature, registers, memory);
+                this->inHostCall = false;
+            }
+            DISPATCH();
+        }
+    TARGET(VECTOR_ADD):
+        {
+            {
+                const uint8_t type = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t aRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t bRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t countRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t resultRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t size = getVectorElementSize(type);
+                if (size == 0) throw VMException("Unsupported type");
+                const uint64_t count = registers[countRegister];
+                if (!CONTAINS_ELEMENTS(registers[aRegister], count, size) ||
+                    !CONTAINS_ELEMENTS(registers[bRegister], count, size) ||
+                    !CONTAINS_ELEMENTS(registers[resultRegister], count, size))
+                {
+                    this->interrupt(INTERRUPT_PAGE_ERROR);
+                    DISPATCH();
+                }
+                vectorAdd(type, reinterpret_cast<void*>(HOST_ADDRESS(registers[aRegister])),
+                          reinterpret_cast<void*>(HOST_ADDRESS(registers[bRegister])), count,
+                          reinterpret_cast<void*>(HOST_ADDRESS(registers[resultRegister])));
+            }
+            DISPATCH();
+        }
+    TARGET(VECTOR_MUL):
+        {
+            {
+                const uint8_t type = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t aRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t bRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t countRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t resultRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t size = getVectorElementSize(type);
+                if (size == 0) throw VMException("Unsupported type");
+                const uint64_t count = registers[countRegister];
+                if (!CONTAINS_ELEMENTS(registers[aRegister], count, size) ||
+                    !CONTAINS_ELEMENTS(registers[bRegister], count, size) ||
+                    !CONTAINS_ELEMENTS(registers[resultRegister], count, size))
+                {
+                    this->interrupt(INTERRUPT_PAGE_ERROR);
+                    DISPATCH();
+                }
+                vectorMul(type, reinterpret_cast<void*>(HOST_ADDRESS(registers[aRegister])),
+                          reinterpret_cast<void*>(HOST_ADDRESS(registers[bRegister])), count,
+                          reinterpret_cast<void*>(HOST_ADDRESS(registers[resultRegister])));
+            }
+            DISPATCH();
+        }
+    TARGET(VECTOR_FMA):
+        {
+            {
+                const uint8_t type = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t aRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t bRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t countRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t resultRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t size = getVectorElementSize(type);
+                if (size == 0) throw VMException("Unsupported type");
+                const uint64_t count = registers[countRegister];
+                if (!CONTAINS_ELEMENTS(registers[aRegister], count, size) ||
+                    !CONTAINS_ELEMENTS(registers[bRegister], count, size) ||
+                    !CONTAINS_ELEMENTS(registers[resultRegister], count, size))
+                {
+                    this->interrupt(INTERRUPT_PAGE_ERROR);
+                    DISPATCH();
+                }
+                vectorFma(type, reinterpret_cast<void*>(HOST_ADDRESS(registers[aRegister])),
+                          reinterpret_cast<void*>(HOST_ADDRESS(registers[bRegister])), count,
+                          reinterpret_cast<void*>(HOST_ADDRESS(registers[resultRegister])));
+            }
+            DISPATCH();
+        }
+    TARGET(VECTOR_SUM):
+        {
+            {
+                const uint8_t type = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t aRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t countRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t resultRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t size = getVectorElementSize(type);
+                if (size == 0) throw VMException("Unsupported type");
+                const uint64_t count = registers[countRegister];
+                if (!CONTAINS_ELEMENTS(registers[aRegister], count, size))
+                {
+                    this->interrupt(INTERRUPT_PAGE_ERROR);
+                    DISPATCH();
+                }
+                registers[resultRegister] = vectorSum(type, reinterpret_cast<void*>(HOST_ADDRESS(registers[aRegister])),
+                                                      count);
+            }
+            DISPATCH();
+        }
+    TARGET(VECTOR_MIN):
+        {
+            {
+                const uint8_t type = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t aRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t countRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t resultRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t size = getVectorElementSize(type);
+                if (size == 0) throw VMException("Unsupported type");
+                const uint64_t count = registers[countRegister];
+                if (!CONTAINS_ELEMENTS(registers[aRegister], count, size))
+                {
+                    this->interrupt(INTERRUPT_PAGE_ERROR);
+                    DISPATCH();
+                }
+                registers[resultRegister] = vectorMin(type, reinterpret_cast<void*>(HOST_ADDRESS(registers[aRegister])),
+                                                      count);
+            }
+            DISPATCH();
+        }
+    TARGET(VECTOR_MAX):
+        {
+            {
+                const uint8_t type = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t aRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t countRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t resultRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t size = getVectorElementSize(type);
+                if (size == 0) throw VMException("Unsupported type");
+                const uint64_t count = registers[countRegister];
+                if (!CONTAINS_ELEMENTS(registers[aRegister], count, size))
+                {
+                    this->interrupt(INTERRUPT_PAGE_ERROR);
+                    DISPATCH();
+                }
+                registers[resultRegister] = vectorMax(type, reinterpret_cast<void*>(HOST_ADDRESS(registers[aRegister])),
+                                                      count);
+            }
+            DISPATCH();
+        }
+    TARGET(VECTOR_DOT):
+        {
+            {
+                const uint8_t type = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t aRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t bRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t countRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t resultRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t size = getVectorElementSize(type);
+                if (size == 0) throw VMException("Unsupported type");
+                const uint64_t count = registers[countRegister];
+                if (!CONTAINS_ELEMENTS(registers[aRegister], count, size) ||
+                    !CONTAINS_ELEMENTS(registers[bRegister], count, size))
+                {
+                    this->interrupt(INTERRUPT_PAGE_ERROR);
+                    DISPATCH();
+                }
+                registers[resultRegister] = vectorDot(type, reinterpret_cast<void*>(HOST_ADDRESS(registers[aRegister])),
+                                                      reinterpret_cast<void*>(HOST_ADDRESS(registers[bRegister])),
+                                                      count);
+            }
+            DISPATCH();
+        }
+    TARGET(MEMORY_COPY):
+        {
+            {
+                const uint8_t destinationRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t sourceRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t countRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t count = registers[countRegister];
+                if (!memory->contains(registers[destinationRegister], count) ||
+                    !memory->contains(registers[sourceRegister], count))
+                {
+                    this->interrupt(INTERRUPT_PAGE_ERROR);
+                    DISPATCH();
+                }
+                // Overlapping ranges are copied as if through a temporary buffer
+                memmove(reinterpret_cast<void*>(HOST_ADDRESS(registers[destinationRegister])),
+                        reinterpret_cast<void*>(HOST_ADDRESS(registers[sourceRegister])), count);
+            }
+            DISPATCH();
+        }
+    TARGET(MEMORY_FILL):
+        {
+            {
+                const uint8_t destinationRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t valueRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t countRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t count = registers[countRegister];
+                if (!memory->contains(registers[destinationRegister], count))
+                {
+                    this->interrupt(INTERRUPT_PAGE_ERROR);
+                    DISPATCH();
+                }
+                memset(reinterpret_cast<void*>(HOST_ADDRESS(registers[destinationRegister])),
+                       static_cast<uint8_t>(registers[valueRegister]), count);
+            }
+            DISPATCH();
+        }
+    TARGET(MEMORY_COMPARE):
+        {
+            {
+                const uint8_t aRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t bRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t countRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t resultRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t count = registers[countRegister];
+                if (!memory->contains(registers[aRegister], count) || !memory->contains(registers[bRegister], count))
+                {
+                    this->interrupt(INTERRUPT_PAGE_ERROR);
+                    DISPATCH();
+                }
+                const int result = memcmp(reinterpret_cast<void*>(HOST_ADDRESS(registers[aRegister])),
+                                          reinterpret_cast<void*>(HOST_ADDRESS(registers[bRegister])), count);
+                registers[resultRegister] = static_cast<int64_t>((result > 0) - (result < 0));
+            }
+            DISPATCH();
+        }
+    TARGET(MEMORY_FIND):
+        {
+            {
+                const uint8_t addressRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t valueRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t countRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t resultRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t address = registers[addressRegister];
+                const uint64_t count = registers[countRegister];
+                if (!memory->contains(address, count))
+                {
+                    this->interrupt(INTERRUPT_PAGE_ERROR);
+                    DISPATCH();
+                }
+                const void* found = memchr(reinterpret_cast<void*>(HOST_ADDRESS(address)),
+                                           static_cast<uint8_t>(registers[valueRegister]), count);
+                registers[resultRegister] = found == nullptr
+                                                ? MEMORY_NOT_FOUND
+                                                : address + (reinterpret_cast<uint64_t>(found) - HOST_ADDRESS(address));
+            }
+            DISPATCH();
+        }
+    TARGET(CRC32C):
+        {
+            {
+                const uint8_t addressRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t countRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t crcRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t count = registers[countRegister];
+                if (!memory->contains(registers[addressRegister], count))
+                {
+                    this->interrupt(INTERRUPT_PAGE_ERROR);
+                    DISPATCH();
+                }
+                // The running CRC is both input and output, so a long record can be checksummed piece by piece
+                registers[crcRegister] = crc32c(reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[addressRegister])),
+                                                count, static_cast<uint32_t>(registers[crcRegister]));
             }
             DISPATCH();
         }
-    TARGET(INVOKE_NATIVE):
+    TARGET(WYHASH):
         {
             {
-                // Currently only native function calls with no arguments and no return values are supported
-                uint8_t ptr = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
-                reinterpret_cast<void(*)()>(registers[ptr])();
+                const uint8_t addressRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t countRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t seedRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t resultRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t count = registers[countRegister];
+                if (!memory->contains(registers[addressRegister], count))
+                {
+                    this->interrupt(INTERRUPT_PAGE_ERROR);
+                    DISPATCH();
+                }
+                registers[resultRegister] = wyhash(reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[addressRegister])),
+                                                   count, registers[seedRegister]);
+            }
+            DISPATCH();
+        }
+    TARGET(SHA256):
+        {
+            {
+                const uint8_t addressRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t countRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint8_t digestRegister = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+                const uint64_t count = registers[countRegister];
+                if (!memory->contains(registers[addressRegister], count) ||
+                    !memory->contains(registers[digestRegister], SHA256_DIGEST_LENGTH))
+                {
+                    this->interrupt(INTERRUPT_PAGE_ERROR);
+                    DISPATCH();
+                }
+                sha256(reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[addressRegister])), count,
+                       reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[digestRegister])));
             }
             DISPATCH();
         }
@@ -2153,16 +2681,24 @@ namespace lvm
         std::cout << "Unsupported opcode: " << code << std::endl;
             }
         }
-#else
+#elif defined(LVM_SHARED_DISPATCH_TAIL)
     end_dispatch:
         {
-            const uint8_t code = *reinterpret_cast<uint8_t*>(base + registers[PC_REGISTER]++);
+            CHECK_INSTRUCTION_LENGTH();
+            const uint8_t code = *reinterpret_cast<uint8_t*>(HOST_ADDRESS(registers[PC_REGISTER]++));
+            INSTRUMENT_DISPATCH(code);
+            COUNT_INSTRUCTION();
             goto *dispatchTable[code];
         }
 #endif
 
     end:
         // std::cout << registers[RETURN_VALUE_REGISTER] << std::endl;
+#ifdef LVM_INSTRUMENT_DISPATCH
+        mergeDispatchCounters(dispatchCounters);
+        delete dispatchCounters;
+#endif
+        currentExecutionUnit = nullptr;
         return;
     }
 
@@ -2170,12 +2706,89 @@ namespace lvm
     {
         Memory* memory = this->virtualMachine->memory;
         const auto base = reinterpret_cast<uint64_t>(memory->heap);
+        const uint64_t addressMask = memory->addressMask;
         registers[SP_REGISTER] -= 8;
-        *reinterpret_cast<uint64_t*>(base + registers[SP_REGISTER]) = registers[FLAGS_REGISTER];
+        *reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[SP_REGISTER])) = registers[FLAGS_REGISTER];
         registers[SP_REGISTER] -= 8;
-        *reinterpret_cast<uint64_t*>(base + registers[SP_REGISTER]) = registers[PC_REGISTER];
+        *reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[SP_REGISTER])) = registers[PC_REGISTER];
         const uint64_t idtEntry = registers[IDTR_REGISTER] + interruptNumber * 8;
-        registers[PC_REGISTER] = *reinterpret_cast<uint64_t*>(base + idtEntry);
+        registers[PC_REGISTER] = *reinterpret_cast<uint64_t*>(HOST_ADDRESS(idtEntry));
+    }
+
+#ifdef LVM_CHECK_INSTRUCTION_LENGTH
+    void ExecutionUnit::checkInstructionLength(const uint64_t base, const uint64_t addressMask)
+    {
+        const uint64_t start = this->checkedInstruction;
+        this->checkedInstruction = registers[PC_REGISTER];
+        if (start == ~0ULL) return;
+        const auto* code = reinterpret_cast<const uint8_t*>(HOST_ADDRESS(start));
+        // Branches, and THREAD_CONTROL that may set the thread's own PC, leave PC anywhere
+        if (isBlockEnd(*code) || *code == THREAD_CONTROL) return;
+        const uint64_t next = start + getInstructionLength(code, ~0ULL, 0);
+        if (registers[PC_REGISTER] == next) return;
+        // An interrupt raised by the instruction pushed the address after it
+        if (*reinterpret_cast<uint64_t*>(HOST_ADDRESS(registers[SP_REGISTER])) == next) return;
+        std::cerr << getInstructionName(*code) << " at " << start << " left PC at " << registers[PC_REGISTER]
+            << " instead of " << next << std::endl;
+        abort();
+    }
+#endif
+
+    void ExecutionUnit::onIndirectEdge(Tier* tier, const uint64_t site, const uint64_t base, const uint64_t addressMask)
+    {
+        const uint64_t target = registers[PC_REGISTER];
+        const uint64_t textLength = this->virtualMachine->textLength;
+        if (site < textLength && this->virtualMachine->inlineCacheSlots[site] != 0)
+        {
+            InlineCache& cache = this->inlineCaches[this->virtualMachine->inlineCacheSlots[site] - 1];
+            // Every miss fills one more target until all are filled
+            const uint64_t filled = std::min(cache.misses, INLINE_CACHE_SIZE);
+            uint64_t i = 0;
+            while (i < filled && cache.targets[i] != target) ++i;
+            if (i < filled)
+            {
+                ++cache.hits;
+            }
+            else
+            {
+                ++cache.misses;
+                for (i = INLINE_CACHE_SIZE - 1; i > 0; --i) cache.targets[i] = cache.targets[i - 1];
+                cache.targets[0] = target;
+            }
+        }
+        if (target < textLength) this->countEdge(this->virtualMachine->loopHeaders[target], tier, base, addressMask);
+    }
+
+    void ExecutionUnit::enterIfHot(LoopHeader& header, Tier* tier, const uint64_t base, const uint64_t addressMask)
+    {
+        CompiledCode code = header.code.load(std::memory_order_acquire);
+        if (code == nullptr)
+        {
+            // Every countdown stored is one less than one stored before, so some thread takes the last edge and asks
+            // the tier, rarely two of them
+            code = tier->lookup(registers[PC_REGISTER]);
+            if (code == nullptr)
+            {
+                header.countdown.store(~0ULL, std::memory_order_relaxed);
+                return;
+            }
+            header.code.store(code, std::memory_order_release);
+            header.countdown.store(0, std::memory_order_relaxed);
+        }
+        ++this->virtualMachine->compiledEntries;
+        code(registers, base, addressMask);
+    }
+
+    void ExecutionUnit::countInlineCaches(std::map<uint64_t, std::pair<uint64_t, uint64_t>>& counts) const
+    {
+        if (this->inlineCaches == nullptr) return;
+        const std::vector<uint64_t>& sites = this->virtualMachine->inlineCacheSites;
+        for (uint64_t i = 0; i < sites.size(); ++i)
+        {
+            if (this->inlineCaches[i].hits == 0 && this->inlineCaches[i].misses == 0) continue;
+            counts[sites[i]].first += this->inlineCaches[i].hits;
+            counts[sites[i]].second += this->inlineCaches[i].misses;
+        }
     }
 
     void ExecutionUnit::destroy()
@@ -2183,6 +2796,8 @@ namespace lvm
         std::lock_guard lock(_mutex);
         delete[] registers;
         registers = nullptr;
+        delete[] inlineCaches;
+        inlineCaches = nullptr;
     }
 
 
@@ -2199,9 +2814,9 @@ namespace lvm
         path(std::move(path)), flags(flags),
         mode(mode)
     {
-        if ((this->flags & FH_READ) != 0) this->input = fopen(path.c_str(), "rb");
+        if ((this->flags & FH_READ) != 0) this->input = fopen(this->path.c_str(), "rb");
         else this->input = nullptr;
-        if ((this->flags & FH_WRITE) != 0) this->output = fopen(path.c_str(), "wb");
+        if ((this->flags & FH_WRITE) != 0) this->output = fopen(this->path.c_str(), "wb");
         else this->output = nullptr;
     }
 
@@ -4,13 +4,16 @@
 
 #ifndef VM_H
 #define VM_H
+#include <atomic>
 #include <map>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include "memory.h"
 #include "module.h"
+#include "tier.h"
 
 #ifdef __WIN32
 #include <Windows.h>
@@ -28,7 +31,13 @@ namespace lvm
     constexpr const char* VERSION_STRING = "0.2.1";
     constexpr uint64_t DEFAULT_STACK_SIZE = 4 * 1024 * 1024;
     constexpr uint64_t DEFAULT_MEMORY_SIZE = 1024 * 1024 * 1024;
-    constexpr uint64_t LVM_VERSION = 0;
+    constexpr uint64_t DEFAULT_SCAVENGE_THRESHOLD = 16 * 1024 * 1024;
+    constexpr uint64_t GUARD_REGION_SIZE = 64 * 1024;
+    constexpr uint64_t DEFAULT_STACK_GUARD_SIZE = 64 * 1024;
+    constexpr uint64_t DEFAULT_STACK_AREA_SIZE = 64ULL * 1024 * 1024 * 1024;
+    constexpr uint64_t LVM_VERSION = 1;
+    // Text, rodata, data, bss length and entry point back to back, still accepted by Module::fromRaw
+    constexpr uint64_t LVM_LEGACY_VERSION = 0;
 #if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
     constexpr uint8_t ENDIAN = 0;
 #else
@@ -41,6 +50,9 @@ namespace lvm
     class FileHandle;
     class Memory;
     class FreeMemory;
+    class TraceBuffer;
+    class DebugInfo;
+    class Linker;
 
     inline VirtualMachine* currentVirtualMachine;
     inline thread_local ExecutionUnit* currentExecutionUnit;
@@ -52,20 +64,54 @@ namespace lvm
         Memory* memory;
         std::map<uint64_t, ThreadHandle*> threadID2Handle;
         uint64_t entryPoint = 0;
+        // Symbols and lines of the module, only loaded when a profiling or tracing feature needs them
+        const DebugInfo* debugInfo = nullptr;
+        // Dynamic libraries loaded by SYSCALL_LOAD_DYNAMIC_LIBRARY and the exports they resolve against
+        Linker* linker = nullptr;
+        // Optimized tier hot loops are handed to, owned by the VM; without one no back edges are counted
+        Tier* tier = nullptr;
+        uint64_t osrThreshold = DEFAULT_OSR_THRESHOLD;
+        // Text of the main module, the only code a tier compiles
+        uint64_t textLength = 0;
+        // One per byte of that text, indexed by the address of the loop header or function; run() allocates them when
+        // a tier is set, so that counting an edge is an array access and a decrement
+        LoopHeader* loopHeaders = nullptr;
+        // Addresses of the INVOKE and JUMP through a register in that text, in the order of their inline caches, and
+        // one per byte of the text, the index of the cache at that address plus one or 0; allocated with loopHeaders
+        std::vector<uint64_t> inlineCacheSites;
+        uint32_t* inlineCacheSlots = nullptr;
+        // Times a thread entered compiled code from the interpreter
+        std::atomic<uint64_t> compiledEntries = 0;
+        // Inline cache hits and misses by site of every thread that has been joined
+        std::map<uint64_t, std::pair<uint64_t, uint64_t>> inlineCacheCounts;
+        std::atomic<uint64_t> threadsCreated = 0;
+        // Thread ID and instructions retired of every thread that has been joined
+        std::vector<std::pair<uint64_t, uint64_t>> retiredInstructions;
 
-        VirtualMachine(uint64_t heapSize, uint64_t stackSize);
+        VirtualMachine(uint64_t heapSize, uint64_t stackSize, bool hardened = false,
+                       uint64_t stackAreaSize = DEFAULT_STACK_AREA_SIZE);
         int init(const Module* module);
         void destroy();
+        // Returns at EXIT or once every thread has ended. After an EXIT it joins the thread that exited and every
+        // other thread that has finished; threads still running keep using the VM, see hasRunningThreads()
         int run();
+        // Whether guest threads outlived run(), in which case nothing they use may be freed
+        [[nodiscard]] bool hasRunningThreads() const;
         uint64_t createThread(ThreadHandle* threadHandle, uint64_t entryPoint);
         inline uint64_t open(const char* path, uint32_t flags, uint32_t mode);
         inline uint64_t close(uint64_t fd);
         inline uint32_t read(uint64_t fd, uint8_t* buffer, uint32_t count);
         inline uint32_t write(uint64_t fd, const uint8_t* buffer, uint32_t count);
         void exit(uint64_t status);
+        // Copies retiredInstructions and inlineCacheCounts under the lock threads are joined with; threads still
+        // running are not counted
+        void getJoinedCounts(std::vector<std::pair<uint64_t, uint64_t>>& instructionsRetired,
+                             std::map<uint64_t, std::pair<uint64_t, uint64_t>>& inlineCaches);
 
     private:
         bool running = false;
+        // Thread of the last EXIT
+        ExecutionUnit* exitingUnit = nullptr;
         std::map<uint64_t, FileHandle*> fd2FileHandle;
         uint64_t lastFd = 0;
         uint64_t lastThreadID = 0;
@@ -83,6 +129,8 @@ namespace lvm
         const uint64_t threadID;
         ExecutionUnit* executionUnit;
         std::thread* _thread = nullptr;
+        // Set by the thread itself once execute() has returned, so that joining it cannot block
+        std::atomic<bool> finished = false;
         ThreadHandle(uint64_t threadID, ExecutionUnit* executionUnit);
         ~ThreadHandle();
         void start();
@@ -95,18 +143,54 @@ namespace lvm
     {
     public:
         uint64_t* registers = nullptr;
+        uint64_t stackTop = 0;
+        // Yellow guard page opened up for the guest's stack overflow handler, protected again at INTERRUPT_RETURN
+        uint64_t disarmedGuard = 0;
+        // Host code runs for the guest, in a SYSCALL, INVOKE_NATIVE or the allocator; its faults are never the guest's
+        bool inHostCall = false;
+        // Only counted in builds with LVM_COUNT_INSTRUCTIONS
+        uint64_t instructionsRetired = 0;
+        // Return address of the perf trampoline, retargeted to the current guest function, see PerfMap
+        uint64_t* perfReturnSlot = nullptr;
+        TraceBuffer* traceBuffer = nullptr;
 
         explicit ExecutionUnit(VirtualMachine* virtualMachine);
         void init(uint64_t stackBase, uint64_t entryPoint);
         void setThreadHandle(ThreadHandle* threadHandle);
         void execute();
         void interrupt(uint8_t interruptNumber) const;
+        // Adds the hits and misses of this thread's inline caches to counts, by site
+        void countInlineCaches(std::map<uint64_t, std::pair<uint64_t, uint64_t>>& counts) const;
         void destroy();
 
     private:
         VirtualMachine* virtualMachine;
+        // This thread's caches of the sites in VirtualMachine::inlineCacheSites, only with a tier
+        InlineCache* inlineCaches = nullptr;
         ThreadHandle* threadHandle = nullptr;
+        bool deliveringFault = false;
         std::mutex _mutex;
+#ifdef LVM_CHECK_INSTRUCTION_LENGTH
+        // Address of the instruction dispatched last, ~0 when a fault interrupted it
+        uint64_t checkedInstruction = ~0ULL;
+#endif
+
+        // The same for the INVOKE or JUMP through a register at site, counting the target in its inline cache
+        void onIndirectEdge(Tier* tier, uint64_t site, uint64_t base, uint64_t addressMask);
+        // A back edge or call to registers[PC_REGISTER], whose header is header, was taken; only the last edge of the
+        // countdown and the edges into compiled code leave the dispatch loop
+        void countEdge(LoopHeader& header, Tier* tier, const uint64_t base, const uint64_t addressMask)
+        {
+            const uint64_t countdown = header.countdown.load(std::memory_order_relaxed);
+            if (countdown > 1) [[likely]] header.countdown.store(countdown - 1, std::memory_order_relaxed);
+            else this->enterIfHot(header, tier, base, addressMask);
+        }
+        void enterIfHot(LoopHeader& header, Tier* tier, uint64_t base, uint64_t addressMask);
+#ifdef LVM_CHECK_INSTRUCTION_LENGTH
+        // Stops the process when the instruction dispatched last did not advance PC by the length its operand layout
+        // in LVM_OPCODE_LIST gives, the one lvm-asm, lvm-dis and the tier decode it with
+        void checkInstructionLength(uint64_t base, uint64_t addressMask);
+#endif
     };
 
     class FileHandle
@@ -132,39 +216,95 @@ namespace lvm
 #ifdef __WIN32
     LONG WINAPI pageFaultHandler(PEXCEPTION_POINTERS ExceptionInfo);
 #else
-    inline sigjmp_buf env;
+    inline thread_local sigjmp_buf env;
+    // Fault that cannot be delivered to the guest, the thread is stopped instead
+    constexpr int FATAL_FAULT = 0x100;
     void PageFaultHandler(int sig, siginfo_t* info, void* context);
 #endif
     void InstallPageFaultHandler();
+    // How the interpreter was built to dispatch: "replicated", "shared-tail" or "switch"
+    const char* getDispatchKind();
 
 
     class Memory
     {
     public:
+        static constexpr uint8_t PAGE_RESERVED = 0;
+        static constexpr uint8_t PAGE_COMMITTED = 1;
+        static constexpr uint8_t PAGE_GUARD = 2;
+        static constexpr uint8_t PAGE_YELLOW_GUARD = 3;
+
         FreeMemory* freeMemoryList = nullptr;
         uint64_t heapSize;
+        uint64_t reservedSize;
+        // Hardened heaps reserve a power of two plus a guard region and mask every guest address into it
+        uint64_t addressMask = ~0ULL;
+        uint64_t pageSize;
+        // Stacks live in their own range after the heap, one fixed slot of guard plus stackSize per thread
+        uint64_t stackAreaStart;
+        uint64_t stackAreaSize;
+        uint64_t stackSlotSize;
         void* heap;
 #ifdef  __WIN32
 #else
         void* metadata;
 #endif
+        // Fully free pages are returned to the OS once this many bytes have been freed, 0 disables it
+        uint64_t scavengeThreshold = DEFAULT_SCAVENGE_THRESHOLD;
+        uint64_t usedSize = 0;
+        std::atomic<uint64_t> committedPages = 0;
+        std::atomic<uint64_t> peakCommittedPages = 0;
+        uint64_t releasedPages = 0;
+        std::atomic<uint64_t> pageFaults = 0;
+        uint64_t allocations = 0;
+        uint64_t allocatedBytes = 0;
+        uint64_t frees = 0;
+        uint64_t freedBytes = 0;
 
 
-        explicit Memory(uint64_t heapSize);
-        void init(const uint8_t* text, uint64_t textLength, const uint8_t* rodata, uint64_t rodataLength,
-                  const uint8_t* data, uint64_t dataLength, uint64_t bssLength);
+        explicit Memory(uint64_t heapSize, bool hardened = false, uint64_t stackSize = DEFAULT_STACK_SIZE,
+                        uint64_t stackAreaSize = DEFAULT_STACK_AREA_SIZE);
+        ~Memory();
+        // False if a compressed section of the module turns out to be corrupt
+        bool init(const Module* module);
+        // Unpacks the module to address, a page boundary, with the whole pages of text and rodata read-only
+        bool load(const Module* module, uint64_t address);
+        // End of the read-only part of a module loaded at address
+        [[nodiscard]] uint64_t getReadonlyEnd(const Module* module, uint64_t address) const;
         void lock();
         void unlock();
+        void releaseLocks();
+        [[nodiscard]] bool contains(uint64_t address, uint64_t size) const;
         uint64_t allocateMemory(ThreadHandle* threadHandle, uint64_t size);
-        uint64_t reallocateMemory(ThreadHandle* threadHandle, uint64_t address, uint64_t newSize);
-        void freeMemory(ThreadHandle* threadHandle, uint64_t address);
+        // Both are false, and change nothing, when the header before address does not describe a block in the heap
+        bool reallocateMemory(ThreadHandle* threadHandle, uint64_t address, uint64_t newSize, uint64_t* newAddress);
+        bool freeMemory(ThreadHandle* threadHandle, uint64_t address);
         uint64_t allocateMemoryWithoutHead(ThreadHandle* threadHandle, uint64_t size);
+        uint64_t allocateStack(ThreadHandle* threadHandle);
+        // Size of the guard pages below every stack, at least DEFAULT_STACK_GUARD_SIZE
+        [[nodiscard]] uint64_t getStackGuardSize() const;
+        void freeStack(ThreadHandle* threadHandle, uint64_t stackTop);
+        void scavenge();
+        // Also keeps peakCommittedPages, safe to call from the page fault handler
+        void addCommittedPages(uint64_t pages);
+        [[nodiscard]] uint64_t getCommittedSize() const;
+        [[nodiscard]] uint64_t getReleasedSize() const;
         static bool setReadonly(uint64_t address, uint64_t size);
         static bool setReadwrite(uint64_t address, uint64_t size);
+        static bool setNoAccess(uint64_t address, uint64_t size);
 
     private:
         std::recursive_mutex _mutex;
         std::recursive_mutex _lock;
+        uint64_t freedSinceScavenge = 0;
+
+        bool getBlockSize(uint64_t address, uint64_t* size) const;
+        uint64_t nextStackSlot = 0;
+        std::vector<uint64_t> freeStackSlots;
+
+        void markCommitted(uint64_t address, uint64_t size);
+        void markGuard(uint64_t address, uint64_t size);
+        uint64_t releasePages(uint64_t start, uint64_t end);
     };
 
     class FreeMemory